@@ -0,0 +1,301 @@
+/*
+ * Open loop arrivals. With arrival_process set, requests arrive on their
+ * own schedule, whether or not earlier ones have completed. An arrival
+ * waits in a software queue until an io_u is free to carry it, so with a
+ * slow device the queue grows instead of the arrivals slowing down. The
+ * time each request waits in the queue, and the queue depth it sees, are
+ * added to the job stats.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "fio.h"
+#include "arrival.h"
+#include "lib/rand.h"
+
+#define ARRIVAL_QUEUE_MIN	64
+
+struct arrival {
+	/* queued arrival times, nsec since td->epoch */
+	uint64_t *queue;
+	unsigned int queue_mask;
+	unsigned int head;
+	unsigned int tail;
+
+	/* the next arrival, not yet queued */
+	uint64_t next;
+
+	double mean_nsec;
+
+	/* arrival_trace times in nsec, replayed every trace_period */
+	uint64_t *trace;
+	unsigned int trace_nr;
+	unsigned int trace_idx;
+	uint64_t trace_base;
+	uint64_t trace_period;
+
+	/* when arrival_wait() last looked at the clock */
+	uint64_t now;
+};
+
+static int arrival_load_trace(struct thread_data *td, struct arrival *a)
+{
+	unsigned int alloc = 0;
+	unsigned long long t;
+	uint64_t last, span;
+	char buf[128];
+	FILE *f;
+
+	f = fopen(td->o.arrival_trace, "r");
+	if (!f) {
+		td_verror(td, errno, "arrival_trace open");
+		return 1;
+	}
+
+	while (fgets(buf, sizeof(buf), f)) {
+		if (buf[0] == '#' || buf[0] == '\n')
+			continue;
+		if (sscanf(buf, "%llu", &t) != 1) {
+			log_err("fio: %s: bad arrival time: %s",
+				td->o.arrival_trace, buf);
+			goto err;
+		}
+		if (a->trace_nr && t * 1000 < a->trace[a->trace_nr - 1]) {
+			log_err("fio: %s: arrival times must not decrease\n",
+				td->o.arrival_trace);
+			goto err;
+		}
+		if (a->trace_nr == alloc) {
+			uint64_t *trace;
+
+			alloc = alloc ? alloc * 2 : 1024;
+			trace = realloc(a->trace, alloc * sizeof(uint64_t));
+			if (!trace) {
+				td_verror(td, ENOMEM, "arrival_trace");
+				goto err;
+			}
+			a->trace = trace;
+		}
+		a->trace[a->trace_nr++] = t * 1000;
+	}
+
+	fclose(f);
+
+	if (!a->trace_nr || !a->trace[a->trace_nr - 1]) {
+		log_err("fio: %s: needs arrival times after 0\n",
+			td->o.arrival_trace);
+		return 1;
+	}
+
+	/*
+	 * The next loop starts one mean gap of the trace after its last
+	 * arrival, so the loops join without a doubled or missing arrival.
+	 */
+	last = a->trace[a->trace_nr - 1];
+	span = last - a->trace[0];
+	if (a->trace_nr > 1 && span)
+		a->trace_period = span + span / (a->trace_nr - 1);
+	else
+		a->trace_period = last;
+
+	return 0;
+err:
+	fclose(f);
+	return 1;
+}
+
+static uint64_t arrival_next(struct thread_data *td, struct arrival *a)
+{
+	double gap;
+
+	switch (td->o.arrival_process) {
+	case ARRIVAL_TRACE:
+		if (a->trace_idx == a->trace_nr) {
+			a->trace_base += a->trace_period;
+			a->trace_idx = 0;
+		}
+		return a->trace_base + a->trace[a->trace_idx++];
+	case ARRIVAL_POISSON:
+		/* share the rate state, the two can't be combined */
+		gap = -a->mean_nsec * log(__rand_0_1(&td->poisson_state[0]));
+		break;
+	case ARRIVAL_FIXED:
+	default:
+		gap = a->mean_nsec;
+		break;
+	}
+
+	return a->next + (uint64_t) gap;
+}
+
+static int arrival_push(struct thread_data *td, struct arrival *a, uint64_t t)
+{
+	unsigned int size = a->queue_mask + 1;
+
+	if (a->tail - a->head == size) {
+		uint64_t *queue = malloc(2 * size * sizeof(uint64_t));
+		unsigned int i;
+
+		if (!queue) {
+			td_verror(td, ENOMEM, "arrival queue");
+			return 1;
+		}
+
+		for (i = 0; i < size; i++)
+			queue[i] = a->queue[(a->head + i) & a->queue_mask];
+
+		free(a->queue);
+		a->queue = queue;
+		a->queue_mask = 2 * size - 1;
+		a->head = 0;
+		a->tail = size;
+	}
+
+	a->queue[a->tail++ & a->queue_mask] = t;
+	return 0;
+}
+
+/*
+ * Queue everything that has arrived by 'now'
+ */
+static int arrival_fill(struct thread_data *td, struct arrival *a,
+			uint64_t now)
+{
+	while (a->next <= now) {
+		if (arrival_push(td, a, a->next))
+			return 1;
+		a->next = arrival_next(td, a);
+	}
+
+	return 0;
+}
+
+/*
+ * Start the arrivals over from now, called when td->epoch is reset.
+ */
+void arrival_reset(struct thread_data *td)
+{
+	struct arrival *a = td->arrival;
+
+	if (!a)
+		return;
+
+	a->head = a->tail = 0;
+	a->next = a->trace_base = ntime_since_now(&td->epoch);
+	a->trace_idx = 0;
+	a->next = arrival_next(td, a);
+}
+
+/*
+ * Wait until at least one request is queued, reaping completions in the
+ * meantime. Returns true if the job should stop instead.
+ */
+bool arrival_wait(struct thread_data *td)
+{
+	struct arrival *a = td->arrival;
+
+	for (;;) {
+		uint64_t now, usec;
+
+		now = ntime_since_now(&td->epoch);
+		if (arrival_fill(td, a, now))
+			return true;
+		a->now = now;
+
+		if (a->tail != a->head)
+			return false;
+		if (td->terminate)
+			return true;
+
+		now /= 1000;
+		if (td->o.timeout && now >= td->o.timeout)
+			return true;
+
+		usec = (a->next / 1000) - now + 1;
+		if (td->o.timeout && now + usec > td->o.timeout)
+			usec = td->o.timeout - now;
+
+		/*
+		 * Whatever arrived so far goes out now, and keeps being
+		 * completed while we wait for the next arrival.
+		 */
+		if (td->io_u_queued)
+			td_io_commit(td);
+		if (td->io_u_in_flight) {
+			if (io_u_queued_complete(td, 0) < 0)
+				return true;
+			if (usec > ARRIVAL_POLL_USEC)
+				usec = ARRIVAL_POLL_USEC;
+		}
+
+		usec_sleep(td, usec);
+	}
+}
+
+/*
+ * Hand the oldest queued request to an io_u. Returns its arrival time in
+ * usec since td->epoch.
+ */
+uint64_t arrival_pop(struct thread_data *td)
+{
+	struct arrival *a = td->arrival;
+	unsigned int depth = a->tail - a->head;
+	uint64_t t;
+
+	assert(depth);
+	t = a->queue[a->head++ & a->queue_mask];
+
+	if (td->o.stats && ramp_time_over(td))
+		add_arrival_sample(td, a->now > t ? a->now - t : 0, depth);
+
+	return t / 1000;
+}
+
+int arrival_init(struct thread_data *td)
+{
+	struct arrival *a;
+
+	if (td->o.arrival_process == ARRIVAL_NONE)
+		return 0;
+
+	a = calloc(1, sizeof(*a));
+	if (!a) {
+		td_verror(td, ENOMEM, "arrival");
+		return 1;
+	}
+	td->arrival = a;
+
+	a->queue = malloc(ARRIVAL_QUEUE_MIN * sizeof(uint64_t));
+	if (!a->queue) {
+		td_verror(td, ENOMEM, "arrival queue");
+		arrival_exit(td);
+		return 1;
+	}
+	a->queue_mask = ARRIVAL_QUEUE_MIN - 1;
+	if (td->o.arrival_rate)
+		a->mean_nsec = 1000000000.0 / td->o.arrival_rate;
+
+	if (td->o.arrival_process == ARRIVAL_TRACE &&
+	    arrival_load_trace(td, a)) {
+		arrival_exit(td);
+		return 1;
+	}
+
+	arrival_reset(td);
+	return 0;
+}
+
+void arrival_exit(struct thread_data *td)
+{
+	struct arrival *a = td->arrival;
+
+	if (!a)
+		return;
+
+	free(a->queue);
+	free(a->trace);
+	free(a);
+	td->arrival = NULL;
+}
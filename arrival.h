@@ -0,0 +1,25 @@
+#ifndef FIO_ARRIVAL_H
+#define FIO_ARRIVAL_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+enum {
+	ARRIVAL_NONE = 0,
+	ARRIVAL_FIXED,
+	ARRIVAL_POISSON,
+	ARRIVAL_TRACE,
+};
+
+/* longest sleep between checks for completions while waiting to arrive */
+#define ARRIVAL_POLL_USEC	100
+
+struct thread_data;
+
+extern int arrival_init(struct thread_data *);
+extern void arrival_exit(struct thread_data *);
+extern void arrival_reset(struct thread_data *);
+extern bool arrival_wait(struct thread_data *);
+extern uint64_t arrival_pop(struct thread_data *);
+
+#endif
@@ -46,9 +46,12 @@
 #include "workqueue.h"
 #include "lib/mountcheck.h"
 #include "rate-submit.h"
+#include "verify-workers.h"
+#include "buf_pool.h"
 #include "helper_thread.h"
 #include "pshared.h"
 #include "zone-dist.h"
+#include "arrival.h"
 
 static struct fio_sem *startup_sem;
 static struct flist_head *cgroup_list;
@@ -429,8 +432,13 @@ static int wait_for_completions(struct thread_data *td, struct timespec *time)
 	int min_evts = 0;
 	int ret;
 
+	/*
+	 * Add the new log chunks before reaping more. The pending log has
+	 * room for a full queue worth of samples, so there's no need to
+	 * drain the queue first.
+	 */
 	if (td->flags & TD_F_REGROW_LOGS)
-		return io_u_quiesce(td);
+		regrow_logs(td);
 
 	/*
 	 * if the queue is full, we MUST reap at least 1 event
@@ -621,8 +629,6 @@ static enum fio_q_status io_u_submit(struct thread_data *td, struct io_u *io_u)
 static void do_verify(struct thread_data *td, uint64_t verify_bytes)
 {
 	struct fio_file *f;
-	struct io_u *io_u;
-	int ret, min_events;
 	unsigned int i;
 
 	dprint(FD_VERIFY, "starting loop\n");
@@ -656,6 +662,25 @@ static void do_verify(struct thread_data *td, uint64_t verify_bytes)
 
 	td_set_runstate(td, TD_VERIFYING);
 
+	if (td->vpool)
+		verify_pool_run(td);
+	else
+		do_verify_io(td, verify_bytes);
+
+	td_set_runstate(td, TD_RUNNING);
+
+	dprint(FD_VERIFY, "exiting loop\n");
+}
+
+/*
+ * Issue and check the verify reads. Also run by the verify_workers
+ * threads, on their share of the written blocks.
+ */
+void do_verify_io(struct thread_data *td, uint64_t verify_bytes)
+{
+	struct io_u *io_u;
+	int ret, min_events;
+
 	io_u = NULL;
 	while (!td->terminate) {
 		enum fio_ddir ddir;
@@ -736,6 +761,11 @@ static void do_verify(struct thread_data *td, uint64_t verify_bytes)
 			break;
 		}
 
+		if (verify_journal_skip(td, io_u)) {
+			put_io_u(td, io_u);
+			continue;
+		}
+
 		if (td->o.verify_async)
 			io_u->end_io = verify_io_u_async;
 		else
@@ -773,10 +803,6 @@ reap:
 			ret = io_u_queued_complete(td, min_events);
 	} else
 		cleanup_pending_aio(td);
-
-	td_set_runstate(td, TD_RUNNING);
-
-	dprint(FD_VERIFY, "exiting loop\n");
 }
 
 static bool exceeds_number_ios(struct thread_data *td)
@@ -902,6 +928,7 @@ static void handle_thinktime(struct thread_data *td, enum fio_ddir ddir,
 		return;
 
 	io_u_quiesce(td);
+	td_batch_time_invalidate(td);
 
 	total = 0;
 	if (td->o.thinktime_spin)
@@ -1054,7 +1081,13 @@ static void do_io(struct thread_data *td, uint64_t *bytes_done)
 				break;
 			}
 
-			if (td->o.verify_async)
+			/*
+			 * Blocks missing from a loaded journal are read, but
+			 * can't be verified
+			 */
+			if (verify_journal_skip(td, io_u))
+				io_u->end_io = NULL;
+			else if (td->o.verify_async)
 				io_u->end_io = verify_io_u_async;
 			else
 				io_u->end_io = verify_io_u;
@@ -1067,9 +1100,11 @@ static void do_io(struct thread_data *td, uint64_t *bytes_done)
 		/*
 		 * Always log IO before it's issued, so we know the specific
 		 * order of it. The logged unit will track when the IO has
-		 * completed.
+		 * completed. Zone appends are logged on completion instead,
+		 * as that's when their offset is known.
 		 */
 		if (td_write(td) && io_u->ddir == DDIR_WRITE &&
+		    !(io_u->flags & IO_U_F_ZONE_APPEND) &&
 		    td->o.do_verify &&
 		    td->o.verify != VERIFY_NONE &&
 		    !td->o.experimental_verify)
@@ -1220,7 +1255,7 @@ cleanup:
 	return 1;
 }
 
-static void cleanup_io_u(struct thread_data *td)
+void cleanup_io_u(struct thread_data *td)
 {
 	struct io_u *io_u;
 
@@ -1241,7 +1276,7 @@ static void cleanup_io_u(struct thread_data *td)
 	free_file_completion_logging(td);
 }
 
-static int init_io_u(struct thread_data *td)
+int init_io_u(struct thread_data *td)
 {
 	struct io_u *io_u;
 	int cl_align, i, max_units;
@@ -1591,6 +1626,7 @@ static uint64_t do_dry_run(struct thread_data *td)
 		}
 
 		if (td_write(td) && io_u->ddir == DDIR_WRITE &&
+		    !(io_u->flags & IO_U_F_ZONE_APPEND) &&
 		    td->o.do_verify &&
 		    td->o.verify != VERIFY_NONE &&
 		    !td->o.experimental_verify)
@@ -1642,7 +1678,6 @@ static void *thread_main(void *data)
 
 	INIT_FLIST_HEAD(&td->io_log_list);
 	INIT_FLIST_HEAD(&td->io_hist_list);
-	INIT_FLIST_HEAD(&td->verify_list);
 	INIT_FLIST_HEAD(&td->trim_list);
 	td->io_hist_tree = RB_ROOT;
 
@@ -1651,11 +1686,6 @@ static void *thread_main(void *data)
 		td_verror(td, ret, "mutex_cond_init_pshared");
 		goto err;
 	}
-	ret = cond_init_pshared(&td->verify_cond);
-	if (ret) {
-		td_verror(td, ret, "mutex_cond_pshared");
-		goto err;
-	}
 
 	td_set_runstate(td, TD_INITIALIZED);
 	dprint(FD_MUTEX, "up startup_sem\n");
@@ -1828,8 +1858,23 @@ static void *thread_main(void *data)
 	if (rate_submit_init(td, sk_out))
 		goto err;
 
+	if (buf_pool_init(td, sk_out))
+		goto err;
+
+	if (verify_journal_init(td, sk_out))
+		goto err;
+
+	verify_index_init(td);
+
+	if (verify_pool_init(td, sk_out))
+		goto err;
+
 	set_epoch_time(td, o->log_unix_epoch);
 	fio_getrusage(&td->ru_start);
+
+	/* arrivals are timed from the epoch */
+	if (arrival_init(td))
+		goto err;
 	memcpy(&td->bw_sample_time, &td->epoch, sizeof(td->epoch));
 	memcpy(&td->iops_sample_time, &td->epoch, sizeof(td->epoch));
 	memcpy(&td->ss.prev_time, &td->epoch, sizeof(td->epoch));
@@ -1976,6 +2021,8 @@ static void *thread_main(void *data)
 
 	iolog_compress_exit(td);
 	rate_submit_exit(td);
+	verify_pool_exit(td);
+	buf_pool_exit(td);
 
 	if (o->exec_postrun)
 		exec_string(o, o->exec_postrun, "postrun");
@@ -1992,10 +2039,13 @@ err:
 		verify_async_exit(td);
 
 	close_and_free_files(td);
+	arrival_exit(td);
 	cleanup_io_u(td);
 	close_ioengine(td);
 	cgroup_shutdown(td, cgroup_mnt);
 	verify_free_state(td);
+	verify_journal_exit(td);
+	verify_index_exit(td);
 	td_zone_free_index(td);
 
 	if (fio_option_is_set(o, cpumask)) {
@@ -2197,7 +2247,10 @@ static int fio_verify_load_state(struct thread_data *td)
 	if (!td->o.verify_state)
 		return 0;
 
-	if (is_backend) {
+	/*
+	 * The journal is written by the backend, so it is always local
+	 */
+	if (is_backend && !td->o.verify_state_journal) {
 		void *data;
 
 		ret = fio_server_get_verify_state(td->o.name,
@@ -2212,7 +2265,11 @@ static int fio_verify_load_state(struct thread_data *td)
 					FIO_OS_PATH_SEPARATOR);
 		else
 			strcpy(prefix, "local");
-		ret = verify_load_state(td, prefix);
+
+		if (td->o.verify_state_journal)
+			ret = verify_journal_load(td, prefix);
+		else
+			ret = verify_load_state(td, prefix);
 	}
 
 	return ret;
@@ -0,0 +1,178 @@
+/*
+ * Pool of pre-generated write buffers for refill_buffers
+ *
+ * A helper worker fills a ring of buffers ahead of the job, and writes
+ * copy the next one in the ring into their io_u buffer instead of
+ * generating the data on the submission path. The ring is filled and
+ * consumed in order, so the job writes the same data it would write
+ * without the pool.
+ */
+#include "fio.h"
+#include "buf_pool.h"
+
+struct buf_pool_slot {
+	struct workqueue_work work;
+	void *buf;
+	bool filled;
+};
+
+struct buf_pool {
+	struct workqueue wq;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool waiting;
+
+	unsigned long long min_write;
+	unsigned long long max_bs;
+
+	void *mem;
+	size_t mem_size;
+	unsigned int head;
+	unsigned int nr_slots;
+	struct buf_pool_slot slots[];
+};
+
+static int buf_pool_work_fn(struct submit_worker *sw,
+			    struct workqueue_work *work)
+{
+	struct buf_pool_slot *slot;
+	struct thread_data *td = sw->wq->td;
+	struct buf_pool *pool = td->buf_pool;
+
+	slot = container_of(work, struct buf_pool_slot, work);
+	fill_io_buffer(td, slot->buf, pool->min_write, pool->max_bs);
+
+	pthread_mutex_lock(&pool->lock);
+	slot->filled = true;
+	if (pool->waiting)
+		pthread_cond_signal(&pool->cond);
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+static struct workqueue_ops buf_pool_wq_ops = {
+	.fn	= buf_pool_work_fn,
+};
+
+/*
+ * Copy the next pre-generated buffer to 'buf', and queue its slot to be
+ * filled again. Waits for the helper if it hasn't caught up.
+ */
+void buf_pool_get(struct thread_data *td, void *buf, unsigned long long len)
+{
+	struct buf_pool *pool = td->buf_pool;
+	struct buf_pool_slot *slot = &pool->slots[pool->head];
+
+	pthread_mutex_lock(&pool->lock);
+	while (!slot->filled) {
+		pool->waiting = true;
+		pthread_cond_wait(&pool->cond, &pool->lock);
+	}
+	pool->waiting = false;
+	slot->filled = false;
+	pthread_mutex_unlock(&pool->lock);
+
+	memcpy(buf, slot->buf, min(len, pool->max_bs));
+
+	workqueue_enqueue(&pool->wq, &slot->work);
+	if (++pool->head == pool->nr_slots)
+		pool->head = 0;
+}
+
+/*
+ * Wait for the helper to go idle and discard everything it generated, so
+ * the caller can safely reseed td->buf_state. Pair with buf_pool_refill().
+ */
+void buf_pool_drain(struct thread_data *td)
+{
+	struct buf_pool *pool = td->buf_pool;
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	workqueue_flush(&pool->wq);
+
+	for (i = 0; i < pool->nr_slots; i++)
+		pool->slots[i].filled = false;
+	pool->head = 0;
+}
+
+/*
+ * Queue every slot to be generated again, from the current buffer seeds.
+ */
+void buf_pool_refill(struct thread_data *td)
+{
+	struct buf_pool *pool = td->buf_pool;
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	for (i = 0; i < pool->nr_slots; i++)
+		workqueue_enqueue(&pool->wq, &pool->slots[i].work);
+}
+
+int buf_pool_init(struct thread_data *td, struct sk_out *sk_out)
+{
+	struct thread_options *o = &td->o;
+	struct buf_pool *pool;
+	unsigned int i;
+
+	if (!o->buffer_pool || !(td->flags & TD_F_REFILL_BUFFERS) ||
+	    !td_write(td) || o->mem_type == MEM_CUDA_MALLOC)
+		return 0;
+
+	pool = calloc(1, sizeof(*pool) +
+			 o->buffer_pool * sizeof(struct buf_pool_slot));
+	if (!pool)
+		goto err;
+
+	pool->min_write = o->min_bs[DDIR_WRITE];
+	pool->max_bs = o->max_bs[DDIR_WRITE];
+	pool->nr_slots = o->buffer_pool;
+	pool->mem_size = pool->max_bs * pool->nr_slots;
+	pool->mem = fio_memalign(page_size, pool->mem_size, false);
+	if (!pool->mem) {
+		free(pool);
+		goto err;
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->cond, NULL);
+
+	if (workqueue_init(td, &pool->wq, &buf_pool_wq_ops, 1, sk_out)) {
+		fio_memfree(pool->mem, pool->mem_size, false);
+		free(pool);
+		goto err;
+	}
+
+	td->buf_pool = pool;
+
+	for (i = 0; i < pool->nr_slots; i++)
+		pool->slots[i].buf = pool->mem + i * pool->max_bs;
+	buf_pool_refill(td);
+
+	dprint(FD_MEM, "buffer pool: %u slots of %llu bytes\n", pool->nr_slots,
+			pool->max_bs);
+	return 0;
+err:
+	log_err("fio: failed to set up buffer pool\n");
+	return 1;
+}
+
+void buf_pool_exit(struct thread_data *td)
+{
+	struct buf_pool *pool = td->buf_pool;
+
+	if (!pool)
+		return;
+
+	workqueue_exit(&pool->wq);
+	pthread_cond_destroy(&pool->cond);
+	pthread_mutex_destroy(&pool->lock);
+	fio_memfree(pool->mem, pool->mem_size, false);
+	free(pool);
+	td->buf_pool = NULL;
+}
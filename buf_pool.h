@@ -0,0 +1,13 @@
+#ifndef FIO_BUF_POOL_H
+#define FIO_BUF_POOL_H
+
+struct thread_data;
+struct sk_out;
+
+int buf_pool_init(struct thread_data *, struct sk_out *);
+void buf_pool_exit(struct thread_data *);
+void buf_pool_drain(struct thread_data *);
+void buf_pool_refill(struct thread_data *);
+void buf_pool_get(struct thread_data *, void *, unsigned long long);
+
+#endif
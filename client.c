@@ -958,10 +958,14 @@ static void convert_ts(struct thread_stat *dst, struct thread_stat *src)
 		convert_io_stat(&dst->clat_stat[i], &src->clat_stat[i]);
 		convert_io_stat(&dst->slat_stat[i], &src->slat_stat[i]);
 		convert_io_stat(&dst->lat_stat[i], &src->lat_stat[i]);
+		convert_io_stat(&dst->co_lat_stat[i], &src->co_lat_stat[i]);
 		convert_io_stat(&dst->bw_stat[i], &src->bw_stat[i]);
 		convert_io_stat(&dst->iops_stat[i], &src->iops_stat[i]);
 	}
 	convert_io_stat(&dst->sync_stat, &src->sync_stat);
+	convert_io_stat(&dst->clock_batch_stat, &src->clock_batch_stat);
+	convert_io_stat(&dst->arrival_wait_stat, &src->arrival_wait_stat);
+	convert_io_stat(&dst->arrival_depth_stat, &src->arrival_depth_stat);
 
 	dst->usr_time		= le64_to_cpu(src->usr_time);
 	dst->sys_time		= le64_to_cpu(src->sys_time);
@@ -971,6 +975,7 @@ static void convert_ts(struct thread_stat *dst, struct thread_stat *src)
 	dst->clat_percentiles	= le32_to_cpu(src->clat_percentiles);
 	dst->lat_percentiles	= le32_to_cpu(src->lat_percentiles);
 	dst->slat_percentiles	= le32_to_cpu(src->slat_percentiles);
+	dst->plat_bits		= le32_to_cpu(src->plat_bits);
 	dst->percentile_precision = le64_to_cpu(src->percentile_precision);
 
 	for (i = 0; i < FIO_IO_U_LIST_MAX_LEN; i++) {
@@ -1061,6 +1066,13 @@ static void convert_ts(struct thread_stat *dst, struct thread_stat *src)
 
 	dst->cachehit		= le64_to_cpu(src->cachehit);
 	dst->cachemiss		= le64_to_cpu(src->cachemiss);
+
+	for (i = 0; i < FIO_LAT_CNT; i++)
+		for (j = 0; j < DDIR_RWDIR_CNT; j++)
+			dst->io_u_plat_groups[i][j] = le32_to_cpu(src->io_u_plat_groups[i][j]);
+	for (i = 0; i < DDIR_RWDIR_CNT; i++)
+		dst->io_u_plat_prio_groups[i] = le32_to_cpu(src->io_u_plat_prio_groups[i]);
+	dst->io_u_sync_plat_groups = le32_to_cpu(src->io_u_sync_plat_groups);
 }
 
 static void convert_gs(struct group_run_stats *dst, struct group_run_stats *src)
@@ -1092,6 +1104,67 @@ static void json_object_add_client_info(struct json_object *obj,
 	json_object_add_value_int(obj, "port", client->port);
 }
 
+/*
+ * Expand a run-length encoded CMD_TS payload, see struct cmd_ts_rle_pdu.
+ * Returns a new command holding the plain cmd_ts_pdu, the passed in
+ * command is freed.
+ */
+static struct fio_net_cmd *decode_ts_cmd(struct fio_net_cmd *cmd)
+{
+	struct cmd_ts_rle_pdu *pdu = (struct cmd_ts_rle_pdu *) cmd->payload;
+	struct fio_net_cmd *ret = NULL;
+	struct cmd_ts_rle_run run;
+	uint8_t *in, *end;
+	uint64_t *dst;
+	size_t size, nr, i, zeroes, words;
+
+	if (cmd->pdu_len < sizeof(*pdu))
+		goto err;
+
+	size = le64_to_cpu(pdu->size);
+	if (size < sizeof(struct cmd_ts_pdu) ||
+	    size / 1024 > FIO_SERVER_MAX_CMD_MB * 1024)
+		goto err;
+
+	nr = (size + 7) / 8;
+	ret = calloc(1, sizeof(*ret) + nr * sizeof(uint64_t));
+	if (!ret)
+		goto err;
+
+	memcpy(ret, cmd, sizeof(*ret));
+	ret->pdu_len = size;
+	dst = (uint64_t *) ret->payload;
+
+	in = pdu->data;
+	end = cmd->payload + cmd->pdu_len;
+	i = 0;
+	while (in < end) {
+		if (end - in < sizeof(run))
+			goto err;
+		memcpy(&run, in, sizeof(run));
+		in += sizeof(run);
+
+		zeroes = le32_to_cpu(run.zeroes);
+		words = le32_to_cpu(run.words);
+		if (i + zeroes + words > nr ||
+		    end - in < words * sizeof(uint64_t))
+			goto err;
+
+		i += zeroes;
+		memcpy(&dst[i], in, words * sizeof(uint64_t));
+		in += words * sizeof(uint64_t);
+		i += words;
+	}
+
+	free(cmd);
+	return ret;
+err:
+	log_err("fio: bad ts pdu\n");
+	free(ret);
+	free(cmd);
+	return NULL;
+}
+
 static void handle_ts(struct fio_client *client, struct fio_net_cmd *cmd)
 {
 	struct cmd_ts_pdu *p = (struct cmd_ts_pdu *) cmd->payload;
@@ -1793,8 +1866,13 @@ int fio_handle_client(struct fio_client *client)
 		break;
 		}
 	case FIO_NET_CMD_TS: {
-		struct cmd_ts_pdu *p = (struct cmd_ts_pdu *) cmd->payload;
+		struct cmd_ts_pdu *p;
+
+		cmd = decode_ts_cmd(cmd);
+		if (!cmd)
+			break;
 
+		p = (struct cmd_ts_pdu *) cmd->payload;
 		dprint(FD_NET, "client: ts->ss_state = %u\n", (unsigned int) le32_to_cpu(p->ts.ss_state));
 		if (le32_to_cpu(p->ts.ss_state) & FIO_SS_DATA) {
 			dprint(FD_NET, "client: received steadystate ring buffers\n");
@@ -0,0 +1,26 @@
+#include <stdbool.h>
+
+#include "hash-mb.h"
+
+unsigned int fio_hash_mb_lanes(void)
+{
+#ifdef CONFIG_HASH_MB
+	static unsigned int lanes;
+	static bool probed;
+
+	if (!probed) {
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx512f"))
+			lanes = 16;
+		else if (__builtin_cpu_supports("avx2"))
+			lanes = 8;
+		else
+			lanes = 1;
+		probed = true;
+	}
+
+	return lanes;
+#else
+	return 1;
+#endif
+}
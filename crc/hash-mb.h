@@ -0,0 +1,24 @@
+#ifndef FIO_HASH_MB_H
+#define FIO_HASH_MB_H
+
+#include <inttypes.h>
+
+/*
+ * Multi-buffer hashing: the md5 and sha256 *_update_mb() helpers hash
+ * several equally sized buffers at once, one buffer per 32-bit vector
+ * lane. fio_hash_mb_lanes() is 16 with AVX-512, 8 with AVX2 and 1 when
+ * the scalar code should be used.
+ */
+#define FIO_HASH_MB_MAX_LANES	16
+
+extern unsigned int fio_hash_mb_lanes(void);
+
+#ifdef CONFIG_HASH_MB
+typedef uint32_t fio_hash_mb_vec8 __attribute__((vector_size(32)));
+typedef uint32_t fio_hash_mb_vec16 __attribute__((vector_size(64)));
+
+#define FIO_HASH_MB_AVX2_FN	__attribute__((target("avx2")))
+#define FIO_HASH_MB_AVX512_FN	__attribute__((target("avx512f")))
+#endif
+
+#endif
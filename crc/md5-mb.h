@@ -0,0 +1,50 @@
+/*
+ * Multi-buffer md5_transform(), included by md5.c once per vector width
+ * with MB_FN, MB_TARGET, MB_VEC and MB_LANES defined. Hashes 'blocks'
+ * consecutive blocks of each of the MB_LANES buffers, one buffer per
+ * vector lane.
+ */
+static MB_TARGET void MB_FN(struct fio_md5_ctx **ctx, const uint8_t **data,
+			    unsigned int blocks)
+{
+	uint32_t block[MD5_BLOCK_WORDS][MB_LANES];
+	MB_VEC h[MD5_HASH_WORDS], in[MD5_BLOCK_WORDS];
+	MB_VEC a, b, c, d;
+	unsigned int i, j, k;
+
+	for (i = 0; i < MD5_HASH_WORDS; i++)
+		for (j = 0; j < MB_LANES; j++)
+			h[i][j] = ctx[j]->hash[i];
+
+	for (k = 0; k < blocks; k++) {
+		for (j = 0; j < MB_LANES; j++) {
+			const uint8_t *p = data[j] + k * MD5_HMAC_BLOCK_SIZE;
+
+			for (i = 0; i < MD5_BLOCK_WORDS; i++)
+				memcpy(&block[i][j], p + i * 4, sizeof(uint32_t));
+		}
+		for (i = 0; i < MD5_BLOCK_WORDS; i++)
+			memcpy(&in[i], block[i], sizeof(in[i]));
+
+		a = h[0];
+		b = h[1];
+		c = h[2];
+		d = h[3];
+
+		MD5_ROUNDS(a, b, c, d, in);
+
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+	}
+
+	for (i = 0; i < MD5_HASH_WORDS; i++)
+		for (j = 0; j < MB_LANES; j++)
+			ctx[j]->hash[i] = h[i][j];
+}
+
+#undef MB_FN
+#undef MB_TARGET
+#undef MB_VEC
+#undef MB_LANES
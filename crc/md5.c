@@ -3,6 +3,77 @@
  */
 #include <string.h>
 #include "md5.h"
+#include "hash-mb.h"
+
+#define MD5_ROUNDS(a, b, c, d, in) do { \
+	MD5STEP(F1, a, b, c, d, in[0] + 0xd76aa478, 7); \
+	MD5STEP(F1, d, a, b, c, in[1] + 0xe8c7b756, 12); \
+	MD5STEP(F1, c, d, a, b, in[2] + 0x242070db, 17); \
+	MD5STEP(F1, b, c, d, a, in[3] + 0xc1bdceee, 22); \
+	MD5STEP(F1, a, b, c, d, in[4] + 0xf57c0faf, 7); \
+	MD5STEP(F1, d, a, b, c, in[5] + 0x4787c62a, 12); \
+	MD5STEP(F1, c, d, a, b, in[6] + 0xa8304613, 17); \
+	MD5STEP(F1, b, c, d, a, in[7] + 0xfd469501, 22); \
+	MD5STEP(F1, a, b, c, d, in[8] + 0x698098d8, 7); \
+	MD5STEP(F1, d, a, b, c, in[9] + 0x8b44f7af, 12); \
+	MD5STEP(F1, c, d, a, b, in[10] + 0xffff5bb1, 17); \
+	MD5STEP(F1, b, c, d, a, in[11] + 0x895cd7be, 22); \
+	MD5STEP(F1, a, b, c, d, in[12] + 0x6b901122, 7); \
+	MD5STEP(F1, d, a, b, c, in[13] + 0xfd987193, 12); \
+	MD5STEP(F1, c, d, a, b, in[14] + 0xa679438e, 17); \
+	MD5STEP(F1, b, c, d, a, in[15] + 0x49b40821, 22); \
+	\
+	MD5STEP(F2, a, b, c, d, in[1] + 0xf61e2562, 5); \
+	MD5STEP(F2, d, a, b, c, in[6] + 0xc040b340, 9); \
+	MD5STEP(F2, c, d, a, b, in[11] + 0x265e5a51, 14); \
+	MD5STEP(F2, b, c, d, a, in[0] + 0xe9b6c7aa, 20); \
+	MD5STEP(F2, a, b, c, d, in[5] + 0xd62f105d, 5); \
+	MD5STEP(F2, d, a, b, c, in[10] + 0x02441453, 9); \
+	MD5STEP(F2, c, d, a, b, in[15] + 0xd8a1e681, 14); \
+	MD5STEP(F2, b, c, d, a, in[4] + 0xe7d3fbc8, 20); \
+	MD5STEP(F2, a, b, c, d, in[9] + 0x21e1cde6, 5); \
+	MD5STEP(F2, d, a, b, c, in[14] + 0xc33707d6, 9); \
+	MD5STEP(F2, c, d, a, b, in[3] + 0xf4d50d87, 14); \
+	MD5STEP(F2, b, c, d, a, in[8] + 0x455a14ed, 20); \
+	MD5STEP(F2, a, b, c, d, in[13] + 0xa9e3e905, 5); \
+	MD5STEP(F2, d, a, b, c, in[2] + 0xfcefa3f8, 9); \
+	MD5STEP(F2, c, d, a, b, in[7] + 0x676f02d9, 14); \
+	MD5STEP(F2, b, c, d, a, in[12] + 0x8d2a4c8a, 20); \
+	\
+	MD5STEP(F3, a, b, c, d, in[5] + 0xfffa3942, 4); \
+	MD5STEP(F3, d, a, b, c, in[8] + 0x8771f681, 11); \
+	MD5STEP(F3, c, d, a, b, in[11] + 0x6d9d6122, 16); \
+	MD5STEP(F3, b, c, d, a, in[14] + 0xfde5380c, 23); \
+	MD5STEP(F3, a, b, c, d, in[1] + 0xa4beea44, 4); \
+	MD5STEP(F3, d, a, b, c, in[4] + 0x4bdecfa9, 11); \
+	MD5STEP(F3, c, d, a, b, in[7] + 0xf6bb4b60, 16); \
+	MD5STEP(F3, b, c, d, a, in[10] + 0xbebfbc70, 23); \
+	MD5STEP(F3, a, b, c, d, in[13] + 0x289b7ec6, 4); \
+	MD5STEP(F3, d, a, b, c, in[0] + 0xeaa127fa, 11); \
+	MD5STEP(F3, c, d, a, b, in[3] + 0xd4ef3085, 16); \
+	MD5STEP(F3, b, c, d, a, in[6] + 0x04881d05, 23); \
+	MD5STEP(F3, a, b, c, d, in[9] + 0xd9d4d039, 4); \
+	MD5STEP(F3, d, a, b, c, in[12] + 0xe6db99e5, 11); \
+	MD5STEP(F3, c, d, a, b, in[15] + 0x1fa27cf8, 16); \
+	MD5STEP(F3, b, c, d, a, in[2] + 0xc4ac5665, 23); \
+	\
+	MD5STEP(F4, a, b, c, d, in[0] + 0xf4292244, 6); \
+	MD5STEP(F4, d, a, b, c, in[7] + 0x432aff97, 10); \
+	MD5STEP(F4, c, d, a, b, in[14] + 0xab9423a7, 15); \
+	MD5STEP(F4, b, c, d, a, in[5] + 0xfc93a039, 21); \
+	MD5STEP(F4, a, b, c, d, in[12] + 0x655b59c3, 6); \
+	MD5STEP(F4, d, a, b, c, in[3] + 0x8f0ccc92, 10); \
+	MD5STEP(F4, c, d, a, b, in[10] + 0xffeff47d, 15); \
+	MD5STEP(F4, b, c, d, a, in[1] + 0x85845dd1, 21); \
+	MD5STEP(F4, a, b, c, d, in[8] + 0x6fa87e4f, 6); \
+	MD5STEP(F4, d, a, b, c, in[15] + 0xfe2ce6e0, 10); \
+	MD5STEP(F4, c, d, a, b, in[6] + 0xa3014314, 15); \
+	MD5STEP(F4, b, c, d, a, in[13] + 0x4e0811a1, 21); \
+	MD5STEP(F4, a, b, c, d, in[4] + 0xf7537e82, 6); \
+	MD5STEP(F4, d, a, b, c, in[11] + 0xbd3af235, 10); \
+	MD5STEP(F4, c, d, a, b, in[2] + 0x2ad7d2bb, 15); \
+	MD5STEP(F4, b, c, d, a, in[9] + 0xeb86d391, 21); \
+} while (0)
 
 static void md5_transform(uint32_t *hash, uint32_t const *in)
 {
@@ -13,73 +84,7 @@ static void md5_transform(uint32_t *hash, uint32_t const *in)
 	c = hash[2];
 	d = hash[3];
 
-	MD5STEP(F1, a, b, c, d, in[0] + 0xd76aa478, 7);
-	MD5STEP(F1, d, a, b, c, in[1] + 0xe8c7b756, 12);
-	MD5STEP(F1, c, d, a, b, in[2] + 0x242070db, 17);
-	MD5STEP(F1, b, c, d, a, in[3] + 0xc1bdceee, 22);
-	MD5STEP(F1, a, b, c, d, in[4] + 0xf57c0faf, 7);
-	MD5STEP(F1, d, a, b, c, in[5] + 0x4787c62a, 12);
-	MD5STEP(F1, c, d, a, b, in[6] + 0xa8304613, 17);
-	MD5STEP(F1, b, c, d, a, in[7] + 0xfd469501, 22);
-	MD5STEP(F1, a, b, c, d, in[8] + 0x698098d8, 7);
-	MD5STEP(F1, d, a, b, c, in[9] + 0x8b44f7af, 12);
-	MD5STEP(F1, c, d, a, b, in[10] + 0xffff5bb1, 17);
-	MD5STEP(F1, b, c, d, a, in[11] + 0x895cd7be, 22);
-	MD5STEP(F1, a, b, c, d, in[12] + 0x6b901122, 7);
-	MD5STEP(F1, d, a, b, c, in[13] + 0xfd987193, 12);
-	MD5STEP(F1, c, d, a, b, in[14] + 0xa679438e, 17);
-	MD5STEP(F1, b, c, d, a, in[15] + 0x49b40821, 22);
-
-	MD5STEP(F2, a, b, c, d, in[1] + 0xf61e2562, 5);
-	MD5STEP(F2, d, a, b, c, in[6] + 0xc040b340, 9);
-	MD5STEP(F2, c, d, a, b, in[11] + 0x265e5a51, 14);
-	MD5STEP(F2, b, c, d, a, in[0] + 0xe9b6c7aa, 20);
-	MD5STEP(F2, a, b, c, d, in[5] + 0xd62f105d, 5);
-	MD5STEP(F2, d, a, b, c, in[10] + 0x02441453, 9);
-	MD5STEP(F2, c, d, a, b, in[15] + 0xd8a1e681, 14);
-	MD5STEP(F2, b, c, d, a, in[4] + 0xe7d3fbc8, 20);
-	MD5STEP(F2, a, b, c, d, in[9] + 0x21e1cde6, 5);
-	MD5STEP(F2, d, a, b, c, in[14] + 0xc33707d6, 9);
-	MD5STEP(F2, c, d, a, b, in[3] + 0xf4d50d87, 14);
-	MD5STEP(F2, b, c, d, a, in[8] + 0x455a14ed, 20);
-	MD5STEP(F2, a, b, c, d, in[13] + 0xa9e3e905, 5);
-	MD5STEP(F2, d, a, b, c, in[2] + 0xfcefa3f8, 9);
-	MD5STEP(F2, c, d, a, b, in[7] + 0x676f02d9, 14);
-	MD5STEP(F2, b, c, d, a, in[12] + 0x8d2a4c8a, 20);
-
-	MD5STEP(F3, a, b, c, d, in[5] + 0xfffa3942, 4);
-	MD5STEP(F3, d, a, b, c, in[8] + 0x8771f681, 11);
-	MD5STEP(F3, c, d, a, b, in[11] + 0x6d9d6122, 16);
-	MD5STEP(F3, b, c, d, a, in[14] + 0xfde5380c, 23);
-	MD5STEP(F3, a, b, c, d, in[1] + 0xa4beea44, 4);
-	MD5STEP(F3, d, a, b, c, in[4] + 0x4bdecfa9, 11);
-	MD5STEP(F3, c, d, a, b, in[7] + 0xf6bb4b60, 16);
-	MD5STEP(F3, b, c, d, a, in[10] + 0xbebfbc70, 23);
-	MD5STEP(F3, a, b, c, d, in[13] + 0x289b7ec6, 4);
-	MD5STEP(F3, d, a, b, c, in[0] + 0xeaa127fa, 11);
-	MD5STEP(F3, c, d, a, b, in[3] + 0xd4ef3085, 16);
-	MD5STEP(F3, b, c, d, a, in[6] + 0x04881d05, 23);
-	MD5STEP(F3, a, b, c, d, in[9] + 0xd9d4d039, 4);
-	MD5STEP(F3, d, a, b, c, in[12] + 0xe6db99e5, 11);
-	MD5STEP(F3, c, d, a, b, in[15] + 0x1fa27cf8, 16);
-	MD5STEP(F3, b, c, d, a, in[2] + 0xc4ac5665, 23);
-
-	MD5STEP(F4, a, b, c, d, in[0] + 0xf4292244, 6);
-	MD5STEP(F4, d, a, b, c, in[7] + 0x432aff97, 10);
-	MD5STEP(F4, c, d, a, b, in[14] + 0xab9423a7, 15);
-	MD5STEP(F4, b, c, d, a, in[5] + 0xfc93a039, 21);
-	MD5STEP(F4, a, b, c, d, in[12] + 0x655b59c3, 6);
-	MD5STEP(F4, d, a, b, c, in[3] + 0x8f0ccc92, 10);
-	MD5STEP(F4, c, d, a, b, in[10] + 0xffeff47d, 15);
-	MD5STEP(F4, b, c, d, a, in[1] + 0x85845dd1, 21);
-	MD5STEP(F4, a, b, c, d, in[8] + 0x6fa87e4f, 6);
-	MD5STEP(F4, d, a, b, c, in[15] + 0xfe2ce6e0, 10);
-	MD5STEP(F4, c, d, a, b, in[6] + 0xa3014314, 15);
-	MD5STEP(F4, b, c, d, a, in[13] + 0x4e0811a1, 21);
-	MD5STEP(F4, a, b, c, d, in[4] + 0xf7537e82, 6);
-	MD5STEP(F4, d, a, b, c, in[11] + 0xbd3af235, 10);
-	MD5STEP(F4, c, d, a, b, in[2] + 0x2ad7d2bb, 15);
-	MD5STEP(F4, b, c, d, a, in[9] + 0xeb86d391, 21);
+	MD5_ROUNDS(a, b, c, d, in);
 
 	hash[0] += a;
 	hash[1] += b;
@@ -144,3 +149,87 @@ void fio_md5_final(struct fio_md5_ctx *mctx)
 	mctx->block[15] = mctx->byte_count >> 29;
 	md5_transform(mctx->hash, mctx->block);
 }
+
+#ifdef CONFIG_HASH_MB
+#define MB_FN		md5_mb_avx2
+#define MB_TARGET	FIO_HASH_MB_AVX2_FN
+#define MB_VEC		fio_hash_mb_vec8
+#define MB_LANES	8
+#include "md5-mb.h"
+
+#define MB_FN		md5_mb_avx512
+#define MB_TARGET	FIO_HASH_MB_AVX512_FN
+#define MB_VEC		fio_hash_mb_vec16
+#define MB_LANES	16
+#include "md5-mb.h"
+
+/*
+ * Hash the whole blocks of a group of up to 'lanes' buffers together.
+ * Unused lanes repeat the first buffer into a scratch context.
+ */
+static void md5_mb_group(struct fio_md5_ctx **ctx, const uint8_t **data,
+			 unsigned int nr, unsigned int blocks,
+			 unsigned int lanes)
+{
+	struct fio_md5_ctx *lane_ctx[FIO_HASH_MB_MAX_LANES];
+	const uint8_t *lane_data[FIO_HASH_MB_MAX_LANES];
+	uint32_t scratch_hash[MD5_HASH_WORDS];
+	struct fio_md5_ctx scratch = { .hash = scratch_hash };
+	unsigned int i;
+
+	if (nr < lanes) {
+		memcpy(scratch_hash, ctx[0]->hash, sizeof(scratch_hash));
+		for (i = 0; i < lanes; i++) {
+			lane_ctx[i] = i < nr ? ctx[i] : &scratch;
+			lane_data[i] = i < nr ? data[i] : data[0];
+		}
+		ctx = lane_ctx;
+		data = lane_data;
+	}
+
+	if (lanes == 16)
+		md5_mb_avx512(ctx, data, blocks);
+	else
+		md5_mb_avx2(ctx, data, blocks);
+}
+#endif
+
+/*
+ * Same as calling fio_md5_update() on each of the 'nr' contexts with
+ * 'len' bytes of the matching buffer, but hashes the buffers in parallel
+ * when the CPU allows. The contexts must not hold a partial block, which
+ * is always the case for freshly initialized ones.
+ */
+void fio_md5_update_mb(struct fio_md5_ctx **ctx, const uint8_t **data,
+		       unsigned int len, unsigned int nr)
+{
+	unsigned int i = 0;
+#ifdef CONFIG_HASH_MB
+	unsigned int j, group, blocks = len / MD5_HMAC_BLOCK_SIZE;
+	unsigned int done = blocks * MD5_HMAC_BLOCK_SIZE;
+	unsigned int lanes = fio_hash_mb_lanes();
+
+	for (j = 0; j < nr; j++)
+		if (ctx[j]->byte_count & (MD5_HMAC_BLOCK_SIZE - 1))
+			lanes = 1;
+
+	/*
+	 * A short group costs as much as a full one, don't bother unless
+	 * a good part of the lanes are in use.
+	 */
+	while (lanes > 1 && blocks && nr - i >= lanes / 4) {
+		group = nr - i;
+		if (group > lanes)
+			group = lanes;
+
+		md5_mb_group(&ctx[i], &data[i], group, blocks, lanes);
+		for (j = i; j < i + group; j++) {
+			ctx[j]->byte_count += done;
+			fio_md5_update(ctx[j], data[j] + done, len - done);
+		}
+		i += group;
+	}
+#endif
+	for (; i < nr; i++)
+		fio_md5_update(ctx[i], data[i], len);
+}
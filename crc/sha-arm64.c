@@ -0,0 +1,152 @@
+/*
+ * sha1 and sha256 block functions using the ARMv8 crypto extensions
+ */
+#include "sha-hw.h"
+#include "../os/os.h"
+
+bool sha_arm64_available = false;
+
+#ifdef ARCH_HAVE_CRC_CRYPTO
+
+#include <arm_neon.h>
+
+static bool sha_arm64_probed;
+
+static inline uint32x4_t sha_arm64_load(const uint8_t *p)
+{
+	return vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(p)));
+}
+
+/*
+ * Four sha1 rounds of group 'i' (of 20) using message group m0. The
+ * schedule starts the group two ahead in m2 and finishes the next one
+ * in m1, m3 being the group before m0.
+ */
+#define SHA1_ARM64_ROUND4(i, op, k, m0, m1, m2, m3) do {		\
+	uint32x4_t wk = vaddq_u32(m0, vdupq_n_u32(k));			\
+	uint32_t e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));		\
+									\
+	abcd = op(abcd, e, wk);						\
+	e = e_next;							\
+	if ((i) >= 2 && (i) <= 17)					\
+		m2 = vsha1su0q_u32(m2, m3, m0);				\
+	if ((i) >= 3 && (i) <= 18)					\
+		m1 = vsha1su1q_u32(m1, m0);				\
+} while (0)
+
+void sha1_arm64_blocks(uint32_t *state, const uint8_t *data,
+		       unsigned int blocks)
+{
+	uint32x4_t abcd, abcd_save, m0, m1, m2, m3;
+	uint32_t e, e_save;
+
+	abcd = vld1q_u32(state);
+	e = state[4];
+
+	while (blocks--) {
+		abcd_save = abcd;
+		e_save = e;
+
+		m0 = sha_arm64_load(data);
+		m1 = sha_arm64_load(data + 16);
+		m2 = sha_arm64_load(data + 32);
+		m3 = sha_arm64_load(data + 48);
+
+		SHA1_ARM64_ROUND4(0, vsha1cq_u32, 0x5a827999, m0, m1, m2, m3);
+		SHA1_ARM64_ROUND4(1, vsha1cq_u32, 0x5a827999, m1, m2, m3, m0);
+		SHA1_ARM64_ROUND4(2, vsha1cq_u32, 0x5a827999, m2, m3, m0, m1);
+		SHA1_ARM64_ROUND4(3, vsha1cq_u32, 0x5a827999, m3, m0, m1, m2);
+		SHA1_ARM64_ROUND4(4, vsha1cq_u32, 0x5a827999, m0, m1, m2, m3);
+		SHA1_ARM64_ROUND4(5, vsha1pq_u32, 0x6ed9eba1, m1, m2, m3, m0);
+		SHA1_ARM64_ROUND4(6, vsha1pq_u32, 0x6ed9eba1, m2, m3, m0, m1);
+		SHA1_ARM64_ROUND4(7, vsha1pq_u32, 0x6ed9eba1, m3, m0, m1, m2);
+		SHA1_ARM64_ROUND4(8, vsha1pq_u32, 0x6ed9eba1, m0, m1, m2, m3);
+		SHA1_ARM64_ROUND4(9, vsha1pq_u32, 0x6ed9eba1, m1, m2, m3, m0);
+		SHA1_ARM64_ROUND4(10, vsha1mq_u32, 0x8f1bbcdc, m2, m3, m0, m1);
+		SHA1_ARM64_ROUND4(11, vsha1mq_u32, 0x8f1bbcdc, m3, m0, m1, m2);
+		SHA1_ARM64_ROUND4(12, vsha1mq_u32, 0x8f1bbcdc, m0, m1, m2, m3);
+		SHA1_ARM64_ROUND4(13, vsha1mq_u32, 0x8f1bbcdc, m1, m2, m3, m0);
+		SHA1_ARM64_ROUND4(14, vsha1mq_u32, 0x8f1bbcdc, m2, m3, m0, m1);
+		SHA1_ARM64_ROUND4(15, vsha1pq_u32, 0xca62c1d6, m3, m0, m1, m2);
+		SHA1_ARM64_ROUND4(16, vsha1pq_u32, 0xca62c1d6, m0, m1, m2, m3);
+		SHA1_ARM64_ROUND4(17, vsha1pq_u32, 0xca62c1d6, m1, m2, m3, m0);
+		SHA1_ARM64_ROUND4(18, vsha1pq_u32, 0xca62c1d6, m2, m3, m0, m1);
+		SHA1_ARM64_ROUND4(19, vsha1pq_u32, 0xca62c1d6, m3, m0, m1, m2);
+
+		abcd = vaddq_u32(abcd, abcd_save);
+		e += e_save;
+		data += 64;
+	}
+
+	vst1q_u32(state, abcd);
+	state[4] = e;
+}
+
+/*
+ * Four sha256 rounds of group 'i' (of 16) using message group m0, which
+ * the schedule then turns into the group four ahead.
+ */
+#define SHA256_ARM64_ROUND4(i, m0, m1, m2, m3) do {			\
+	uint32x4_t wk = vaddq_u32(m0, vld1q_u32(&fio_sha256_k[4 * (i)])); \
+	uint32x4_t prev = state0;					\
+									\
+	if ((i) < 12)							\
+		m0 = vsha256su0q_u32(m0, m1);				\
+	state0 = vsha256hq_u32(state0, state1, wk);			\
+	state1 = vsha256h2q_u32(state1, prev, wk);			\
+	if ((i) < 12)							\
+		m0 = vsha256su1q_u32(m0, m2, m3);			\
+} while (0)
+
+void sha256_arm64_blocks(uint32_t *state, const uint8_t *data,
+			 unsigned int blocks)
+{
+	uint32x4_t state0, state1, save0, save1, m0, m1, m2, m3;
+
+	state0 = vld1q_u32(state);
+	state1 = vld1q_u32(&state[4]);
+
+	while (blocks--) {
+		save0 = state0;
+		save1 = state1;
+
+		m0 = sha_arm64_load(data);
+		m1 = sha_arm64_load(data + 16);
+		m2 = sha_arm64_load(data + 32);
+		m3 = sha_arm64_load(data + 48);
+
+		SHA256_ARM64_ROUND4(0, m0, m1, m2, m3);
+		SHA256_ARM64_ROUND4(1, m1, m2, m3, m0);
+		SHA256_ARM64_ROUND4(2, m2, m3, m0, m1);
+		SHA256_ARM64_ROUND4(3, m3, m0, m1, m2);
+		SHA256_ARM64_ROUND4(4, m0, m1, m2, m3);
+		SHA256_ARM64_ROUND4(5, m1, m2, m3, m0);
+		SHA256_ARM64_ROUND4(6, m2, m3, m0, m1);
+		SHA256_ARM64_ROUND4(7, m3, m0, m1, m2);
+		SHA256_ARM64_ROUND4(8, m0, m1, m2, m3);
+		SHA256_ARM64_ROUND4(9, m1, m2, m3, m0);
+		SHA256_ARM64_ROUND4(10, m2, m3, m0, m1);
+		SHA256_ARM64_ROUND4(11, m3, m0, m1, m2);
+		SHA256_ARM64_ROUND4(12, m0, m1, m2, m3);
+		SHA256_ARM64_ROUND4(13, m1, m2, m3, m0);
+		SHA256_ARM64_ROUND4(14, m2, m3, m0, m1);
+		SHA256_ARM64_ROUND4(15, m3, m0, m1, m2);
+
+		state0 = vaddq_u32(state0, save0);
+		state1 = vaddq_u32(state1, save1);
+		data += 64;
+	}
+
+	vst1q_u32(state, state0);
+	vst1q_u32(&state[4], state1);
+}
+
+void sha_arm64_probe(void)
+{
+	if (!sha_arm64_probed) {
+		sha_arm64_available = os_cpu_has(CPU_ARM64_SHA);
+		sha_arm64_probed = true;
+	}
+}
+
+#endif /* ARCH_HAVE_CRC_CRYPTO */
@@ -0,0 +1,53 @@
+#ifndef FIO_SHA_HW_H
+#define FIO_SHA_HW_H
+
+#include <inttypes.h>
+
+#include "../arch/arch.h"
+#include "../lib/types.h"
+
+/*
+ * Hardware sha1/sha256 block functions, used by fio_sha1_update() and
+ * fio_sha256_update() once probed for. Each hashes 'blocks' consecutive
+ * 64-byte blocks into the state words.
+ */
+extern const uint32_t fio_sha256_k[64];
+
+extern bool sha_ni_available;
+extern bool sha_arm64_available;
+
+#ifdef CONFIG_SHA_NI
+extern void sha1_ni_blocks(uint32_t *, const uint8_t *, unsigned int);
+extern void sha256_ni_blocks(uint32_t *, const uint8_t *, unsigned int);
+extern void sha_ni_probe(void);
+#else
+static inline void sha_ni_probe(void)
+{
+}
+#endif /* CONFIG_SHA_NI */
+
+#ifdef ARCH_HAVE_CRC_CRYPTO
+extern void sha1_arm64_blocks(uint32_t *, const uint8_t *, unsigned int);
+extern void sha256_arm64_blocks(uint32_t *, const uint8_t *, unsigned int);
+extern void sha_arm64_probe(void);
+#else
+static inline void sha_arm64_probe(void)
+{
+}
+#endif /* ARCH_HAVE_CRC_CRYPTO */
+
+static inline bool sha_hw_available(void)
+{
+	return sha_ni_available || sha_arm64_available;
+}
+
+static inline const char *sha_hw_impl(void)
+{
+	if (sha_arm64_available)
+		return "arm64";
+	if (sha_ni_available)
+		return "sha-ni";
+	return NULL;
+}
+
+#endif
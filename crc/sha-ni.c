@@ -0,0 +1,176 @@
+/*
+ * sha1 and sha256 block functions using the x86 SHA extensions
+ */
+#include "sha-hw.h"
+
+bool sha_ni_available = false;
+
+#ifdef CONFIG_SHA_NI
+
+#include <immintrin.h>
+
+#define SHA_NI_FN	__attribute__((target("sha,sse4.1")))
+
+static bool sha_ni_probed;
+
+/*
+ * Four sha1 rounds of group 'i' (of 20). m0 is the message group the
+ * rounds use, and the schedule updates the groups that follow it: m1
+ * gets its final sha1msg2, m2 the xor and m3 the sha1msg1 step.
+ */
+#define SHA1_NI_ROUND4(i, e0, e1, m0, m1, m2, m3) do {			\
+	if ((i) == 0)							\
+		e0 = _mm_add_epi32(e0, m0);				\
+	else								\
+		e0 = _mm_sha1nexte_epu32(e0, m0);			\
+	e1 = abcd;							\
+	if ((i) >= 3 && (i) <= 18)					\
+		m1 = _mm_sha1msg2_epu32(m1, m0);			\
+	abcd = _mm_sha1rnds4_epu32(abcd, e0, (i) / 5);			\
+	if ((i) >= 1 && (i) <= 16)					\
+		m3 = _mm_sha1msg1_epu32(m3, m0);			\
+	if ((i) >= 2 && (i) <= 17)					\
+		m2 = _mm_xor_si128(m2, m0);				\
+} while (0)
+
+SHA_NI_FN void sha1_ni_blocks(uint32_t *state, const uint8_t *data,
+			      unsigned int blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+					    0x08090a0b0c0d0e0fULL);
+	__m128i abcd, abcd_save, e0, e0_save, e1;
+	__m128i m0, m1, m2, m3;
+
+	abcd = _mm_loadu_si128((const __m128i *) state);
+	abcd = _mm_shuffle_epi32(abcd, 0x1b);
+	e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+	while (blocks--) {
+		abcd_save = abcd;
+		e0_save = e0;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), mask);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), mask);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), mask);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), mask);
+
+		SHA1_NI_ROUND4(0, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_ROUND4(1, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_ROUND4(2, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_ROUND4(3, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_ROUND4(4, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_ROUND4(5, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_ROUND4(6, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_ROUND4(7, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_ROUND4(8, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_ROUND4(9, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_ROUND4(10, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_ROUND4(11, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_ROUND4(12, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_ROUND4(13, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_ROUND4(14, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_ROUND4(15, e1, e0, m3, m0, m1, m2);
+		SHA1_NI_ROUND4(16, e0, e1, m0, m1, m2, m3);
+		SHA1_NI_ROUND4(17, e1, e0, m1, m2, m3, m0);
+		SHA1_NI_ROUND4(18, e0, e1, m2, m3, m0, m1);
+		SHA1_NI_ROUND4(19, e1, e0, m3, m0, m1, m2);
+
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+		data += 64;
+	}
+
+	abcd = _mm_shuffle_epi32(abcd, 0x1b);
+	_mm_storeu_si128((__m128i *) state, abcd);
+	state[4] = _mm_extract_epi32(e0, 3);
+}
+
+/*
+ * Four sha256 rounds of group 'i' (of 16) using message group m0. The
+ * schedule finishes m1 (sha256msg2) and starts m3 (sha256msg1), m2 being
+ * the group before m0.
+ */
+#define SHA256_NI_ROUND4(i, m0, m1, m2, m3) do {			\
+	msg = _mm_add_epi32(m0,						\
+		_mm_loadu_si128((const __m128i *) &fio_sha256_k[4 * (i)])); \
+	state1 = _mm_sha256rnds2_epu32(state1, state0, msg);		\
+	if ((i) >= 3 && (i) <= 14) {					\
+		m1 = _mm_add_epi32(m1, _mm_alignr_epi8(m0, m3, 4));	\
+		m1 = _mm_sha256msg2_epu32(m1, m0);			\
+	}								\
+	msg = _mm_shuffle_epi32(msg, 0x0e);				\
+	state0 = _mm_sha256rnds2_epu32(state0, state1, msg);		\
+	if ((i) >= 1 && (i) <= 12)					\
+		m3 = _mm_sha256msg1_epu32(m3, m0);			\
+} while (0)
+
+SHA_NI_FN void sha256_ni_blocks(uint32_t *state, const uint8_t *data,
+				unsigned int blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+					    0x0405060700010203ULL);
+	__m128i state0, state1, save0, save1, msg, tmp;
+	__m128i m0, m1, m2, m3;
+
+	/* state0 is ABEF, state1 CDGH */
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0xb1);
+	state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1b);
+	state0 = _mm_alignr_epi8(tmp, state1, 8);
+	state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+	while (blocks--) {
+		save0 = state0;
+		save1 = state1;
+
+		m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), mask);
+		m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), mask);
+		m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), mask);
+		m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), mask);
+
+		SHA256_NI_ROUND4(0, m0, m1, m2, m3);
+		SHA256_NI_ROUND4(1, m1, m2, m3, m0);
+		SHA256_NI_ROUND4(2, m2, m3, m0, m1);
+		SHA256_NI_ROUND4(3, m3, m0, m1, m2);
+		SHA256_NI_ROUND4(4, m0, m1, m2, m3);
+		SHA256_NI_ROUND4(5, m1, m2, m3, m0);
+		SHA256_NI_ROUND4(6, m2, m3, m0, m1);
+		SHA256_NI_ROUND4(7, m3, m0, m1, m2);
+		SHA256_NI_ROUND4(8, m0, m1, m2, m3);
+		SHA256_NI_ROUND4(9, m1, m2, m3, m0);
+		SHA256_NI_ROUND4(10, m2, m3, m0, m1);
+		SHA256_NI_ROUND4(11, m3, m0, m1, m2);
+		SHA256_NI_ROUND4(12, m0, m1, m2, m3);
+		SHA256_NI_ROUND4(13, m1, m2, m3, m0);
+		SHA256_NI_ROUND4(14, m2, m3, m0, m1);
+		SHA256_NI_ROUND4(15, m3, m0, m1, m2);
+
+		state0 = _mm_add_epi32(state0, save0);
+		state1 = _mm_add_epi32(state1, save1);
+		data += 64;
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1b);
+	state1 = _mm_shuffle_epi32(state1, 0xb1);
+	_mm_storeu_si128((__m128i *) state, _mm_blend_epi16(tmp, state1, 0xf0));
+	_mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+void sha_ni_probe(void)
+{
+	if (!sha_ni_probed) {
+		unsigned int eax, ebx, ecx = 0, edx;
+		bool sse41;
+
+		eax = 1;
+		do_cpuid(&eax, &ebx, &ecx, &edx);
+		sse41 = (ecx & (1 << 19)) != 0;
+
+		eax = 7;
+		ecx = 0;
+		do_cpuid(&eax, &ebx, &ecx, &edx);
+		sha_ni_available = sse41 && (ebx & (1 << 29)) != 0;
+		sha_ni_probed = true;
+	}
+}
+
+#endif /* CONFIG_SHA_NI */
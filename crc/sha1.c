@@ -8,10 +8,33 @@
 #include <arpa/inet.h>
 
 #include "sha1.h"
+#include "sha-hw.h"
 
 /* Hash one 64-byte block of data */
 static void blk_SHA1Block(struct fio_sha1_ctx *ctx, const unsigned int *data);
 
+/* Hash 'blocks' 64-byte blocks, with the SHA extensions if available */
+static void sha1_blocks(struct fio_sha1_ctx *ctx, const void *data,
+			unsigned int blocks)
+{
+#ifdef ARCH_HAVE_CRC_CRYPTO
+	if (sha_arm64_available) {
+		sha1_arm64_blocks(ctx->H, data, blocks);
+		return;
+	}
+#endif
+#ifdef CONFIG_SHA_NI
+	if (sha_ni_available) {
+		sha1_ni_blocks(ctx->H, data, blocks);
+		return;
+	}
+#endif
+	while (blocks--) {
+		blk_SHA1Block(ctx, data);
+		data += 64;
+	}
+}
+
 void fio_sha1_init(struct fio_sha1_ctx *ctx)
 {
 	ctx->size = 0;
@@ -44,12 +67,12 @@ void fio_sha1_update(struct fio_sha1_ctx *ctx, const void *data,
 		data += left;
 		if (lenW)
 			return;
-		blk_SHA1Block(ctx, ctx->W);
+		sha1_blocks(ctx, ctx->W, 1);
 	}
-	while (len >= 64) {
-		blk_SHA1Block(ctx, data);
-		data += 64;
-		len -= 64;
+	if (len >= 64) {
+		sha1_blocks(ctx, data, len / 64);
+		data += len & ~63UL;
+		len &= 63;
 	}
 	if (len)
 		memcpy(ctx->W, data, len);
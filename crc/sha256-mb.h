@@ -0,0 +1,58 @@
+/*
+ * Multi-buffer sha256_transform(), included by sha256.c once per vector
+ * width with MB_FN, MB_TARGET, MB_VEC and MB_LANES defined. Hashes
+ * 'blocks' consecutive blocks of each of the MB_LANES buffers, one
+ * buffer per vector lane.
+ */
+static MB_TARGET void MB_FN(struct fio_sha256_ctx **ctx, const uint8_t **data,
+			    unsigned int blocks)
+{
+	uint32_t in[16][MB_LANES];
+	MB_VEC s[8], W[16];
+	MB_VEC a, b, c, d, e, f, g, h, t1, t2;
+	unsigned int i, j, k;
+
+	for (i = 0; i < 8; i++)
+		for (j = 0; j < MB_LANES; j++)
+			s[i][j] = ctx[j]->state[i];
+
+	for (k = 0; k < blocks; k++) {
+		for (j = 0; j < MB_LANES; j++) {
+			const uint8_t *p = data[j] + k * SHA256_BLOCK_SIZE;
+			uint32_t w;
+
+			for (i = 0; i < 16; i++) {
+				memcpy(&w, p + i * 4, sizeof(w));
+				in[i][j] = __be32_to_cpu(w);
+			}
+		}
+		for (i = 0; i < 16; i++)
+			memcpy(&W[i], in[i], sizeof(W[i]));
+
+		a = s[0]; b = s[1]; c = s[2]; d = s[3];
+		e = s[4]; f = s[5]; g = s[6]; h = s[7];
+
+		for (i = 0; i < 64; i++) {
+			if (i >= 16)
+				W[i & 15] += vs1(W[(i - 2) & 15]) +
+					W[(i - 7) & 15] + vs0(W[(i - 15) & 15]);
+
+			t1 = h + ve1(e) + vch(e, f, g) + fio_sha256_k[i] + W[i & 15];
+			t2 = ve0(a) + vmaj(a, b, c);
+			h = g; g = f; f = e; e = d + t1;
+			d = c; c = b; b = a; a = t1 + t2;
+		}
+
+		s[0] += a; s[1] += b; s[2] += c; s[3] += d;
+		s[4] += e; s[5] += f; s[6] += g; s[7] += h;
+	}
+
+	for (i = 0; i < 8; i++)
+		for (j = 0; j < MB_LANES; j++)
+			ctx[j]->state[i] = s[i][j];
+}
+
+#undef MB_FN
+#undef MB_TARGET
+#undef MB_VEC
+#undef MB_LANES
@@ -20,6 +20,8 @@
 
 #include "../lib/bswap.h"
 #include "sha256.h"
+#include "hash-mb.h"
+#include "sha-hw.h"
 
 #define SHA256_DIGEST_SIZE	32
 #define SHA256_HMAC_BLOCK_SIZE	64
@@ -226,6 +228,50 @@ static void sha256_transform(uint32_t *state, const uint8_t *input)
 	memset(W, 0, 64 * sizeof(uint32_t));
 }
 
+const uint32_t fio_sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/*
+ * Hash 'blocks' consecutive blocks, with the SHA extensions if the CPU
+ * has them.
+ */
+static void sha256_blocks(uint32_t *state, const uint8_t *data,
+			  unsigned int blocks)
+{
+#ifdef ARCH_HAVE_CRC_CRYPTO
+	if (sha_arm64_available) {
+		sha256_arm64_blocks(state, data, blocks);
+		return;
+	}
+#endif
+#ifdef CONFIG_SHA_NI
+	if (sha_ni_available) {
+		sha256_ni_blocks(state, data, blocks);
+		return;
+	}
+#endif
+	while (blocks--) {
+		sha256_transform(state, data);
+		data += SHA256_BLOCK_SIZE;
+	}
+}
+
 void fio_sha256_init(struct fio_sha256_ctx *sctx)
 {
 	sctx->state[0] = H0;
@@ -257,11 +303,14 @@ void fio_sha256_update(struct fio_sha256_ctx *sctx, const uint8_t *data,
 			src = sctx->buf;
 		}
 
-		do {
-			sha256_transform(sctx->state, src);
+		if (partial) {
+			sha256_blocks(sctx->state, src, 1);
 			done += 64;
-			src = data + done;
-		} while (done + 63 < len);
+		}
+
+		sha256_blocks(sctx->state, data + done, (len - done) / 64);
+		done += (len - done) & ~63U;
+		src = data + done;
 
 		partial = 0;
 	}
@@ -290,3 +339,97 @@ void fio_sha256_final(struct fio_sha256_ctx *sctx)
 	for (i = 0; i < 8; i++)
 		sctx->buf[i] = sctx->state[i];
 }
+
+#ifdef CONFIG_HASH_MB
+#define vror(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+#define ve0(x)		(vror(x, 2) ^ vror(x, 13) ^ vror(x, 22))
+#define ve1(x)		(vror(x, 6) ^ vror(x, 11) ^ vror(x, 25))
+#define vs0(x)		(vror(x, 7) ^ vror(x, 18) ^ ((x) >> 3))
+#define vs1(x)		(vror(x, 17) ^ vror(x, 19) ^ ((x) >> 10))
+#define vch(x, y, z)	((z) ^ ((x) & ((y) ^ (z))))
+#define vmaj(x, y, z)	(((x) & (y)) | ((z) & ((x) | (y))))
+
+#define MB_FN		sha256_mb_avx2
+#define MB_TARGET	FIO_HASH_MB_AVX2_FN
+#define MB_VEC		fio_hash_mb_vec8
+#define MB_LANES	8
+#include "sha256-mb.h"
+
+#define MB_FN		sha256_mb_avx512
+#define MB_TARGET	FIO_HASH_MB_AVX512_FN
+#define MB_VEC		fio_hash_mb_vec16
+#define MB_LANES	16
+#include "sha256-mb.h"
+
+/*
+ * Hash the whole blocks of a group of up to 'lanes' buffers together.
+ * Unused lanes repeat the first buffer into a scratch context.
+ */
+static void sha256_mb_group(struct fio_sha256_ctx **ctx, const uint8_t **data,
+			    unsigned int nr, unsigned int blocks,
+			    unsigned int lanes)
+{
+	struct fio_sha256_ctx *lane_ctx[FIO_HASH_MB_MAX_LANES];
+	const uint8_t *lane_data[FIO_HASH_MB_MAX_LANES];
+	struct fio_sha256_ctx scratch;
+	unsigned int i;
+
+	if (nr < lanes) {
+		scratch = *ctx[0];
+		for (i = 0; i < lanes; i++) {
+			lane_ctx[i] = i < nr ? ctx[i] : &scratch;
+			lane_data[i] = i < nr ? data[i] : data[0];
+		}
+		ctx = lane_ctx;
+		data = lane_data;
+	}
+
+	if (lanes == 16)
+		sha256_mb_avx512(ctx, data, blocks);
+	else
+		sha256_mb_avx2(ctx, data, blocks);
+}
+#endif
+
+/*
+ * Same as calling fio_sha256_update() on each of the 'nr' contexts with
+ * 'len' bytes of the matching buffer, but hashes the buffers in parallel
+ * when the CPU allows. The contexts must not hold a partial block, which
+ * is always the case for freshly initialized ones.
+ */
+void fio_sha256_update_mb(struct fio_sha256_ctx **ctx, const uint8_t **data,
+			  unsigned int len, unsigned int nr)
+{
+	unsigned int i = 0;
+#ifdef CONFIG_HASH_MB
+	unsigned int j, group, blocks = len / SHA256_BLOCK_SIZE;
+	unsigned int done = blocks * SHA256_BLOCK_SIZE;
+	unsigned int lanes = fio_hash_mb_lanes();
+
+	/* one buffer at a time with the SHA extensions beats the lanes */
+	if (sha_hw_available())
+		lanes = 1;
+	for (j = 0; j < nr; j++)
+		if (ctx[j]->count & (SHA256_BLOCK_SIZE - 1))
+			lanes = 1;
+
+	/*
+	 * A short group costs as much as a full one, don't bother unless
+	 * a good part of the lanes are in use.
+	 */
+	while (lanes > 1 && blocks && nr - i >= lanes / 4) {
+		group = nr - i;
+		if (group > lanes)
+			group = lanes;
+
+		sha256_mb_group(&ctx[i], &data[i], group, blocks, lanes);
+		for (j = i; j < i + group; j++) {
+			ctx[j]->count += done;
+			fio_sha256_update(ctx[j], data[j] + done, len - done);
+		}
+		i += group;
+	}
+#endif
+	for (; i < nr; i++)
+		fio_sha256_update(ctx[i], data[i], len);
+}
@@ -15,5 +15,7 @@ struct fio_sha256_ctx {
 void fio_sha256_init(struct fio_sha256_ctx *);
 void fio_sha256_update(struct fio_sha256_ctx *, const uint8_t *, unsigned int);
 void fio_sha256_final(struct fio_sha256_ctx *);
+void fio_sha256_update_mb(struct fio_sha256_ctx **, const uint8_t **,
+			  unsigned int, unsigned int);
 
 #endif
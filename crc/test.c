@@ -19,6 +19,8 @@
 #include "../crc/sha512.h"
 #include "../crc/sha3.h"
 #include "../crc/xxhash.h"
+#include "../crc/xxh3.h"
+#include "../crc/sha-hw.h"
 #include "../crc/murmur3.h"
 #include "../crc/fnv.h"
 #include "../hash.h"
@@ -33,6 +35,7 @@ struct test_type {
 	unsigned int mask;
 	void (*fn)(struct test_type *, void *, size_t);
 	uint32_t output;
+	const char *(*impl)(void);
 };
 
 enum {
@@ -53,6 +56,7 @@ enum {
 	T_SHA3_256	= 1U << 14,
 	T_SHA3_384	= 1U << 15,
 	T_SHA3_512	= 1U << 16,
+	T_XXH3		= 1U << 17,
 };
 
 static void t_md5(struct test_type *t, void *buf, size_t size)
@@ -242,6 +246,14 @@ static void t_xxhash(struct test_type *t, void *buf, size_t size)
 	t->output = XXH32_digest(state);
 }
 
+static void t_xxh3(struct test_type *t, void *buf, size_t size)
+{
+	int i;
+
+	for (i = 0; i < NR_CHUNKS; i++)
+		t->output += fio_xxh3_64(buf, size);
+}
+
 static struct test_type t[] = {
 	{
 		.name = "md5",
@@ -277,11 +289,13 @@ static struct test_type t[] = {
 		.name = "sha1",
 		.mask = T_SHA1,
 		.fn = t_sha1,
+		.impl = sha_hw_impl,
 	},
 	{
 		.name = "sha256",
 		.mask = T_SHA256,
 		.fn = t_sha256,
+		.impl = sha_hw_impl,
 	},
 	{
 		.name = "sha512",
@@ -293,6 +307,12 @@ static struct test_type t[] = {
 		.mask = T_XXHASH,
 		.fn = t_xxhash,
 	},
+	{
+		.name = "xxh3",
+		.mask = T_XXH3,
+		.fn = t_xxh3,
+		.impl = xxh3_impl,
+	},
 	{
 		.name = "murmur3",
 		.mask = T_MURMUR3,
@@ -375,6 +395,9 @@ int fio_crctest(const char *type)
 
 	crc32c_arm64_probe();
 	crc32c_intel_probe();
+	sha_arm64_probe();
+	sha_ni_probe();
+	xxh3_probe();
 
 	if (!type)
 		test_mask = ~0U;
@@ -396,6 +419,7 @@ int fio_crctest(const char *type)
 		struct timespec ts;
 		double mb_sec;
 		uint64_t usec;
+		const char *impl = NULL;
 		char pre[3];
 
 		if (!(t[i].mask & test_mask))
@@ -421,9 +445,15 @@ int fio_crctest(const char *type)
 				sprintf(pre, "\t");
 			else
 				sprintf(pre, "\t\t");
-			printf("%s:%s%8.2f MiB/sec\n", t[i].name, pre, mb_sec);
+			printf("%s:%s%8.2f MiB/sec", t[i].name, pre, mb_sec);
 		} else
-			printf("%s:inf MiB/sec\n", t[i].name);
+			printf("%s:inf MiB/sec", t[i].name);
+
+		if (t[i].impl)
+			impl = t[i].impl();
+		if (impl)
+			printf(" (%s)", impl);
+		printf("\n");
 		first = 0;
 	}
 
@@ -0,0 +1,83 @@
+/*
+ * XXH3 long input loop, included once per vector width by xxh3.c with
+ * XXH3_FN, XXH3_TARGET, XXH3_VEC and XXH3_WIDTH (u64 lanes per vector)
+ * defined. A 64-byte stripe is 8 / XXH3_WIDTH vectors.
+ */
+
+#define XXH3_NVEC	(XXH3_ACC_NB / XXH3_WIDTH)
+
+static inline XXH3_TARGET XXH3_VEC XXH3_CAT(XXH3_FN, _load)(const uint8_t *p)
+{
+	XXH3_VEC v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline XXH3_TARGET void XXH3_CAT(XXH3_FN, _stripes)(XXH3_VEC *acc,
+		const uint8_t *in, const uint8_t *secret, size_t nr)
+{
+	const XXH3_VEC mask = (XXH3_VEC) { } + 0xffffffffULL;
+	size_t n, i;
+
+	for (n = 0; n < nr; n++) {
+		for (i = 0; i < XXH3_NVEC; i++) {
+			XXH3_VEC d, dk;
+
+			d = XXH3_CAT(XXH3_FN, _load)(in + i * sizeof(d));
+			dk = d ^ XXH3_CAT(XXH3_FN, _load)(secret + i * sizeof(d));
+			acc[i] += XXH3_SWAP(d) + (dk & mask) * (dk >> 32);
+		}
+		in += XXH3_STRIPE_LEN;
+		secret += XXH3_SECRET_CONSUME_RATE;
+	}
+}
+
+static inline XXH3_TARGET void XXH3_CAT(XXH3_FN, _scramble)(XXH3_VEC *acc,
+		const uint8_t *secret)
+{
+	size_t i;
+
+	for (i = 0; i < XXH3_NVEC; i++) {
+		XXH3_VEC a = acc[i];
+
+		a ^= a >> 47;
+		a ^= XXH3_CAT(XXH3_FN, _load)(secret + i * sizeof(a));
+		acc[i] = a * XXH3_PRIME32_1;
+	}
+}
+
+static XXH3_TARGET void XXH3_FN(uint64_t *acc64, const uint8_t *in, size_t len)
+{
+	const size_t stripes_per_block = (sizeof(xxh3_secret) - XXH3_STRIPE_LEN) /
+						XXH3_SECRET_CONSUME_RATE;
+	const size_t block_len = stripes_per_block * XXH3_STRIPE_LEN;
+	const size_t blocks = (len - 1) / block_len;
+	XXH3_VEC acc[XXH3_NVEC];
+	size_t n;
+
+	memcpy(acc, acc64, sizeof(acc));
+
+	for (n = 0; n < blocks; n++) {
+		XXH3_CAT(XXH3_FN, _stripes)(acc, in + n * block_len,
+					xxh3_secret, stripes_per_block);
+		XXH3_CAT(XXH3_FN, _scramble)(acc, xxh3_secret +
+					sizeof(xxh3_secret) - XXH3_STRIPE_LEN);
+	}
+
+	XXH3_CAT(XXH3_FN, _stripes)(acc, in + blocks * block_len, xxh3_secret,
+			((len - 1) - blocks * block_len) / XXH3_STRIPE_LEN);
+
+	/* last stripe, with a secret offset not aligned to the others */
+	XXH3_CAT(XXH3_FN, _stripes)(acc, in + len - XXH3_STRIPE_LEN,
+			xxh3_secret + sizeof(xxh3_secret) - XXH3_STRIPE_LEN - 7, 1);
+
+	memcpy(acc64, acc, sizeof(acc));
+}
+
+#undef XXH3_NVEC
+#undef XXH3_FN
+#undef XXH3_TARGET
+#undef XXH3_VEC
+#undef XXH3_WIDTH
+#undef XXH3_SWAP
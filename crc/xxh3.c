@@ -0,0 +1,297 @@
+/*
+ * XXH3 64-bit hash, following the reference implementation at
+ * https://github.com/Cyan4973/xxHash (BSD 2-Clause, Yann Collet).
+ *
+ * Only the default secret and a zero seed are supported, which is all
+ * that verify needs. The long input loop is written with vector
+ * extensions: 16-byte vectors map to SSE2 on x86-64 and NEON on arm64,
+ * and AVX2/AVX-512 versions are picked at runtime when available.
+ */
+#include <string.h>
+#include <stdbool.h>
+
+#include "../os/os.h"
+#include "xxh3.h"
+#include "hash-mb.h"
+
+#define XXH3_PRIME32_1	0x9E3779B1U
+#define XXH3_PRIME32_2	0x85EBCA77U
+#define XXH3_PRIME32_3	0xC2B2AE3DU
+#define XXH3_PRIME64_1	0x9E3779B185EBCA87ULL
+#define XXH3_PRIME64_2	0xC2B2AE3D27D4EB4FULL
+#define XXH3_PRIME64_3	0x165667B19E3779F9ULL
+#define XXH3_PRIME64_4	0x85EBCA77C2B2AE63ULL
+#define XXH3_PRIME64_5	0x27D4EB2F165667C5ULL
+#define XXH3_PRIME_MX1	0x165667919E3779F9ULL
+#define XXH3_PRIME_MX2	0x9FB21C651E98DF25ULL
+
+#define XXH3_STRIPE_LEN			64
+#define XXH3_SECRET_CONSUME_RATE	8
+#define XXH3_ACC_NB			8
+#define XXH3_MIDSIZE_MAX		240
+
+#define __XXH3_CAT(a, b)	a ## b
+#define XXH3_CAT(a, b)		__XXH3_CAT(a, b)
+
+static const uint8_t xxh3_secret[192] = {
+	0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+	0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+	0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+	0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+	0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+	0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+	0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+	0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+	0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+	0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+	0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+	0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static inline uint32_t xxh3_read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return le32_to_cpu(v);
+}
+
+static inline uint64_t xxh3_read64(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+	return le64_to_cpu(v);
+}
+
+static inline uint64_t xxh3_rotl64(uint64_t x, unsigned int r)
+{
+	return (x << r) | (x >> (64 - r));
+}
+
+/* 64x64->128 bit multiply, folded by xor'ing the two halves */
+static inline uint64_t xxh3_mul128_fold64(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+	__uint128_t p = (__uint128_t) a * b;
+
+	return (uint64_t) p ^ (uint64_t) (p >> 64);
+#else
+	uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+	uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+	uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+	uint64_t hi_hi = (a >> 32) * (b >> 32);
+	uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+	uint64_t hi = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	uint64_t lo = (cross << 32) | (lo_lo & 0xffffffff);
+
+	return lo ^ hi;
+#endif
+}
+
+static uint64_t xxh64_avalanche(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= XXH3_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH3_PRIME64_3;
+	return h ^ (h >> 32);
+}
+
+static uint64_t xxh3_avalanche(uint64_t h)
+{
+	h ^= h >> 37;
+	h *= XXH3_PRIME_MX1;
+	return h ^ (h >> 32);
+}
+
+static uint64_t xxh3_rrmxmx(uint64_t h, uint64_t len)
+{
+	h ^= xxh3_rotl64(h, 49) ^ xxh3_rotl64(h, 24);
+	h *= XXH3_PRIME_MX2;
+	h ^= (h >> 35) + len;
+	h *= XXH3_PRIME_MX2;
+	return h ^ (h >> 28);
+}
+
+static uint64_t xxh3_len_0to16(const uint8_t *in, size_t len)
+{
+	const uint8_t *s = xxh3_secret;
+
+	if (len > 8) {
+		uint64_t lo = xxh3_read64(in) ^
+				(xxh3_read64(s + 24) ^ xxh3_read64(s + 32));
+		uint64_t hi = xxh3_read64(in + len - 8) ^
+				(xxh3_read64(s + 40) ^ xxh3_read64(s + 48));
+
+		return xxh3_avalanche(len + __builtin_bswap64(lo) + hi +
+					xxh3_mul128_fold64(lo, hi));
+	} else if (len >= 4) {
+		uint64_t in64 = xxh3_read32(in + len - 4) +
+				((uint64_t) xxh3_read32(in) << 32);
+
+		return xxh3_rrmxmx(in64 ^ (xxh3_read64(s + 8) ^
+					xxh3_read64(s + 16)), len);
+	} else if (len) {
+		uint32_t combined = ((uint32_t) in[0] << 16) |
+				    ((uint32_t) in[len >> 1] << 24) |
+				    in[len - 1] | ((uint32_t) len << 8);
+
+		return xxh64_avalanche(combined ^ (uint64_t) (xxh3_read32(s) ^
+							xxh3_read32(s + 4)));
+	}
+
+	return xxh64_avalanche(xxh3_read64(s + 56) ^ xxh3_read64(s + 64));
+}
+
+static inline uint64_t xxh3_mix16(const uint8_t *in, const uint8_t *s)
+{
+	return xxh3_mul128_fold64(xxh3_read64(in) ^ xxh3_read64(s),
+				  xxh3_read64(in + 8) ^ xxh3_read64(s + 8));
+}
+
+static uint64_t xxh3_len_17to128(const uint8_t *in, size_t len)
+{
+	const uint8_t *s = xxh3_secret;
+	uint64_t acc = len * XXH3_PRIME64_1;
+
+	if (len > 32) {
+		if (len > 64) {
+			if (len > 96) {
+				acc += xxh3_mix16(in + 48, s + 96);
+				acc += xxh3_mix16(in + len - 64, s + 112);
+			}
+			acc += xxh3_mix16(in + 32, s + 64);
+			acc += xxh3_mix16(in + len - 48, s + 80);
+		}
+		acc += xxh3_mix16(in + 16, s + 32);
+		acc += xxh3_mix16(in + len - 32, s + 48);
+	}
+	acc += xxh3_mix16(in, s);
+	acc += xxh3_mix16(in + len - 16, s + 16);
+
+	return xxh3_avalanche(acc);
+}
+
+static uint64_t xxh3_len_129to240(const uint8_t *in, size_t len)
+{
+	const uint8_t *s = xxh3_secret;
+	unsigned int i, rounds = len / 16;
+	uint64_t acc = len * XXH3_PRIME64_1;
+	uint64_t acc_end;
+
+	for (i = 0; i < 8; i++)
+		acc += xxh3_mix16(in + 16 * i, s + 16 * i);
+
+	/* the minimum secret size (136) minus 17 */
+	acc_end = xxh3_mix16(in + len - 16, s + 136 - 17);
+	acc = xxh3_avalanche(acc);
+
+	for (i = 8; i < rounds; i++)
+		acc_end += xxh3_mix16(in + 16 * i, s + 16 * (i - 8) + 3);
+
+	return xxh3_avalanche(acc + acc_end);
+}
+
+/*
+ * Vector versions of the long loop. Each u64 lane accumulates its own
+ * input word, and adds the raw input of its neighbour lane.
+ */
+#if defined(__clang__)
+#define XXH3_SWAP2(v)	__builtin_shufflevector(v, v, 1, 0)
+#define XXH3_SWAP4(v)	__builtin_shufflevector(v, v, 1, 0, 3, 2)
+#define XXH3_SWAP8(v)	__builtin_shufflevector(v, v, 1, 0, 3, 2, 5, 4, 7, 6)
+#else
+#define XXH3_SWAP2(v)	__builtin_shuffle(v, (typeof(v)) { 1, 0 })
+#define XXH3_SWAP4(v)	__builtin_shuffle(v, (typeof(v)) { 1, 0, 3, 2 })
+#define XXH3_SWAP8(v)	__builtin_shuffle(v, (typeof(v)) { 1, 0, 3, 2, 5, 4, 7, 6 })
+#endif
+
+typedef uint64_t xxh3_vec2 __attribute__((vector_size(16)));
+
+#define XXH3_FN		xxh3_long_vec2
+#define XXH3_TARGET
+#define XXH3_VEC	xxh3_vec2
+#define XXH3_WIDTH	2
+#define XXH3_SWAP	XXH3_SWAP2
+#include "xxh3-long.h"
+
+#ifdef CONFIG_HASH_MB
+typedef uint64_t xxh3_vec4 __attribute__((vector_size(32)));
+typedef uint64_t xxh3_vec8 __attribute__((vector_size(64)));
+
+#define XXH3_FN		xxh3_long_avx2
+#define XXH3_TARGET	FIO_HASH_MB_AVX2_FN
+#define XXH3_VEC	xxh3_vec4
+#define XXH3_WIDTH	4
+#define XXH3_SWAP	XXH3_SWAP4
+#include "xxh3-long.h"
+
+#define XXH3_FN		xxh3_long_avx512
+#define XXH3_TARGET	FIO_HASH_MB_AVX512_FN
+#define XXH3_VEC	xxh3_vec8
+#define XXH3_WIDTH	8
+#define XXH3_SWAP	XXH3_SWAP8
+#include "xxh3-long.h"
+#endif
+
+static void (*xxh3_long)(uint64_t *, const uint8_t *, size_t) = xxh3_long_vec2;
+static const char *xxh3_long_name = "vec128";
+static bool xxh3_probed;
+
+void xxh3_probe(void)
+{
+	if (xxh3_probed)
+		return;
+
+#ifdef CONFIG_HASH_MB
+	if (fio_hash_mb_lanes() == 16) {
+		xxh3_long = xxh3_long_avx512;
+		xxh3_long_name = "avx512";
+	} else if (fio_hash_mb_lanes() == 8) {
+		xxh3_long = xxh3_long_avx2;
+		xxh3_long_name = "avx2";
+	}
+#endif
+	xxh3_probed = true;
+}
+
+const char *xxh3_impl(void)
+{
+	return xxh3_long_name;
+}
+
+static uint64_t xxh3_hash_long(const uint8_t *in, size_t len)
+{
+	uint64_t acc[XXH3_ACC_NB] = {
+		XXH3_PRIME32_3, XXH3_PRIME64_1, XXH3_PRIME64_2, XXH3_PRIME64_3,
+		XXH3_PRIME64_4, XXH3_PRIME32_2, XXH3_PRIME64_5, XXH3_PRIME32_1,
+	};
+	const uint8_t *s = xxh3_secret + 11;
+	uint64_t result = len * XXH3_PRIME64_1;
+	unsigned int i;
+
+	xxh3_long(acc, in, len);
+
+	for (i = 0; i < 4; i++) {
+		result += xxh3_mul128_fold64(acc[2 * i] ^ xxh3_read64(s),
+					acc[2 * i + 1] ^ xxh3_read64(s + 8));
+		s += 16;
+	}
+
+	return xxh3_avalanche(result);
+}
+
+uint64_t fio_xxh3_64(const void *data, size_t len)
+{
+	const uint8_t *in = data;
+
+	if (len <= 16)
+		return xxh3_len_0to16(in, len);
+	if (len <= 128)
+		return xxh3_len_17to128(in, len);
+	if (len <= XXH3_MIDSIZE_MAX)
+		return xxh3_len_129to240(in, len);
+
+	return xxh3_hash_long(in, len);
+}
@@ -0,0 +1,16 @@
+#ifndef FIO_XXH3_H
+#define FIO_XXH3_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/*
+ * XXH3 64-bit hash with the default secret and a zero seed, so the
+ * result matches XXH3_64bits() from the xxHash library. Inputs longer
+ * than 240 bytes are hashed with the widest vectors the CPU has.
+ */
+extern uint64_t fio_xxh3_64(const void *, size_t);
+extern void xxh3_probe(void);
+extern const char *xxh3_impl(void);
+
+#endif
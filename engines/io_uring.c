@@ -24,6 +24,7 @@
 #include "../lib/types.h"
 #include "../os/linux/io_uring.h"
 #include "cmdprio.h"
+#include "nvme.h"
 
 struct io_sq_ring {
 	unsigned *head;
@@ -47,29 +48,75 @@ struct ioring_mmap {
 	size_t len;
 };
 
-struct ioring_data {
+/*
+ * One SQ/CQ pair. A job owns nr_rings of these, each sized for the full
+ * queue depth so that any io_u can be issued on any ring.
+ */
+struct ioring_ring {
 	int ring_fd;
 
-	struct io_u **io_u_index;
-
-	int *fds;
-
 	struct io_sq_ring sq_ring;
 	struct io_uring_sqe *sqes;
-	struct iovec *iovecs;
 	unsigned sq_ring_mask;
 
 	struct io_cq_ring cq_ring;
 	unsigned cq_ring_mask;
 
 	int queued;
+	unsigned inflight;
 	int cq_ring_off;
+	unsigned reaped;
+
+	struct ioring_mmap mmap[3];
+
+	/*
+	 * Provided buffer ring for reads, see the bufring option. Buffers
+	 * picked by completed reads are handed back to the kernel in batches
+	 * once fio is done with them.
+	 */
+	struct io_uring_buf_ring *br;
+	void *br_bufs;
+	unsigned int br_avail;
+	unsigned short br_tail;
+	unsigned short *br_recycle;
+	unsigned int br_nr_recycle;
+};
+
+struct ioring_data {
+	struct io_u **io_u_index;
+	unsigned char *io_u_ring;
+
+	int *fds;
+
+	struct iovec *iovecs;
+	struct nvme_dsm_range *dsm;
+
+	struct ioring_ring *rings;
+	unsigned int nr_rings;
+	unsigned int next_ring;
+
+	int queued;
 	unsigned iodepth;
 	int prepped;
 
-	struct ioring_mmap mmap[3];
+	unsigned int br_entries;
+	unsigned long long br_bs;
+
+	/* log2 of the SQE/CQE size relative to the base 64/16 byte entry */
+	unsigned int sqe_shift;
+	unsigned int cqe_shift;
 
 	bool use_cmdprio;
+	bool is_uring_cmd;
+};
+
+enum {
+	IORING_RING_RR = 0,
+	IORING_RING_FILE,
+};
+
+enum uring_cmd_type {
+	FIO_URING_CMD_NVME = 1,
 };
 
 struct ioring_options {
@@ -85,6 +132,11 @@ struct ioring_options {
 	unsigned int uncached;
 	unsigned int nowait;
 	unsigned int force_async;
+	unsigned int nr_rings;
+	unsigned int ring_select;
+	unsigned int cmd_type;
+	unsigned int write_zeroes;
+	unsigned int bufring;
 };
 
 static const int ddir_to_op[2][2] = {
@@ -279,29 +331,144 @@ static struct fio_option options[] = {
 		.category = FIO_OPT_C_ENGINE,
 		.group	= FIO_OPT_G_IOURING,
 	},
+	{
+		.name	= "nr_rings",
+		.lname	= "Number of rings",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct ioring_options, nr_rings),
+		.def	= "1",
+		.minval	= 1,
+		.maxval	= 64,
+		.help	= "Number of SQ/CQ rings to spread IO across",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_IOURING,
+	},
+	{
+		.name	= "ring_select",
+		.lname	= "Ring selection policy",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct ioring_options, ring_select),
+		.def	= "roundrobin",
+		.help	= "How to pick the ring for an IO when nr_rings > 1",
+		.posval = {
+			  { .ival = "roundrobin",
+			    .oval = IORING_RING_RR,
+			    .help = "Round robin across rings",
+			  },
+			  { .ival = "file",
+			    .oval = IORING_RING_FILE,
+			    .help = "All IO to a given file uses the same ring",
+			  },
+		},
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_IOURING,
+	},
+	{
+		.name	= "bufring",
+		.lname	= "Provided buffer ring",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct ioring_options, bufring),
+		.minval	= 0,
+		.maxval	= 32768,
+		.help	= "Let the kernel pick read buffers from a ring of this many entries",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_IOURING,
+	},
+	{
+		.name	= "cmd_type",
+		.lname	= "Uring cmd type",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct ioring_options, cmd_type),
+		.help	= "Specify uring-cmd type",
+		.def	= "nvme",
+		.posval = {
+			  { .ival = "nvme",
+			    .oval = FIO_URING_CMD_NVME,
+			    .help = "Issue nvme-uring-cmd",
+			  },
+		},
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_IOURING,
+	},
+	{
+		.name	= "write_zeroes",
+		.lname	= "Write zeroes",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct ioring_options, write_zeroes),
+		.help	= "Issue writes as NVMe Write Zeroes commands",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_IOURING,
+	},
 	{
 		.name	= NULL,
 	},
 };
 
-static int io_uring_enter(struct ioring_data *ld, unsigned int to_submit,
+static int io_uring_enter(struct ioring_ring *ring, unsigned int to_submit,
 			 unsigned int min_complete, unsigned int flags)
 {
-	return syscall(__NR_io_uring_enter, ld->ring_fd, to_submit,
+	return syscall(__NR_io_uring_enter, ring->ring_fd, to_submit,
 			min_complete, flags, NULL, 0);
 }
 
+static inline struct ioring_ring *io_u_to_ring(struct ioring_data *ld,
+					       struct io_u *io_u)
+{
+	return &ld->rings[ld->io_u_ring[io_u->index]];
+}
+
+static inline struct io_uring_sqe *ring_sqe(struct ioring_data *ld,
+					    struct ioring_ring *ring,
+					    unsigned int index)
+{
+	return &ring->sqes[index << ld->sqe_shift];
+}
+
+static inline struct io_uring_cqe *ring_cqe(struct ioring_data *ld,
+					    struct ioring_ring *ring,
+					    unsigned int index)
+{
+	return &ring->cq_ring.cqes[index << ld->cqe_shift];
+}
+
+/*
+ * Pick the ring this io_u will be issued on, and remember it so that
+ * ->queue() and the prio prep end up on the same SQ.
+ */
+static struct ioring_ring *fio_ioring_select_ring(struct ioring_data *ld,
+						  struct ioring_options *o,
+						  struct io_u *io_u)
+{
+	unsigned int r = 0;
+
+	if (ld->nr_rings > 1) {
+		if (o->ring_select == IORING_RING_FILE)
+			r = io_u->file->fileno % ld->nr_rings;
+		else {
+			r = ld->next_ring;
+			if (++ld->next_ring == ld->nr_rings)
+				ld->next_ring = 0;
+		}
+	}
+
+	ld->io_u_ring[io_u->index] = r;
+	return &ld->rings[r];
+}
+
 static int fio_ioring_prep(struct thread_data *td, struct io_u *io_u)
 {
 	struct ioring_data *ld = td->io_ops_data;
 	struct ioring_options *o = td->eo;
 	struct fio_file *f = io_u->file;
+	struct ioring_ring *ring;
 	struct io_uring_sqe *sqe;
 
-	sqe = &ld->sqes[io_u->index];
+	ring = fio_ioring_select_ring(ld, o, io_u);
+	sqe = ring_sqe(ld, ring, io_u->index);
 
 	if (o->registerfiles) {
-		sqe->fd = f->engine_pos;
+		sqe->fd = f->fileno;
 		sqe->flags = IOSQE_FIXED_FILE;
 	} else {
 		sqe->fd = f->fd;
@@ -309,7 +476,14 @@ static int fio_ioring_prep(struct thread_data *td, struct io_u *io_u)
 	}
 
 	if (io_u->ddir == DDIR_READ || io_u->ddir == DDIR_WRITE) {
-		if (o->fixedbufs) {
+		if (ld->br_entries && io_u->ddir == DDIR_READ) {
+			/* kernel picks the buffer from our group at issue */
+			sqe->opcode = IORING_OP_READ;
+			sqe->addr = 0;
+			sqe->len = io_u->xfer_buflen;
+			sqe->buf_group = 0;
+			sqe->flags |= IOSQE_BUFFER_SELECT;
+		} else if (o->fixedbufs) {
 			sqe->opcode = fixed_ddir_to_op[io_u->ddir];
 			sqe->addr = (unsigned long) io_u->xfer_buf;
 			sqe->len = io_u->xfer_buflen;
@@ -365,18 +539,173 @@ static int fio_ioring_prep(struct thread_data *td, struct io_u *io_u)
 	return 0;
 }
 
+static int fio_ioring_cmd_prep(struct thread_data *td, struct io_u *io_u)
+{
+	struct ioring_data *ld = td->io_ops_data;
+	struct ioring_options *o = td->eo;
+	struct fio_file *f = io_u->file;
+	struct nvme_uring_cmd *cmd;
+	struct ioring_ring *ring;
+	struct io_uring_sqe *sqe;
+
+	/* only supports nvme_uring_cmd */
+	if (o->cmd_type != FIO_URING_CMD_NVME)
+		return -EINVAL;
+
+	ring = fio_ioring_select_ring(ld, o, io_u);
+	sqe = ring_sqe(ld, ring, io_u->index);
+
+	if (o->registerfiles) {
+		sqe->fd = f->fileno;
+		sqe->flags = IOSQE_FIXED_FILE;
+	} else {
+		sqe->fd = f->fd;
+		sqe->flags = 0;
+	}
+	sqe->rw_flags = 0;
+	if (o->fixedbufs && ddir_rw(io_u->ddir)) {
+		sqe->uring_cmd_flags = IORING_URING_CMD_FIXED;
+		sqe->buf_index = io_u->index;
+	}
+
+	if (o->force_async && ++ld->prepped == o->force_async) {
+		ld->prepped = 0;
+		sqe->flags |= IOSQE_ASYNC;
+	}
+
+	sqe->opcode = IORING_OP_URING_CMD;
+	sqe->user_data = (unsigned long) io_u;
+	sqe->cmd_op = NVME_URING_CMD_IO;
+
+	cmd = (struct nvme_uring_cmd *)sqe->cmd;
+	return fio_nvme_uring_cmd_prep(cmd, io_u, &ld->dsm[io_u->index],
+					o->write_zeroes);
+}
+
+static void fio_ioring_bufring_add(struct ioring_data *ld,
+				   struct ioring_ring *ring, unsigned short bid)
+{
+	struct io_uring_buf *buf;
+
+	buf = &ring->br->bufs[ring->br_tail & (ld->br_entries - 1)];
+	buf->addr = (unsigned long) ring->br_bufs + bid * ld->br_bs;
+	buf->len = ld->br_bs;
+	buf->bid = bid;
+	ring->br_tail++;
+}
+
+/*
+ * Give buffers of previously completed reads back to the kernel. Only
+ * called once fio has finished with the io_us that reaped them, which
+ * is anywhere after ios_completed() for a reap pass has returned.
+ */
+static void fio_ioring_bufring_recycle(struct ioring_data *ld)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < ld->nr_rings; i++) {
+		struct ioring_ring *ring = &ld->rings[i];
+
+		if (!ring->br_nr_recycle)
+			continue;
+
+		for (j = 0; j < ring->br_nr_recycle; j++)
+			fio_ioring_bufring_add(ld, ring, ring->br_recycle[j]);
+
+		ring->br_avail += ring->br_nr_recycle;
+		ring->br_nr_recycle = 0;
+		atomic_store_release(&ring->br->tail, ring->br_tail);
+	}
+}
+
+/*
+ * Queue the buffer a read completed into for the next
+ * fio_ioring_bufring_recycle(). Returns false if the read didn't get one.
+ */
+static bool fio_ioring_bufring_done(struct ioring_ring *ring,
+				    struct io_uring_cqe *cqe)
+{
+	if (!(cqe->flags & IORING_CQE_F_BUFFER)) {
+		ring->br_avail++;
+		return false;
+	}
+
+	ring->br_recycle[ring->br_nr_recycle++] =
+		cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+	return true;
+}
+
+/*
+ * Point the io_u at the buffer the kernel picked for this read, so that
+ * verify and friends look at the right data.
+ */
+static void fio_ioring_bufring_adopt(struct ioring_data *ld,
+				     struct ioring_ring *ring,
+				     struct io_u *io_u,
+				     struct io_uring_cqe *cqe)
+{
+	unsigned short bid;
+
+	if (!fio_ioring_bufring_done(ring, cqe))
+		return;
+
+	bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+	io_u->buf = io_u->xfer_buf = ring->br_bufs + bid * ld->br_bs;
+
+	/*
+	 * The remainder of a short read would land in a different buffer,
+	 * fail it instead of handing back split data.
+	 */
+	if (io_u->resid) {
+		io_u->resid = 0;
+		io_u->error = EIO;
+	}
+}
+
 static struct io_u *fio_ioring_event(struct thread_data *td, int event)
 {
 	struct ioring_data *ld = td->io_ops_data;
+	struct ioring_ring *ring = ld->rings;
 	struct io_uring_cqe *cqe;
 	struct io_u *io_u;
 	unsigned index;
 
-	index = (event + ld->cq_ring_off) & ld->cq_ring_mask;
+	/*
+	 * Events are numbered ring by ring, in the order they were reaped
+	 * by the last getevents pass.
+	 */
+	while (event >= ring->reaped) {
+		event -= ring->reaped;
+		ring++;
+	}
 
-	cqe = &ld->cq_ring.cqes[index];
+	index = (event + ring->cq_ring_off) & ring->cq_ring_mask;
+
+	cqe = ring_cqe(ld, ring, index);
 	io_u = (struct io_u *) (uintptr_t) cqe->user_data;
 
+	/*
+	 * Passthrough commands complete with 0 on success, a negative errno
+	 * or a positive NVMe status code otherwise. There's no short IO.
+	 * A zone append returns the lba it was written at in the command
+	 * result.
+	 */
+	if (ld->is_uring_cmd) {
+		if (cqe->res < 0)
+			io_u->error = -cqe->res;
+		else if (cqe->res > 0)
+			io_u->error = EIO;
+		else
+			io_u->error = 0;
+
+		if (!io_u->error && (io_u->flags & IO_U_F_ZONE_APPEND)) {
+			struct nvme_data *data = FILE_ENG_DATA(io_u->file);
+
+			io_u->offset = cqe->big_cqe[0] << data->lba_shift;
+		}
+		return io_u;
+	}
+
 	if (cqe->res != io_u->xfer_buflen) {
 		if (cqe->res > io_u->xfer_buflen)
 			io_u->error = -cqe->res;
@@ -385,53 +714,124 @@ static struct io_u *fio_ioring_event(struct thread_data *td, int event)
 	} else
 		io_u->error = 0;
 
+	if (ld->br_entries && io_u->ddir == DDIR_READ)
+		fio_ioring_bufring_adopt(ld, ring, io_u, cqe);
+
 	return io_u;
 }
 
-static int fio_ioring_cqring_reap(struct thread_data *td, unsigned int events,
+static int fio_ioring_cqring_reap(struct ioring_ring *ring, unsigned int events,
 				   unsigned int max)
 {
-	struct ioring_data *ld = td->io_ops_data;
-	struct io_cq_ring *ring = &ld->cq_ring;
+	struct io_cq_ring *cq_ring = &ring->cq_ring;
 	unsigned head, reaped = 0;
 
-	head = *ring->head;
+	if (events >= max)
+		return 0;
+
+	head = *cq_ring->head;
 	do {
-		if (head == atomic_load_acquire(ring->tail))
+		if (head == atomic_load_acquire(cq_ring->tail))
 			break;
 		reaped++;
 		head++;
 	} while (reaped + events < max);
 
-	if (reaped)
-		atomic_store_release(ring->head, head);
+	if (reaped) {
+		atomic_store_release(cq_ring->head, head);
+		ring->inflight -= reaped;
+	}
 
 	return reaped;
 }
 
+/*
+ * Reap completions to make room when submitting fails with EAGAIN. These
+ * don't go through ->event(), but reads still have to give back the ring
+ * buffers they used.
+ */
+static int fio_ioring_cqring_drop(struct ioring_data *ld,
+				  struct ioring_ring *ring, unsigned int max)
+{
+	unsigned int head, tail, nr = 0;
+
+	if (!ld->br_entries)
+		return fio_ioring_cqring_reap(ring, 0, max);
+
+	head = *ring->cq_ring.head;
+	tail = atomic_load_acquire(ring->cq_ring.tail);
+	for (; head != tail && nr < max; head++, nr++) {
+		struct io_uring_cqe *cqe;
+		struct io_u *io_u;
+
+		cqe = ring_cqe(ld, ring, head & ring->cq_ring_mask);
+		io_u = (struct io_u *) (uintptr_t) cqe->user_data;
+		if (io_u->ddir == DDIR_READ)
+			fio_ioring_bufring_done(ring, cqe);
+	}
+
+	return fio_ioring_cqring_reap(ring, 0, nr);
+}
+
+/*
+ * Nothing to reap on any ring, wait on the one with the most IO pending.
+ * Never ask for more completions than that ring can deliver.
+ */
+static int fio_ioring_wait(struct thread_data *td, unsigned int min)
+{
+	struct ioring_data *ld = td->io_ops_data;
+	struct ioring_ring *ring = ld->rings;
+	unsigned int i;
+
+	for (i = 1; i < ld->nr_rings; i++)
+		if (ld->rings[i].inflight > ring->inflight)
+			ring = &ld->rings[i];
+
+	if (ld->nr_rings > 1 && min > ring->inflight)
+		min = ring->inflight;
+
+	return io_uring_enter(ring, 0, min, IORING_ENTER_GETEVENTS);
+}
+
 static int fio_ioring_getevents(struct thread_data *td, unsigned int min,
 				unsigned int max, const struct timespec *t)
 {
 	struct ioring_data *ld = td->io_ops_data;
 	unsigned actual_min = td->o.iodepth_batch_complete_min == 0 ? 0 : min;
 	struct ioring_options *o = td->eo;
-	struct io_cq_ring *ring = &ld->cq_ring;
 	unsigned events = 0;
+	unsigned int i;
 	int r;
 
-	ld->cq_ring_off = *ring->head;
+	if (ld->br_entries)
+		fio_ioring_bufring_recycle(ld);
+
+	for (i = 0; i < ld->nr_rings; i++) {
+		struct ioring_ring *ring = &ld->rings[i];
+
+		ring->cq_ring_off = *ring->cq_ring.head;
+		ring->reaped = 0;
+	}
+
 	do {
-		r = fio_ioring_cqring_reap(td, events, max);
+		r = 0;
+		for (i = 0; i < ld->nr_rings; i++) {
+			struct ioring_ring *ring = &ld->rings[i];
+			int reaped;
+
+			reaped = fio_ioring_cqring_reap(ring, events + r, max);
+			ring->reaped += reaped;
+			r += reaped;
+		}
 		if (r) {
 			events += r;
 			if (actual_min != 0)
-				actual_min -= r;
+				actual_min -= min(actual_min, (unsigned) r);
 			continue;
 		}
 
 		if (!o->sqpoll_thread) {
-			r = io_uring_enter(ld, 0, actual_min,
-						IORING_ENTER_GETEVENTS);
+			r = fio_ioring_wait(td, actual_min);
 			if (r < 0) {
 				if (errno == EAGAIN || errno == EINTR)
 					continue;
@@ -448,7 +848,8 @@ static void fio_ioring_prio_prep(struct thread_data *td, struct io_u *io_u)
 {
 	struct ioring_options *o = td->eo;
 	struct ioring_data *ld = td->io_ops_data;
-	struct io_uring_sqe *sqe = &ld->sqes[io_u->index];
+	struct ioring_ring *ring = io_u_to_ring(ld, io_u);
+	struct io_uring_sqe *sqe = ring_sqe(ld, ring, io_u->index);
 	struct cmdprio *cmdprio = &o->cmdprio;
 	enum fio_ddir ddir = io_u->ddir;
 	unsigned int p = fio_cmdprio_percentage(cmdprio, io_u);
@@ -485,7 +886,8 @@ static enum fio_q_status fio_ioring_queue(struct thread_data *td,
 					  struct io_u *io_u)
 {
 	struct ioring_data *ld = td->io_ops_data;
-	struct io_sq_ring *ring = &ld->sq_ring;
+	struct ioring_ring *r = io_u_to_ring(ld, io_u);
+	struct io_sq_ring *ring = &r->sq_ring;
 	unsigned tail, next_tail;
 
 	fio_ro_check(td, io_u);
@@ -493,7 +895,7 @@ static enum fio_q_status fio_ioring_queue(struct thread_data *td,
 	if (ld->queued == ld->iodepth)
 		return FIO_Q_BUSY;
 
-	if (io_u->ddir == DDIR_TRIM) {
+	if (io_u->ddir == DDIR_TRIM && !ld->is_uring_cmd) {
 		if (ld->queued)
 			return FIO_Q_BUSY;
 
@@ -508,16 +910,31 @@ static enum fio_q_status fio_ioring_queue(struct thread_data *td,
 	if (next_tail == atomic_load_acquire(ring->head))
 		return FIO_Q_BUSY;
 
+	/*
+	 * Don't issue more buffer selecting reads than there are buffers,
+	 * the kernel would fail them with ENOBUFS.
+	 */
+	if (ld->br_entries && io_u->ddir == DDIR_READ) {
+		if (!r->br_avail)
+			fio_ioring_bufring_recycle(ld);
+		if (!r->br_avail)
+			return FIO_Q_BUSY;
+		r->br_avail--;
+	}
+
 	if (ld->use_cmdprio)
 		fio_ioring_prio_prep(td, io_u);
-	ring->array[tail & ld->sq_ring_mask] = io_u->index;
+	ring->array[tail & r->sq_ring_mask] = io_u->index;
 	atomic_store_release(ring->tail, next_tail);
 
+	r->queued++;
+	r->inflight++;
 	ld->queued++;
 	return FIO_Q_QUEUED;
 }
 
-static void fio_ioring_queued(struct thread_data *td, int start, int nr)
+static void fio_ioring_queued(struct thread_data *td, struct ioring_ring *r,
+			      int start, int nr)
 {
 	struct ioring_data *ld = td->io_ops_data;
 	struct timespec now;
@@ -525,11 +942,11 @@ static void fio_ioring_queued(struct thread_data *td, int start, int nr)
 	if (!fio_fill_issue_time(td))
 		return;
 
-	fio_gettime(&now, NULL);
+	td_batch_gettime(td, &now);
 
 	while (nr--) {
-		struct io_sq_ring *ring = &ld->sq_ring;
-		int index = ring->array[start & ld->sq_ring_mask];
+		struct io_sq_ring *ring = &r->sq_ring;
+		int index = ring->array[start & r->sq_ring_mask];
 		struct io_u *io_u = ld->io_u_index[index];
 
 		memcpy(&io_u->issue_time, &now, sizeof(now));
@@ -539,14 +956,12 @@ static void fio_ioring_queued(struct thread_data *td, int start, int nr)
 	}
 }
 
-static int fio_ioring_commit(struct thread_data *td)
+static int fio_ioring_commit_ring(struct thread_data *td,
+				  struct ioring_ring *r)
 {
 	struct ioring_data *ld = td->io_ops_data;
 	struct ioring_options *o = td->eo;
-	int ret;
-
-	if (!ld->queued)
-		return 0;
+	int ret = 0;
 
 	/*
 	 * Kernel side does submission. just need to check if the ring is
@@ -554,26 +969,28 @@ static int fio_ioring_commit(struct thread_data *td)
 	 * only happens if we've been idle too long.
 	 */
 	if (o->sqpoll_thread) {
-		struct io_sq_ring *ring = &ld->sq_ring;
+		struct io_sq_ring *ring = &r->sq_ring;
 		unsigned flags;
 
 		flags = atomic_load_acquire(ring->flags);
 		if (flags & IORING_SQ_NEED_WAKEUP)
-			io_uring_enter(ld, ld->queued, 0,
+			io_uring_enter(r, r->queued, 0,
 					IORING_ENTER_SQ_WAKEUP);
-		ld->queued = 0;
+		ld->queued -= r->queued;
+		r->queued = 0;
 		return 0;
 	}
 
 	do {
-		unsigned start = *ld->sq_ring.head;
-		long nr = ld->queued;
+		unsigned start = *r->sq_ring.head;
+		long nr = r->queued;
 
-		ret = io_uring_enter(ld, nr, 0, IORING_ENTER_GETEVENTS);
+		ret = io_uring_enter(r, nr, 0, IORING_ENTER_GETEVENTS);
 		if (ret > 0) {
-			fio_ioring_queued(td, start, ret);
+			fio_ioring_queued(td, r, start, ret);
 			io_u_mark_submit(td, ret);
 
+			r->queued -= ret;
 			ld->queued -= ret;
 			ret = 0;
 		} else if (!ret) {
@@ -581,7 +998,7 @@ static int fio_ioring_commit(struct thread_data *td)
 			continue;
 		} else {
 			if (errno == EAGAIN || errno == EINTR) {
-				ret = fio_ioring_cqring_reap(td, 0, ld->queued);
+				ret = fio_ioring_cqring_drop(ld, r, r->queued);
 				if (ret)
 					continue;
 				/* Shouldn't happen */
@@ -591,18 +1008,41 @@ static int fio_ioring_commit(struct thread_data *td)
 			td_verror(td, errno, "io_uring_enter submit");
 			break;
 		}
-	} while (ld->queued);
+	} while (r->queued);
 
 	return ret;
 }
 
-static void fio_ioring_unmap(struct ioring_data *ld)
+static int fio_ioring_commit(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops_data;
+	unsigned int i;
+	int ret;
+
+	if (!ld->queued)
+		return 0;
+
+	for (i = 0; i < ld->nr_rings; i++) {
+		struct ioring_ring *r = &ld->rings[i];
+
+		if (!r->queued)
+			continue;
+
+		ret = fio_ioring_commit_ring(td, r);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static void fio_ioring_unmap(struct ioring_ring *ring)
 {
 	int i;
 
-	for (i = 0; i < FIO_ARRAY_SIZE(ld->mmap); i++)
-		munmap(ld->mmap[i].ptr, ld->mmap[i].len);
-	close(ld->ring_fd);
+	for (i = 0; i < FIO_ARRAY_SIZE(ring->mmap); i++)
+		munmap(ring->mmap[i].ptr, ring->mmap[i].len);
+	close(ring->ring_fd);
 }
 
 static void fio_ioring_cleanup(struct thread_data *td)
@@ -610,9 +1050,38 @@ static void fio_ioring_cleanup(struct thread_data *td)
 	struct ioring_data *ld = td->io_ops_data;
 
 	if (ld) {
-		if (!(td->flags & TD_F_CHILD))
-			fio_ioring_unmap(ld);
+		unsigned int i;
+
+		if (!(td->flags & TD_F_CHILD)) {
+			for (i = 0; i < ld->nr_rings; i++)
+				if (ld->rings[i].ring_fd != -1)
+					fio_ioring_unmap(&ld->rings[i]);
+		}
+
+		if (ld->is_uring_cmd) {
+			struct fio_file *f;
+
+			for_each_file(td, f, i) {
+				free(FILE_ENG_DATA(f));
+				FILE_SET_ENG_DATA(f, NULL);
+			}
+		}
+
+		for (i = 0; i < ld->nr_rings; i++) {
+			struct ioring_ring *ring = &ld->rings[i];
+
+			if (ring->br)
+				fio_memfree(ring->br, ld->br_entries *
+					    sizeof(struct io_uring_buf), false);
+			if (ring->br_bufs)
+				fio_memfree(ring->br_bufs,
+					    ld->br_entries * ld->br_bs, false);
+			free(ring->br_recycle);
+		}
 
+		free(ld->dsm);
+		free(ld->rings);
+		free(ld->io_u_ring);
 		free(ld->io_u_index);
 		free(ld->iovecs);
 		free(ld->fds);
@@ -620,43 +1089,46 @@ static void fio_ioring_cleanup(struct thread_data *td)
 	}
 }
 
-static int fio_ioring_mmap(struct ioring_data *ld, struct io_uring_params *p)
+static int fio_ioring_mmap(struct ioring_data *ld, struct ioring_ring *ring,
+			   struct io_uring_params *p)
 {
-	struct io_sq_ring *sring = &ld->sq_ring;
-	struct io_cq_ring *cring = &ld->cq_ring;
+	struct io_sq_ring *sring = &ring->sq_ring;
+	struct io_cq_ring *cring = &ring->cq_ring;
 	void *ptr;
 
-	ld->mmap[0].len = p->sq_off.array + p->sq_entries * sizeof(__u32);
-	ptr = mmap(0, ld->mmap[0].len, PROT_READ | PROT_WRITE,
-			MAP_SHARED | MAP_POPULATE, ld->ring_fd,
+	ring->mmap[0].len = p->sq_off.array + p->sq_entries * sizeof(__u32);
+	ptr = mmap(0, ring->mmap[0].len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->ring_fd,
 			IORING_OFF_SQ_RING);
-	ld->mmap[0].ptr = ptr;
+	ring->mmap[0].ptr = ptr;
 	sring->head = ptr + p->sq_off.head;
 	sring->tail = ptr + p->sq_off.tail;
 	sring->ring_mask = ptr + p->sq_off.ring_mask;
 	sring->ring_entries = ptr + p->sq_off.ring_entries;
 	sring->flags = ptr + p->sq_off.flags;
 	sring->array = ptr + p->sq_off.array;
-	ld->sq_ring_mask = *sring->ring_mask;
+	ring->sq_ring_mask = *sring->ring_mask;
 
-	ld->mmap[1].len = p->sq_entries * sizeof(struct io_uring_sqe);
-	ld->sqes = mmap(0, ld->mmap[1].len, PROT_READ | PROT_WRITE,
-				MAP_SHARED | MAP_POPULATE, ld->ring_fd,
+	ring->mmap[1].len = (p->sq_entries * sizeof(struct io_uring_sqe)) <<
+				ld->sqe_shift;
+	ring->sqes = mmap(0, ring->mmap[1].len, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ring->ring_fd,
 				IORING_OFF_SQES);
-	ld->mmap[1].ptr = ld->sqes;
+	ring->mmap[1].ptr = ring->sqes;
 
-	ld->mmap[2].len = p->cq_off.cqes +
-				p->cq_entries * sizeof(struct io_uring_cqe);
-	ptr = mmap(0, ld->mmap[2].len, PROT_READ | PROT_WRITE,
-			MAP_SHARED | MAP_POPULATE, ld->ring_fd,
+	ring->mmap[2].len = p->cq_off.cqes +
+				((p->cq_entries * sizeof(struct io_uring_cqe)) <<
+				 ld->cqe_shift);
+	ptr = mmap(0, ring->mmap[2].len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->ring_fd,
 			IORING_OFF_CQ_RING);
-	ld->mmap[2].ptr = ptr;
+	ring->mmap[2].ptr = ptr;
 	cring->head = ptr + p->cq_off.head;
 	cring->tail = ptr + p->cq_off.tail;
 	cring->ring_mask = ptr + p->cq_off.ring_mask;
 	cring->ring_entries = ptr + p->cq_off.ring_entries;
 	cring->cqes = ptr + p->cq_off.cqes;
-	ld->cq_ring_mask = *cring->ring_mask;
+	ring->cq_ring_mask = *cring->ring_mask;
 	return 0;
 }
 
@@ -679,7 +1151,7 @@ static void fio_ioring_probe(struct thread_data *td)
 		return;
 
 	memset(p, 0, sizeof(*p) + 256 * sizeof(struct io_uring_probe_op));
-	ret = syscall(__NR_io_uring_register, ld->ring_fd,
+	ret = syscall(__NR_io_uring_register, ld->rings[0].ring_fd,
 			IORING_REGISTER_PROBE, p, 256);
 	if (ret < 0)
 		goto out;
@@ -694,7 +1166,8 @@ out:
 	free(p);
 }
 
-static int fio_ioring_queue_init(struct thread_data *td)
+static int fio_ioring_ring_init(struct thread_data *td,
+				struct ioring_ring *ring)
 {
 	struct ioring_data *ld = td->io_ops_data;
 	struct ioring_options *o = td->eo;
@@ -713,23 +1186,78 @@ static int fio_ioring_queue_init(struct thread_data *td)
 			p.sq_thread_cpu = o->sqpoll_cpu;
 		}
 	}
+	if (ld->is_uring_cmd)
+		p.flags |= IORING_SETUP_SQE128 | IORING_SETUP_CQE32;
 
 	ret = syscall(__NR_io_uring_setup, depth, &p);
 	if (ret < 0)
 		return ret;
 
-	ld->ring_fd = ret;
+	ring->ring_fd = ret;
 
-	fio_ioring_probe(td);
+	if (ring == ld->rings)
+		fio_ioring_probe(td);
 
 	if (o->fixedbufs) {
-		ret = syscall(__NR_io_uring_register, ld->ring_fd,
+		ret = syscall(__NR_io_uring_register, ring->ring_fd,
 				IORING_REGISTER_BUFFERS, ld->iovecs, depth);
 		if (ret < 0)
 			return ret;
 	}
 
-	return fio_ioring_mmap(ld, &p);
+	return fio_ioring_mmap(ld, ring, &p);
+}
+
+static int fio_ioring_queue_init(struct thread_data *td)
+{
+	struct ioring_data *ld = td->io_ops_data;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < ld->nr_rings; i++) {
+		ret = fio_ioring_ring_init(td, &ld->rings[i]);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int fio_ioring_bufring_init(struct thread_data *td,
+				   struct ioring_ring *ring)
+{
+	struct ioring_data *ld = td->io_ops_data;
+	struct io_uring_buf_reg reg;
+	unsigned int i;
+	int ret;
+
+	ring->br = fio_memalign(page_size,
+				ld->br_entries * sizeof(struct io_uring_buf),
+				false);
+	ring->br_bufs = fio_memalign(page_size, ld->br_entries * ld->br_bs,
+					false);
+	ring->br_recycle = calloc(ld->br_entries, sizeof(unsigned short));
+	if (!ring->br || !ring->br_bufs || !ring->br_recycle) {
+		errno = ENOMEM;
+		return 1;
+	}
+
+	memset(ring->br, 0, ld->br_entries * sizeof(struct io_uring_buf));
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (unsigned long) ring->br;
+	reg.ring_entries = ld->br_entries;
+	reg.bgid = 0;
+
+	ret = syscall(__NR_io_uring_register, ring->ring_fd,
+			IORING_REGISTER_PBUF_RING, &reg, 1);
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < ld->br_entries; i++)
+		fio_ioring_bufring_add(ld, ring, i);
+	ring->br_avail = ld->br_entries;
+	atomic_store_release(&ring->br->tail, ring->br_tail);
+	return 0;
 }
 
 static int fio_ioring_register_files(struct thread_data *td)
@@ -746,11 +1274,14 @@ static int fio_ioring_register_files(struct thread_data *td)
 		if (ret)
 			goto err;
 		ld->fds[i] = f->fd;
-		f->engine_pos = i;
 	}
 
-	ret = syscall(__NR_io_uring_register, ld->ring_fd,
-			IORING_REGISTER_FILES, ld->fds, td->o.nr_files);
+	for (i = 0; i < ld->nr_rings; i++) {
+		ret = syscall(__NR_io_uring_register, ld->rings[i].ring_fd,
+				IORING_REGISTER_FILES, ld->fds, td->o.nr_files);
+		if (ret)
+			break;
+	}
 	if (ret) {
 err:
 		free(ld->fds);
@@ -797,11 +1328,11 @@ static int fio_ioring_post_init(struct thread_data *td)
 		return 1;
 	}
 
-	for (i = 0; i < td->o.iodepth; i++) {
-		struct io_uring_sqe *sqe;
+	for (i = 0; i < ld->nr_rings; i++) {
+		struct ioring_ring *ring = &ld->rings[i];
 
-		sqe = &ld->sqes[i];
-		memset(sqe, 0, sizeof(*sqe));
+		memset(ring->sqes, 0,
+			(td->o.iodepth * sizeof(*ring->sqes)) << ld->sqe_shift);
 	}
 
 	if (o->registerfiles) {
@@ -812,6 +1343,17 @@ static int fio_ioring_post_init(struct thread_data *td)
 		}
 	}
 
+	for (i = 0; ld->br_entries && i < ld->nr_rings; i++) {
+		err = fio_ioring_bufring_init(td, &ld->rings[i]);
+		if (err) {
+			if (errno == EINVAL)
+				log_err("fio: your kernel doesn't support "
+					"provided buffer rings\n");
+			td_verror(td, errno, "ioring_register_pbuf_ring");
+			return 1;
+		}
+	}
+
 	return 0;
 }
 
@@ -821,6 +1363,7 @@ static int fio_ioring_init(struct thread_data *td)
 	struct ioring_data *ld;
 	struct cmdprio *cmdprio = &o->cmdprio;
 	bool has_cmdprio = false;
+	unsigned int i;
 	int ret;
 
 	/* sqthread submission requires registered files */
@@ -833,7 +1376,31 @@ static int fio_ioring_init(struct thread_data *td)
 		return 1;
 	}
 
+	if (o->bufring) {
+		if (!is_power_of_2(o->bufring)) {
+			log_err("fio: io_uring bufring must be a power-of-2\n");
+			return 1;
+		}
+		if (td_write(td) || td_trim(td) || td->o.verify_async) {
+			log_err("fio: io_uring bufring requires a read-only "
+				"workload without verify_async\n");
+			return 1;
+		}
+		if (o->fixedbufs || !strcmp(td->io_ops->name, "io_uring_cmd")) {
+			log_err("fio: io_uring bufring can't be combined with "
+				"fixedbufs or io_uring_cmd\n");
+			return 1;
+		}
+	}
+
+	if (o->write_zeroes && td->o.zone_append) {
+		log_err("fio: io_uring_cmd write_zeroes can't be combined with "
+			"zone_append\n");
+		return 1;
+	}
+
 	ld = calloc(1, sizeof(*ld));
+	ld->is_uring_cmd = !strcmp(td->io_ops->name, "io_uring_cmd");
 
 	/* ring depth must be a power-of-2 */
 	ld->iodepth = td->o.iodepth;
@@ -841,8 +1408,25 @@ static int fio_ioring_init(struct thread_data *td)
 
 	/* io_u index */
 	ld->io_u_index = calloc(td->o.iodepth, sizeof(struct io_u *));
+	ld->io_u_ring = calloc(td->o.iodepth, sizeof(unsigned char));
 	ld->iovecs = calloc(td->o.iodepth, sizeof(struct iovec));
 
+	if (ld->is_uring_cmd) {
+		ld->sqe_shift = 1;
+		ld->cqe_shift = 1;
+		ld->dsm = calloc(td->o.iodepth, sizeof(struct nvme_dsm_range));
+	}
+
+	if (o->bufring) {
+		ld->br_entries = o->bufring;
+		ld->br_bs = td_max_bs(td);
+	}
+
+	ld->nr_rings = o->nr_rings ? o->nr_rings : 1;
+	ld->rings = calloc(ld->nr_rings, sizeof(struct ioring_ring));
+	for (i = 0; i < ld->nr_rings; i++)
+		ld->rings[i].ring_fd = -1;
+
 	td->io_ops_data = ld;
 
 	ret = fio_cmdprio_init(td, cmdprio, &has_cmdprio);
@@ -880,10 +1464,136 @@ static int fio_ioring_open_file(struct thread_data *td, struct fio_file *f)
 	if (!ld || !o->registerfiles)
 		return generic_open_file(td, f);
 
-	f->fd = ld->fds[f->engine_pos];
+	f->fd = ld->fds[f->fileno];
 	return 0;
 }
 
+/*
+ * Look up (once) the namespace-id and LBA format of an NVMe generic char
+ * device, these are needed to build every command for it.
+ */
+static struct nvme_data *fio_ioring_cmd_nvme_data(struct fio_file *f,
+						  __u64 *nlba)
+{
+	struct nvme_data *data = FILE_ENG_DATA(f);
+	__u32 nsid, lba_size = 0;
+	__u64 nr_lbas = 0;
+
+	if (data && !nlba)
+		return data;
+
+	if (fio_nvme_get_info(f, &nsid, &lba_size, &nr_lbas))
+		return NULL;
+
+	if (!data) {
+		data = calloc(1, sizeof(struct nvme_data));
+		data->nsid = nsid;
+		data->lba_shift = __fls(lba_size) - 1;
+		FILE_SET_ENG_DATA(f, data);
+	}
+
+	if (nlba)
+		*nlba = nr_lbas;
+	return data;
+}
+
+static int fio_ioring_cmd_open_file(struct thread_data *td, struct fio_file *f)
+{
+	struct ioring_options *o = td->eo;
+
+	if (o->cmd_type == FIO_URING_CMD_NVME) {
+		struct nvme_data *data;
+		unsigned int lba_size;
+		int ddir;
+
+		data = fio_ioring_cmd_nvme_data(f, NULL);
+		if (!data) {
+			td_verror(td, EINVAL, "fio_ioring_cmd_open_file");
+			return 1;
+		}
+
+		lba_size = 1U << data->lba_shift;
+		for (ddir = 0; ddir < DDIR_RWDIR_CNT; ddir++) {
+			if (td->o.min_bs[ddir] % lba_size ||
+			    td->o.max_bs[ddir] % lba_size) {
+				log_err("%s: block size must be a multiple of "
+					"the LBA data size (%u)\n",
+					f->file_name, lba_size);
+				td_verror(td, EINVAL, "fio_ioring_cmd_open_file");
+				return 1;
+			}
+		}
+	}
+
+	return fio_ioring_open_file(td, f);
+}
+
+static int fio_ioring_cmd_get_file_size(struct thread_data *td,
+					struct fio_file *f)
+{
+	struct ioring_options *o = td->eo;
+
+	if (fio_file_size_known(f))
+		return 0;
+
+	if (o->cmd_type == FIO_URING_CMD_NVME) {
+		struct nvme_data *data;
+		__u64 nlba = 0;
+
+		data = fio_ioring_cmd_nvme_data(f, &nlba);
+		if (!data) {
+			td_verror(td, EINVAL, "fio_ioring_cmd_get_file_size");
+			return 1;
+		}
+
+		f->real_file_size = nlba << data->lba_shift;
+		fio_file_set_size_known(f);
+		return 0;
+	}
+
+	return generic_get_file_size(td, f);
+}
+
+static int fio_ioring_cmd_get_zoned_model(struct thread_data *td,
+					  struct fio_file *f,
+					  enum zbd_zoned_model *model)
+{
+	if (!fio_ioring_cmd_nvme_data(f, NULL))
+		return -EINVAL;
+
+	return fio_nvme_get_zoned_model(td, f, model);
+}
+
+static int fio_ioring_cmd_report_zones(struct thread_data *td,
+				       struct fio_file *f, uint64_t offset,
+				       struct zbd_zone *zbdz,
+				       unsigned int nr_zones)
+{
+	if (!fio_ioring_cmd_nvme_data(f, NULL))
+		return -EINVAL;
+
+	return fio_nvme_report_zones(td, f, offset, zbdz, nr_zones);
+}
+
+static int fio_ioring_cmd_reset_wp(struct thread_data *td, struct fio_file *f,
+				   uint64_t offset, uint64_t length)
+{
+	if (!fio_ioring_cmd_nvme_data(f, NULL))
+		return -EINVAL;
+
+	return fio_nvme_reset_wp(td, f, offset, length);
+}
+
+static int fio_ioring_cmd_get_max_open_zones(struct thread_data *td,
+					     struct fio_file *f,
+					     unsigned int *max_open_zones)
+{
+	if (!fio_ioring_cmd_nvme_data(f, NULL))
+		return -EINVAL;
+
+	return fio_nvme_get_max_open_zones(td, f, max_open_zones);
+}
+
 static int fio_ioring_close_file(struct thread_data *td, struct fio_file *f)
 {
 	struct ioring_data *ld = td->io_ops_data;
@@ -916,13 +1626,40 @@ static struct ioengine_ops ioengine = {
 	.option_struct_size	= sizeof(struct ioring_options),
 };
 
+static struct ioengine_ops ioengine_uring_cmd = {
+	.name			= "io_uring_cmd",
+	.version		= FIO_IOOPS_VERSION,
+	.flags			= FIO_NO_OFFLOAD | FIO_MEMALIGN | FIO_RAWIO |
+				  FIO_ZONE_APPEND,
+	.init			= fio_ioring_init,
+	.post_init		= fio_ioring_post_init,
+	.io_u_init		= fio_ioring_io_u_init,
+	.prep			= fio_ioring_cmd_prep,
+	.queue			= fio_ioring_queue,
+	.commit			= fio_ioring_commit,
+	.getevents		= fio_ioring_getevents,
+	.event			= fio_ioring_event,
+	.cleanup		= fio_ioring_cleanup,
+	.open_file		= fio_ioring_cmd_open_file,
+	.close_file		= fio_ioring_close_file,
+	.get_file_size		= fio_ioring_cmd_get_file_size,
+	.get_zoned_model	= fio_ioring_cmd_get_zoned_model,
+	.report_zones		= fio_ioring_cmd_report_zones,
+	.reset_wp		= fio_ioring_cmd_reset_wp,
+	.get_max_open_zones	= fio_ioring_cmd_get_max_open_zones,
+	.options		= options,
+	.option_struct_size	= sizeof(struct ioring_options),
+};
+
 static void fio_init fio_ioring_register(void)
 {
 	register_ioengine(&ioengine);
+	register_ioengine(&ioengine_uring_cmd);
 }
 
 static void fio_exit fio_ioring_unregister(void)
 {
 	unregister_ioengine(&ioengine);
+	unregister_ioengine(&ioengine_uring_cmd);
 }
 #endif
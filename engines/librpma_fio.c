@@ -610,7 +610,7 @@ int librpma_fio_client_commit(struct thread_data *td)
 	}
 
 	if ((fill_time = fio_fill_issue_time(td)))
-		fio_gettime(&now, NULL);
+		td_batch_gettime(td, &now);
 
 	/* move executed io_us from queued[] to flight[] */
 	for (i = 0; i < ccd->io_u_queued_nr; i++) {
@@ -0,0 +1,386 @@
+/*
+ * nvme structure declarations and helper functions for the
+ * io_uring_cmd engine.
+ */
+
+#include "nvme.h"
+
+static inline __u64 get_slba(struct nvme_data *data, struct io_u *io_u)
+{
+	return io_u->offset >> data->lba_shift;
+}
+
+static inline __u32 get_nlb(struct nvme_data *data, struct io_u *io_u)
+{
+	return io_u->xfer_buflen >> data->lba_shift;
+}
+
+int fio_nvme_uring_cmd_prep(struct nvme_uring_cmd *cmd, struct io_u *io_u,
+			    struct nvme_dsm_range *dsm, bool write_zeroes)
+{
+	struct nvme_data *data = FILE_ENG_DATA(io_u->file);
+	__u64 slba;
+	__u32 nlb;
+
+	memset(cmd, 0, sizeof(struct nvme_uring_cmd));
+	cmd->nsid = data->nsid;
+
+	switch (io_u->ddir) {
+	case DDIR_READ:
+		cmd->opcode = nvme_cmd_read;
+		break;
+	case DDIR_WRITE:
+		if (io_u->flags & IO_U_F_ZONE_APPEND)
+			cmd->opcode = nvme_cmd_zone_append;
+		else if (write_zeroes)
+			cmd->opcode = nvme_cmd_write_zeroes;
+		else
+			cmd->opcode = nvme_cmd_write;
+		break;
+	case DDIR_TRIM:
+		cmd->opcode = nvme_cmd_dsm;
+		break;
+	case DDIR_SYNC:
+	case DDIR_DATASYNC:
+	case DDIR_SYNC_FILE_RANGE:
+		cmd->opcode = nvme_cmd_flush;
+		return 0;
+	default:
+		return -ENOTSUP;
+	}
+
+	/* zone appends address the zone, the device picks the lba */
+	if (cmd->opcode == nvme_cmd_zone_append)
+		slba = zbd_zone_start(io_u->file, io_u->offset) >> data->lba_shift;
+	else
+		slba = get_slba(data, io_u);
+	nlb = get_nlb(data, io_u);
+
+	if (io_u->ddir == DDIR_TRIM) {
+		/* a single deallocate range per command */
+		dsm->cattr = 0;
+		dsm->nlb = nlb;
+		dsm->slba = slba;
+
+		cmd->cdw10 = 0;
+		cmd->cdw11 = NVME_DSMGMT_AD;
+		cmd->addr = (__u64)(uintptr_t)dsm;
+		cmd->data_len = sizeof(*dsm);
+		return 0;
+	}
+
+	/* cdw10 and cdw11 represent starting lba */
+	cmd->cdw10 = slba & 0xffffffff;
+	cmd->cdw11 = slba >> 32;
+	/* cdw12 represent number of lba's for read/write, 0's based */
+	cmd->cdw12 = nlb - 1;
+
+	/* write zeroes carries no data */
+	if (cmd->opcode != nvme_cmd_write_zeroes) {
+		cmd->addr = (__u64)(uintptr_t)io_u->xfer_buf;
+		cmd->data_len = io_u->xfer_buflen;
+	}
+	return 0;
+}
+
+static int nvme_identify(int fd, __u32 nsid, enum nvme_identify_cns cns,
+			 enum nvme_csi csi, void *data)
+{
+	struct nvme_passthru_cmd cmd = {
+		.opcode         = nvme_admin_identify,
+		.nsid           = nsid,
+		.addr           = (__u64)(uintptr_t)data,
+		.data_len       = NVME_IDENTIFY_DATA_SIZE,
+		.cdw10          = cns,
+		.cdw11          = csi << NVME_IDENTIFY_CSI_SHIFT,
+		.timeout_ms     = NVME_DEFAULT_IOCTL_TIMEOUT,
+	};
+
+	return ioctl(fd, NVME_IOCTL_ADMIN_CMD, &cmd);
+}
+
+int fio_nvme_get_info(struct fio_file *f, __u32 *nsid, __u32 *lba_sz,
+		      __u64 *nlba)
+{
+	struct nvme_id_ns ns;
+	int namespace_id;
+	int fd, err;
+
+	if (f->filetype != FIO_TYPE_CHAR) {
+		log_err("ioengine io_uring_cmd only works with nvme ns "
+			"generic char devices (/dev/ngXnY)\n");
+		return 1;
+	}
+
+	fd = open(f->file_name, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	namespace_id = ioctl(fd, NVME_IOCTL_ID);
+	if (namespace_id < 0) {
+		err = -errno;
+		log_err("failed to fetch namespace-id\n");
+		close(fd);
+		return err;
+	}
+
+	/*
+	 * Identify namespace to get namespace-id, namespace size in LBA's
+	 * and LBA data size.
+	 */
+	err = nvme_identify(fd, namespace_id, NVME_IDENTIFY_CNS_NS,
+				NVME_CSI_NVM, &ns);
+	if (err) {
+		log_err("failed to fetch identify namespace\n");
+		close(fd);
+		return err;
+	}
+
+	*nsid = namespace_id;
+	*lba_sz = 1 << ns.lbaf[(ns.flbas & 0x0f)].ds;
+	*nlba = ns.nsze;
+
+	close(fd);
+	return 0;
+}
+
+static int nvme_io_cmd(int fd, struct nvme_passthru_cmd *cmd)
+{
+	int ret;
+
+	ret = ioctl(fd, NVME_IOCTL_IO_CMD, cmd);
+	if (ret < 0)
+		return -errno;
+	/* an NVMe status */
+	if (ret > 0)
+		return -EIO;
+	return 0;
+}
+
+/*
+ * Read the zoned namespace parameters of @f. Returns 1 if the namespace
+ * isn't zoned.
+ */
+static int nvme_zns_identify(int fd, struct nvme_data *data,
+			     struct nvme_zns_id_ns *zns_ns)
+{
+	struct nvme_id_ns ns;
+	int ret;
+
+	ret = nvme_identify(fd, data->nsid, NVME_IDENTIFY_CNS_NS, NVME_CSI_NVM,
+			    &ns);
+	if (ret < 0)
+		return -errno;
+	if (ret)
+		return -EIO;
+
+	ret = nvme_identify(fd, data->nsid, NVME_IDENTIFY_CNS_CSI_NS,
+			    NVME_CSI_ZNS, zns_ns);
+	if (ret < 0)
+		return -errno;
+	if (ret)
+		return 1;
+
+	data->zone_size = zns_ns->lbafe[ns.flbas & 0x0f].zsze <<
+				data->lba_shift;
+	return 0;
+}
+
+int fio_nvme_get_zoned_model(struct thread_data *td, struct fio_file *f,
+			     enum zbd_zoned_model *model)
+{
+	struct nvme_data *data = FILE_ENG_DATA(f);
+	struct nvme_zns_id_ns zns_ns;
+	int fd, ret;
+
+	if (f->filetype != FIO_TYPE_CHAR)
+		return -EINVAL;
+
+	fd = open(f->file_name, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	ret = nvme_zns_identify(fd, data, &zns_ns);
+	if (ret >= 0) {
+		*model = ret ? ZBD_NONE : ZBD_HOST_MANAGED;
+		ret = 0;
+	}
+
+	close(fd);
+	return ret;
+}
+
+int fio_nvme_get_max_open_zones(struct thread_data *td, struct fio_file *f,
+				unsigned int *max_open_zones)
+{
+	struct nvme_data *data = FILE_ENG_DATA(f);
+	struct nvme_zns_id_ns zns_ns;
+	__u32 mor;
+	int fd, ret;
+
+	fd = open(f->file_name, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	ret = nvme_zns_identify(fd, data, &zns_ns);
+	if (ret > 0)
+		ret = -EINVAL;
+	if (!ret) {
+		/* 0's based, all ones means no limit */
+		mor = zns_ns.mor;
+		*max_open_zones = mor == 0xffffffff ? 0 : mor + 1;
+	}
+
+	close(fd);
+	return ret;
+}
+
+/* descriptors per zone management receive */
+#define NVME_REPORT_ZONES_MAX	512U
+
+int fio_nvme_report_zones(struct thread_data *td, struct fio_file *f,
+			  uint64_t offset, struct zbd_zone *zbdz,
+			  unsigned int nr_zones)
+{
+	struct nvme_data *data = FILE_ENG_DATA(f);
+	struct nvme_zone_report *zr;
+	struct nvme_zns_id_ns zns_ns;
+	struct nvme_passthru_cmd cmd;
+	__u64 slba = offset >> data->lba_shift;
+	unsigned int i, nr;
+	size_t zr_len;
+	int fd, ret;
+
+	fd = open(f->file_name, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	if (!data->zone_size) {
+		ret = nvme_zns_identify(fd, data, &zns_ns);
+		if (ret > 0)
+			ret = -EINVAL;
+		if (ret)
+			goto out;
+	}
+
+	nr_zones = min(nr_zones, NVME_REPORT_ZONES_MAX);
+	zr_len = sizeof(*zr) + nr_zones * sizeof(struct nvme_zns_desc);
+	zr = calloc(1, zr_len);
+	if (!zr) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.opcode = nvme_cmd_zone_mgmt_recv;
+	cmd.nsid = data->nsid;
+	cmd.addr = (__u64)(uintptr_t)zr;
+	cmd.data_len = zr_len;
+	cmd.cdw10 = slba & 0xffffffff;
+	cmd.cdw11 = slba >> 32;
+	/* buffer size in dwords, 0's based */
+	cmd.cdw12 = (zr_len >> 2) - 1;
+	cmd.cdw13 = NVME_ZNS_ZRA_REPORT_ZONES | NVME_ZNS_ZRAS_PARTIAL;
+	cmd.timeout_ms = NVME_DEFAULT_IOCTL_TIMEOUT;
+
+	ret = nvme_io_cmd(fd, &cmd);
+	if (ret) {
+		log_err("%s: zone management receive failed (%d)\n",
+			f->file_name, ret);
+		goto out_free;
+	}
+
+	nr = min((uint64_t) nr_zones, (uint64_t) zr->nr_zones);
+	for (i = 0; i < nr; i++, zbdz++) {
+		struct nvme_zns_desc *desc = &zr->entries[i];
+
+		zbdz->start = desc->zslba << data->lba_shift;
+		zbdz->len = data->zone_size;
+		zbdz->capacity = desc->zcap << data->lba_shift;
+		zbdz->wp = desc->wp << data->lba_shift;
+
+		if (desc->zt != NVME_ZONE_TYPE_SEQWRITE_REQ) {
+			log_err("%s: invalid type for zone at lba %llu\n",
+				f->file_name,
+				(unsigned long long) desc->zslba);
+			ret = -EIO;
+			goto out_free;
+		}
+		zbdz->type = ZBD_ZONE_TYPE_SWR;
+
+		/* the zone state values are the same as the zbd ones */
+		switch (desc->zs >> 4) {
+		case ZBD_ZONE_COND_EMPTY:
+		case ZBD_ZONE_COND_IMP_OPEN:
+		case ZBD_ZONE_COND_EXP_OPEN:
+		case ZBD_ZONE_COND_CLOSED:
+			zbdz->cond = desc->zs >> 4;
+			break;
+		case ZBD_ZONE_COND_FULL:
+			zbdz->cond = ZBD_ZONE_COND_FULL;
+			zbdz->wp = zbdz->start + zbdz->len;
+			break;
+		default:
+			/* read only and offline zones aren't used */
+			zbdz->cond = ZBD_ZONE_COND_OFFLINE;
+			zbdz->wp = zbdz->start;
+			break;
+		}
+	}
+	ret = nr;
+
+out_free:
+	free(zr);
+out:
+	close(fd);
+	return ret;
+}
+
+int fio_nvme_reset_wp(struct thread_data *td, struct fio_file *f,
+		      uint64_t offset, uint64_t length)
+{
+	struct nvme_data *data = FILE_ENG_DATA(f);
+	struct nvme_zns_id_ns zns_ns;
+	struct nvme_passthru_cmd cmd;
+	uint64_t end = offset + length;
+	int fd, ret = 0;
+
+	fd = f->fd;
+	if (fd < 0) {
+		fd = open(f->file_name, O_RDWR);
+		if (fd < 0)
+			return -errno;
+	}
+
+	if (!data->zone_size) {
+		ret = nvme_zns_identify(fd, data, &zns_ns);
+		if (ret > 0)
+			ret = -EINVAL;
+		if (ret)
+			goto out;
+	}
+
+	for (; offset < end; offset += data->zone_size) {
+		__u64 slba = offset >> data->lba_shift;
+
+		memset(&cmd, 0, sizeof(cmd));
+		cmd.opcode = nvme_cmd_zone_mgmt_send;
+		cmd.nsid = data->nsid;
+		cmd.cdw10 = slba & 0xffffffff;
+		cmd.cdw11 = slba >> 32;
+		cmd.cdw13 = NVME_ZNS_ZSA_RESET;
+		cmd.timeout_ms = NVME_DEFAULT_IOCTL_TIMEOUT;
+
+		ret = nvme_io_cmd(fd, &cmd);
+		if (ret) {
+			log_err("%s: zone reset at lba %llu failed (%d)\n",
+				f->file_name, (unsigned long long) slba, ret);
+			break;
+		}
+	}
+
+out:
+	if (fd != f->fd)
+		close(fd);
+	return ret;
+}
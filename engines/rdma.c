@@ -820,7 +820,7 @@ static void fio_rdmaio_queued(struct thread_data *td, struct io_u **io_us,
 	if (!fio_fill_issue_time(td))
 		return;
 
-	fio_gettime(&now, NULL);
+	td_batch_gettime(td, &now);
 
 	for (i = 0; i < nr; i++) {
 		struct io_u *io_u = io_us[i];
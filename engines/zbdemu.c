@@ -0,0 +1,743 @@
+/*
+ * zbdemu engine
+ *
+ * IO engine that emulates a zoned block device on top of a regular file,
+ * for exercising zonemode=zbd without a zoned drive. The zone state lives
+ * in a second file next to the data file, <filename>.zbdemu, that is
+ * mapped shared by all jobs using the file and kept across runs, like the
+ * zone state of a real drive.
+ *
+ * Writes to sequential zones must start at the write pointer (host-managed)
+ * and must not cross the zone capacity. Writing to an empty or closed zone
+ * implicitly opens it, within the open and active zone limits. Zone
+ * appends are written at the write pointer and report where they went.
+ * Reads past the write pointer return zeroes. Zone resets and zone
+ * finishes can be given a latency.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../fio.h"
+#include "../optgroup.h"
+#include "../zbd.h"
+
+#define ZBDEMU_MAGIC		0x7a6264656d750001ULL
+#define ZBDEMU_ZONE_SIZE	(256ULL * 1024 * 1024)
+
+struct zbdemu_hdr {
+	uint64_t magic;
+	uint64_t zone_size;
+	uint64_t zone_capacity;
+	uint32_t nr_zones;
+	uint32_t nr_conv;
+	uint32_t nr_open;
+	uint32_t nr_active;
+};
+
+struct zbdemu_zone {
+	uint64_t wp;
+	uint32_t cond;
+	uint32_t pad;
+};
+
+struct zbdemu_file {
+	int fd;
+	size_t map_len;
+	struct zbdemu_hdr *hdr;
+	struct zbdemu_zone *zones;
+};
+
+struct zbdemu_options {
+	void *pad;
+	unsigned int model;
+	unsigned int conv_zones;
+	unsigned int max_open;
+	unsigned int max_active;
+	unsigned int reset_lat;
+	unsigned int finish_lat;
+};
+
+static struct fio_option options[] = {
+	{
+		.name	= "zbdemu_model",
+		.lname	= "Emulated zoned model",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct zbdemu_options, model),
+		.help	= "Zoned model of the emulated drive",
+		.def	= "host-managed",
+		.posval = {
+			  { .ival = "host-managed",
+			    .oval = ZBD_HOST_MANAGED,
+			    .help = "Writes must be at the write pointer",
+			  },
+			  { .ival = "host-aware",
+			    .oval = ZBD_HOST_AWARE,
+			    .help = "Writes anywhere, the write pointer follows",
+			  },
+		},
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_ZBDEMU,
+	},
+	{
+		.name	= "zbdemu_conv_zones",
+		.lname	= "Emulated conventional zones",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct zbdemu_options, conv_zones),
+		.help	= "Number of conventional zones at the start of the file",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_ZBDEMU,
+	},
+	{
+		.name	= "zbdemu_max_open_zones",
+		.lname	= "Emulated max open zones",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct zbdemu_options, max_open),
+		.maxval	= ZBD_MAX_OPEN_ZONES,
+		.help	= "Open zone limit of the emulated drive (0 = none)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_ZBDEMU,
+	},
+	{
+		.name	= "zbdemu_max_active_zones",
+		.lname	= "Emulated max active zones",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct zbdemu_options, max_active),
+		.help	= "Active zone limit of the emulated drive (0 = none)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_ZBDEMU,
+	},
+	{
+		.name	= "zbdemu_reset_lat",
+		.lname	= "Emulated zone reset latency",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct zbdemu_options, reset_lat),
+		.help	= "Time it takes to reset a zone (usec)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_ZBDEMU,
+	},
+	{
+		.name	= "zbdemu_finish_lat",
+		.lname	= "Emulated zone finish latency",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct zbdemu_options, finish_lat),
+		.help	= "Time added to the write that fills a zone (usec)",
+		.def	= "0",
+		.category = FIO_OPT_C_ENGINE,
+		.group	= FIO_OPT_G_ZBDEMU,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+static void zbdemu_lock(struct zbdemu_file *zf)
+{
+	while (flock(zf->fd, LOCK_EX) < 0 && errno == EINTR)
+		;
+}
+
+static void zbdemu_unlock(struct zbdemu_file *zf)
+{
+	flock(zf->fd, LOCK_UN);
+}
+
+static void zbdemu_init_state(struct zbdemu_hdr *hdr, struct zbdemu_zone *zones,
+			      uint64_t zone_size, uint64_t zone_capacity,
+			      uint32_t nr_zones, uint32_t nr_conv)
+{
+	uint32_t i;
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->zone_size = zone_size;
+	hdr->zone_capacity = zone_capacity;
+	hdr->nr_zones = nr_zones;
+	hdr->nr_conv = nr_conv;
+
+	for (i = 0; i < nr_zones; i++) {
+		zones[i].wp = i * zone_size;
+		zones[i].cond = i < nr_conv ?
+			ZBD_ZONE_COND_NOT_WP : ZBD_ZONE_COND_EMPTY;
+		zones[i].pad = 0;
+	}
+
+	hdr->magic = ZBDEMU_MAGIC;
+}
+
+/*
+ * Map the zone state of @f, creating it if it doesn't exist yet. Other jobs
+ * may be using the state already, so one made for another zone layout is
+ * an error rather than something to start over from.
+ */
+static struct zbdemu_file *zbdemu_get(struct thread_data *td,
+				      struct fio_file *f)
+{
+	struct zbdemu_options *o = td->eo;
+	struct zbdemu_file *zf = FILE_ENG_DATA(f);
+	uint64_t zone_size = td->o.zone_size ?: ZBDEMU_ZONE_SIZE;
+	uint64_t zone_capacity = td->o.zone_capacity ?: zone_size;
+	uint32_t nr_zones;
+	char path[PATH_MAX];
+	size_t map_len;
+	struct stat st;
+	void *p;
+
+	if (zf)
+		return zf;
+
+	if (zone_capacity > zone_size) {
+		log_err("%s: zone capacity %llu larger than zone size %llu\n",
+			f->file_name, (unsigned long long) zone_capacity,
+			(unsigned long long) zone_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	nr_zones = f->real_file_size / zone_size;
+	if (!nr_zones || o->conv_zones >= nr_zones) {
+		log_err("%s: file size %llu too small for %u conventional and one sequential zone of %llu bytes\n",
+			f->file_name, (unsigned long long) f->real_file_size,
+			o->conv_zones, (unsigned long long) zone_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	zf = calloc(1, sizeof(*zf));
+	if (!zf)
+		return NULL;
+
+	snprintf(path, sizeof(path), "%s.zbdemu", f->file_name);
+	zf->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (zf->fd < 0) {
+		log_err("%s: failed to open zone state file %s: %s\n",
+			f->file_name, path, strerror(errno));
+		goto err;
+	}
+
+	map_len = sizeof(*zf->hdr) + nr_zones * sizeof(*zf->zones);
+	zf->map_len = map_len;
+
+	zbdemu_lock(zf);
+	if (fstat(zf->fd, &st) < 0)
+		goto err_unlock;
+	if (!st.st_size) {
+		if (ftruncate(zf->fd, zf->map_len) < 0)
+			goto err_unlock;
+	} else if (st.st_size < sizeof(*zf->hdr)) {
+		errno = EINVAL;
+		goto err_unlock;
+	} else if (st.st_size != zf->map_len) {
+		/* made for another layout, reported below */
+		zf->map_len = st.st_size;
+	}
+
+	p = mmap(NULL, zf->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+		 zf->fd, 0);
+	if (p == MAP_FAILED)
+		goto err_unlock;
+
+	zf->hdr = p;
+	zf->zones = p + sizeof(*zf->hdr);
+	if (zf->hdr->magic != ZBDEMU_MAGIC) {
+		dprint(FD_ZBD, "%s: new zone state, %u zones of %llu bytes\n",
+		       f->file_name, nr_zones,
+		       (unsigned long long) zone_size);
+		zbdemu_init_state(zf->hdr, zf->zones, zone_size, zone_capacity,
+				  nr_zones, o->conv_zones);
+	} else if (zf->map_len != map_len ||
+		   zf->hdr->zone_size != zone_size ||
+		   zf->hdr->zone_capacity != zone_capacity ||
+		   zf->hdr->nr_zones != nr_zones ||
+		   zf->hdr->nr_conv != o->conv_zones) {
+		log_err("%s: zone state %s is for %u zones (%u conventional) of %llu bytes, capacity %llu, not %u (%u) of %llu, capacity %llu. Remove it to start over.\n",
+			f->file_name, path, zf->hdr->nr_zones,
+			zf->hdr->nr_conv,
+			(unsigned long long) zf->hdr->zone_size,
+			(unsigned long long) zf->hdr->zone_capacity,
+			nr_zones, o->conv_zones,
+			(unsigned long long) zone_size,
+			(unsigned long long) zone_capacity);
+		zbdemu_unlock(zf);
+		munmap(p, zf->map_len);
+		close(zf->fd);
+		free(zf);
+		errno = EINVAL;
+		return NULL;
+	}
+	zbdemu_unlock(zf);
+
+	FILE_SET_ENG_DATA(f, zf);
+	return zf;
+
+err_unlock:
+	log_err("%s: failed to map zone state file %s: %s\n",
+		f->file_name, path, strerror(errno));
+	zbdemu_unlock(zf);
+	close(zf->fd);
+err:
+	free(zf);
+	return NULL;
+}
+
+static void zbdemu_put(struct fio_file *f)
+{
+	struct zbdemu_file *zf = FILE_ENG_DATA(f);
+
+	if (!zf)
+		return;
+
+	munmap(zf->hdr, zf->map_len);
+	close(zf->fd);
+	free(zf);
+	FILE_SET_ENG_DATA(f, NULL);
+}
+
+static bool zbdemu_is_seq(struct zbdemu_file *zf, uint32_t zno)
+{
+	return zno >= zf->hdr->nr_conv;
+}
+
+/*
+ * Implicitly open zone @z. If the open zone limit is reached, close another
+ * implicitly opened zone to make room, as drives do. The caller must hold
+ * the zone state lock.
+ */
+static int zbdemu_open_zone(struct zbdemu_options *o, struct zbdemu_file *zf,
+			    struct zbdemu_zone *z)
+{
+	struct zbdemu_hdr *hdr = zf->hdr;
+	uint32_t i;
+
+	if (z->cond == ZBD_ZONE_COND_EMPTY) {
+		if (o->max_active && hdr->nr_active >= o->max_active)
+			return -EOVERFLOW;
+	}
+
+	if (o->max_open && hdr->nr_open >= o->max_open) {
+		for (i = hdr->nr_conv; i < hdr->nr_zones; i++) {
+			if (zf->zones[i].cond == ZBD_ZONE_COND_IMP_OPEN)
+				break;
+		}
+		if (i == hdr->nr_zones)
+			return -ETOOMANYREFS;
+
+		zf->zones[i].cond = ZBD_ZONE_COND_CLOSED;
+		hdr->nr_open--;
+	}
+
+	if (z->cond == ZBD_ZONE_COND_EMPTY)
+		hdr->nr_active++;
+	hdr->nr_open++;
+	z->cond = ZBD_ZONE_COND_IMP_OPEN;
+	return 0;
+}
+
+/*
+ * Check a write to sequential zone @zno against the zone state and move the
+ * write pointer past it. Returns 0 or a negative error.
+ */
+static int zbdemu_zone_write(struct thread_data *td, struct zbdemu_file *zf,
+			     uint32_t zno, uint64_t offset, uint64_t len)
+{
+	struct zbdemu_options *o = td->eo;
+	struct zbdemu_zone *z = &zf->zones[zno];
+	const uint64_t cap_end = zno * zf->hdr->zone_size +
+					zf->hdr->zone_capacity;
+	uint64_t wp, end = offset + len;
+	bool finish = false;
+	int ret = 0;
+
+	if (end > cap_end)
+		return -EIO;
+
+	/*
+	 * Appending to an open zone without filling it is the common case
+	 * and doesn't need the lock.
+	 */
+	if (o->model == ZBD_HOST_MANAGED &&
+	    atomic_load_acquire(&z->cond) == ZBD_ZONE_COND_IMP_OPEN &&
+	    end < cap_end && __sync_bool_compare_and_swap(&z->wp, offset, end))
+		return 0;
+
+	zbdemu_lock(zf);
+	switch (z->cond) {
+	case ZBD_ZONE_COND_EMPTY:
+	case ZBD_ZONE_COND_CLOSED:
+		ret = zbdemu_open_zone(o, zf, z);
+		if (ret)
+			goto out;
+		break;
+	case ZBD_ZONE_COND_IMP_OPEN:
+		break;
+	case ZBD_ZONE_COND_FULL:
+		/* Host-aware drives take random writes to full zones */
+		if (o->model == ZBD_HOST_AWARE)
+			goto out;
+		/* fall through */
+	default:
+		ret = -EIO;
+		goto out;
+	}
+
+	do {
+		wp = z->wp;
+		if (o->model == ZBD_HOST_MANAGED && wp != offset) {
+			dprint(FD_ZBD, "zbdemu: unaligned write %llu, wp %llu\n",
+			       (unsigned long long) offset,
+			       (unsigned long long) wp);
+			ret = -EIO;
+			goto out;
+		}
+	} while (wp < end && !__sync_bool_compare_and_swap(&z->wp, wp, end));
+
+	if (z->wp == cap_end) {
+		z->cond = ZBD_ZONE_COND_FULL;
+		zf->hdr->nr_open--;
+		zf->hdr->nr_active--;
+		finish = true;
+	}
+out:
+	zbdemu_unlock(zf);
+
+	if (finish && o->finish_lat)
+		usec_sleep(td, o->finish_lat);
+
+	return ret;
+}
+
+/*
+ * Zone append: write at the write pointer of sequential zone @zno, whatever
+ * it is, and return that offset in @offset.
+ */
+static int zbdemu_zone_append(struct thread_data *td, struct zbdemu_file *zf,
+			      uint32_t zno, uint64_t len, uint64_t *offset)
+{
+	struct zbdemu_zone *z = &zf->zones[zno];
+	int ret;
+
+	do {
+		*offset = atomic_load_acquire(&z->wp);
+		ret = zbdemu_zone_write(td, zf, zno, *offset, len);
+	} while (ret == -EIO && atomic_load_acquire(&z->wp) != *offset);
+
+	return ret;
+}
+
+static int zbdemu_rw(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	struct zbdemu_file *zf;
+	uint64_t offset = io_u->offset;
+	unsigned long long len = io_u->xfer_buflen;
+	uint32_t zno;
+	ssize_t ret;
+
+	zf = zbdemu_get(td, f);
+	if (!zf)
+		return -errno;
+
+	zno = offset / zf->hdr->zone_size;
+	if (zno >= zf->hdr->nr_zones)
+		return -EIO;
+
+	if (io_u->ddir == DDIR_WRITE) {
+		if (zbdemu_is_seq(zf, zno) &&
+		    (io_u->flags & IO_U_F_ZONE_APPEND)) {
+			ret = zbdemu_zone_append(td, zf, zno, len, &offset);
+			if (ret)
+				return ret;
+			io_u->offset = offset;
+		} else if (zbdemu_is_seq(zf, zno)) {
+			ret = zbdemu_zone_write(td, zf, zno, offset, len);
+			if (ret)
+				return ret;
+		}
+		ret = pwrite(f->fd, io_u->xfer_buf, len, offset);
+	} else {
+		ret = pread(f->fd, io_u->xfer_buf, len, offset);
+	}
+
+	if (ret < 0)
+		return -errno;
+	if (ret != len)
+		io_u->resid = len - ret;
+
+	/*
+	 * Nothing has been written past the write pointer
+	 */
+	if (io_u->ddir == DDIR_READ && zbdemu_is_seq(zf, zno)) {
+		uint64_t wp = atomic_load_acquire(&zf->zones[zno].wp);
+
+		if (offset + len > wp) {
+			uint64_t skip = wp > offset ? wp - offset : 0;
+
+			memset(io_u->xfer_buf + skip, 0, len - skip);
+		}
+	}
+
+	return 0;
+}
+
+static enum fio_q_status zbdemu_queue(struct thread_data *td,
+				      struct io_u *io_u)
+{
+	int ret;
+
+	fio_ro_check(td, io_u);
+
+	if (io_u->ddir == DDIR_READ || io_u->ddir == DDIR_WRITE)
+		ret = zbdemu_rw(td, io_u);
+	else if (ddir_sync(io_u->ddir))
+		ret = do_io_u_sync(td, io_u) < 0 ? -io_u->error : 0;
+	else if (io_u->ddir == DDIR_TRIM) {
+		/* Trims of conventional zones are a no-op */
+		ret = zbd_do_io_u_trim(td, io_u);
+		if (ret > 0)
+			ret = 0;
+	} else
+		ret = -EINVAL;
+
+	if (ret < 0) {
+		io_u->error = -ret;
+		td_verror(td, io_u->error, "xfer");
+	}
+
+	return FIO_Q_COMPLETED;
+}
+
+static int zbdemu_get_zoned_model(struct thread_data *td, struct fio_file *f,
+				  enum zbd_zoned_model *model)
+{
+	struct zbdemu_options *o = td->eo;
+
+	if (f->filetype != FIO_TYPE_FILE) {
+		log_err("%s: ioengine zbdemu only works on regular files\n",
+			f->file_name);
+		return -EINVAL;
+	}
+
+	*model = o->model;
+	return 0;
+}
+
+static int zbdemu_report_zones(struct thread_data *td, struct fio_file *f,
+			       uint64_t offset, struct zbd_zone *zbdz,
+			       unsigned int nr_zones)
+{
+	struct zbdemu_options *o = td->eo;
+	struct zbdemu_file *zf;
+	struct zbdemu_hdr *hdr;
+	uint32_t zno;
+	unsigned int i;
+
+	zf = zbdemu_get(td, f);
+	if (!zf)
+		return -errno;
+
+	hdr = zf->hdr;
+	zno = offset / hdr->zone_size;
+
+	zbdemu_lock(zf);
+	for (i = 0; i < nr_zones && zno < hdr->nr_zones; i++, zno++, zbdz++) {
+		struct zbdemu_zone *z = &zf->zones[zno];
+
+		zbdz->start = zno * hdr->zone_size;
+		zbdz->len = hdr->zone_size;
+		zbdz->wp = z->wp;
+		if (zbdemu_is_seq(zf, zno)) {
+			zbdz->type = o->model == ZBD_HOST_AWARE ?
+				ZBD_ZONE_TYPE_SWP : ZBD_ZONE_TYPE_SWR;
+			zbdz->capacity = hdr->zone_capacity;
+		} else {
+			zbdz->type = ZBD_ZONE_TYPE_CNV;
+			zbdz->capacity = hdr->zone_size;
+		}
+		zbdz->cond = z->cond;
+	}
+	zbdemu_unlock(zf);
+
+	return i;
+}
+
+static int zbdemu_reset_wp(struct thread_data *td, struct fio_file *f,
+			   uint64_t offset, uint64_t length)
+{
+	struct zbdemu_options *o = td->eo;
+	struct zbdemu_file *zf;
+	struct zbdemu_hdr *hdr;
+	unsigned int nr_reset = 0;
+	uint32_t zno, zend;
+
+	zf = zbdemu_get(td, f);
+	if (!zf)
+		return -errno;
+
+	hdr = zf->hdr;
+	zno = offset / hdr->zone_size;
+	zend = min((offset + length + hdr->zone_size - 1) / hdr->zone_size,
+		   (uint64_t) hdr->nr_zones);
+
+	zbdemu_lock(zf);
+	for (; zno < zend; zno++) {
+		struct zbdemu_zone *z = &zf->zones[zno];
+
+		if (!zbdemu_is_seq(zf, zno))
+			continue;
+
+		switch (z->cond) {
+		case ZBD_ZONE_COND_IMP_OPEN:
+			hdr->nr_open--;
+			/* fall through */
+		case ZBD_ZONE_COND_CLOSED:
+			hdr->nr_active--;
+			break;
+		case ZBD_ZONE_COND_FULL:
+			break;
+		default:
+			continue;
+		}
+
+		atomic_store_release(&z->wp, (uint64_t) zno * hdr->zone_size);
+		z->cond = ZBD_ZONE_COND_EMPTY;
+		nr_reset++;
+	}
+	zbdemu_unlock(zf);
+
+	if (nr_reset && o->reset_lat)
+		usec_sleep(td, (unsigned long) nr_reset * o->reset_lat);
+
+	return 0;
+}
+
+static int zbdemu_get_max_open_zones(struct thread_data *td,
+				     struct fio_file *f,
+				     unsigned int *max_open_zones)
+{
+	struct zbdemu_options *o = td->eo;
+
+	*max_open_zones = o->max_open;
+	return 0;
+}
+
+/*
+ * Size of a new backing file: filesize if given, else enough for the I/O
+ * range of every job in the group, rounded up to whole zones. All jobs
+ * sharing the file come up with the same size.
+ */
+static int zbdemu_new_file_size(struct thread_data *td, uint64_t *size)
+{
+	struct thread_options *o = &td->o;
+	uint64_t zone_size = o->zone_size ?: ZBDEMU_ZONE_SIZE;
+	uint64_t end;
+
+	if (o->file_size_high) {
+		end = o->file_size_high;
+	} else if (o->start_offset_percent || o->offset_increment_percent) {
+		log_err("fio: zbdemu: set filesize to create a file with a percentage offset\n");
+		return 1;
+	} else {
+		end = o->start_offset +
+			(o->numjobs - 1) * o->offset_increment +
+			o->size / o->nr_files;
+	}
+
+	*size = (end + zone_size - 1) / zone_size * zone_size;
+	return 0;
+}
+
+/*
+ * The emulated drive has a fixed size, like a real one. If the file doesn't
+ * exist yet, create it big enough for the job.
+ */
+static int zbdemu_get_file_size(struct thread_data *td, struct fio_file *f)
+{
+	uint64_t size;
+	int ret, fd;
+
+	if (f->filetype != FIO_TYPE_FILE) {
+		log_err("%s: ioengine zbdemu only works on regular files\n",
+			f->file_name);
+		td_verror(td, EINVAL, "wrong file type");
+		return 1;
+	}
+
+	ret = generic_get_file_size(td, f);
+	if (ret && td->error != ENOENT)
+		return ret;
+	if (f->real_file_size || (!td->o.size && !td->o.file_size_high))
+		return ret;
+
+	td_clear_error(td);
+	if (zbdemu_new_file_size(td, &size)) {
+		td_verror(td, EINVAL, "zbdemu file size");
+		return 1;
+	}
+	fd = open(f->file_name, O_WRONLY | O_CREAT, 0644);
+	if (fd < 0) {
+		td_verror(td, errno, "open");
+		return 1;
+	}
+	if (ftruncate(fd, size) < 0) {
+		td_verror(td, errno, "ftruncate");
+		close(fd);
+		return 1;
+	}
+	close(fd);
+
+	dprint(FD_ZBD, "%s: created with size %llu\n", f->file_name,
+	       (unsigned long long) size);
+	f->real_file_size = size;
+	fio_file_set_size_known(f);
+	return 0;
+}
+
+static int zbdemu_close_file(struct thread_data *td, struct fio_file *f)
+{
+	zbdemu_put(f);
+	return generic_close_file(td, f);
+}
+
+static void zbdemu_cleanup(struct thread_data *td)
+{
+	struct fio_file *f;
+	unsigned int i;
+
+	for_each_file(td, f, i)
+		zbdemu_put(f);
+}
+
+static struct ioengine_ops ioengine = {
+	.name			= "zbdemu",
+	.version		= FIO_IOOPS_VERSION,
+	.queue			= zbdemu_queue,
+	.cleanup		= zbdemu_cleanup,
+	.open_file		= generic_open_file,
+	.close_file		= zbdemu_close_file,
+	.get_file_size		= zbdemu_get_file_size,
+	.get_zoned_model	= zbdemu_get_zoned_model,
+	.report_zones		= zbdemu_report_zones,
+	.reset_wp		= zbdemu_reset_wp,
+	.get_max_open_zones	= zbdemu_get_max_open_zones,
+	.flags			= FIO_SYNCIO | FIO_NOEXTEND | FIO_ZONE_APPEND,
+	.options		= options,
+	.option_struct_size	= sizeof(struct zbdemu_options),
+};
+
+static void fio_init fio_zbdemu_register(void)
+{
+	register_ioengine(&ioengine);
+}
+
+static void fio_exit fio_zbdemu_unregister(void)
+{
+	unregister_ioengine(&ioengine);
+}
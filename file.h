@@ -8,6 +8,7 @@
 #include "lib/zipf.h"
 #include "lib/axmap.h"
 #include "lib/lfsr.h"
+#include "lib/feistel.h"
 #include "lib/gauss.h"
 
 /* Forward declarations */
@@ -34,6 +35,7 @@ enum fio_file_flags {
 	FIO_FILE_axmap		= 1 << 7,	/* uses axmap */
 	FIO_FILE_lfsr		= 1 << 8,	/* lfsr is used */
 	FIO_FILE_smalloc	= 1 << 9,	/* smalloc file/file_name */
+	FIO_FILE_feistel	= 1 << 10,	/* feistel permutation is used */
 };
 
 enum file_lock_mode {
@@ -108,6 +110,7 @@ struct fio_file {
 	/* zonemode=zbd working area */
 	uint32_t min_zone;	/* inclusive */
 	uint32_t max_zone;	/* exclusive */
+	uint32_t last_zone;	/* zone of the last write */
 
 	/*
 	 * Track last end and last start of IO for a given data direction
@@ -142,11 +145,12 @@ struct fio_file {
 	};
 
 	/*
-	 * block map or LFSR for random io
+	 * block map, LFSR or feistel permutation for random io
 	 */
 	union {
 		struct axmap *io_axmap;
 		struct fio_lfsr lfsr;
+		struct fio_feistel feistel;
 	};
 
 	/*
@@ -190,6 +194,7 @@ FILE_FLAG_FNS(partial_mmap);
 FILE_FLAG_FNS(axmap);
 FILE_FLAG_FNS(lfsr);
 FILE_FLAG_FNS(smalloc);
+FILE_FLAG_FNS(feistel);
 #undef FILE_FLAG_FNS
 
 /*
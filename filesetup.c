@@ -1462,6 +1462,21 @@ static void __init_rand_distribution(struct thread_data *td, struct fio_file *f)
 		pareto_init(&f->zipf, nranges, td->o.pareto_h.u.f, td->o.random_center.u.f, seed);
 	else if (td->o.random_distribution == FIO_RAND_DIST_GAUSS)
 		gauss_init(&f->gauss, nranges, td->o.gauss_dev.u.f, td->o.random_center.u.f, seed);
+
+	/*
+	 * With the feistel generator, the distribution picks a range and the
+	 * permutation scatters it over the file instead of the hash, which
+	 * isn't one to one.
+	 */
+	if (td->o.random_generator == FIO_RAND_GEN_FEISTEL &&
+	    !feistel_init(&f->feistel, nranges,
+			  td->rand_seeds[FIO_RAND_BLOCK_OFF])) {
+		fio_file_set_feistel(f);
+		if (td->o.random_distribution == FIO_RAND_DIST_GAUSS)
+			gauss_disable_hash(&f->gauss);
+		else
+			zipf_disable_hash(&f->zipf);
+	}
 }
 
 static bool init_rand_distribution(struct thread_data *td)
@@ -1555,6 +1570,18 @@ bool init_random_map(struct thread_data *td)
 				log_err("fio: failed initializing LFSR\n");
 				return false;
 			}
+		} else if (td->o.random_generator == FIO_RAND_GEN_FEISTEL) {
+			uint64_t seed;
+
+			seed = td->rand_seeds[FIO_RAND_BLOCK_OFF];
+
+			if (!feistel_init(&f->feistel, blocks, seed)) {
+				fio_file_set_feistel(f);
+				continue;
+			} else {
+				log_err("fio: failed initializing feistel\n");
+				return false;
+			}
 		} else if (!td->o.norandommap) {
 			f->io_axmap = axmap_new(blocks);
 			if (f->io_axmap) {
@@ -1626,7 +1653,7 @@ void close_and_free_files(struct thread_data *td)
 			td_io_unlink_file(td, f);
 		}
 
-		zbd_close_file(f);
+		zbd_close_file(td, f);
 		fio_file_free(f);
 	}
 
@@ -2100,6 +2127,8 @@ void fio_file_reset(struct thread_data *td, struct fio_file *f)
 		axmap_reset(f->io_axmap);
 	else if (fio_file_lfsr(f))
 		lfsr_reset(&f->lfsr, td->rand_seeds[FIO_RAND_BLOCK_OFF]);
+	else if (fio_file_feistel(f))
+		feistel_reset(&f->feistel, td->rand_seeds[FIO_RAND_BLOCK_OFF]);
 
 	zbd_file_reset(td, f);
 }
@@ -70,6 +70,7 @@
 #endif
 
 struct fio_sem;
+struct arrival;
 
 /*
  * offset generator types
@@ -182,7 +183,7 @@ struct zone_split_index {
  */
 struct thread_data {
 	struct flist_head opt_list;
-	unsigned long flags;
+	unsigned long long flags;
 	struct thread_options o;
 	void *eo;
 	pthread_t thread;
@@ -277,6 +278,10 @@ struct thread_data {
 	unsigned int trim_batch;
 
 	struct thread_io_list *vstate;
+	struct verify_journal *vjournal;
+	struct verify_index *vindex;
+	struct verify_pool *vpool;
+	struct verify_batch *vbatch;
 
 	int shm_id;
 
@@ -322,13 +327,16 @@ struct thread_data {
 	pthread_cond_t free_cond;
 
 	/*
-	 * async verify offload
+	 * async verify offload. Completed io_us are batched up and handed
+	 * to the verify threads' own queues in turn.
 	 */
-	struct flist_head verify_list;
-	pthread_t *verify_threads;
+	struct verify_worker *verify_workers;
 	unsigned int nr_verify_threads;
-	pthread_cond_t verify_cond;
+	unsigned int verify_next;
 	int verify_thread_exit;
+#define VERIFY_ASYNC_BATCH	32
+	struct io_u *verify_async_batch[VERIFY_ASYNC_BATCH];
+	unsigned int verify_async_nr;
 
 	/*
 	 * Rate state
@@ -342,11 +350,21 @@ struct thread_data {
 	int64_t last_usec[DDIR_RWDIR_CNT];
 	struct frand_state poisson_state[DDIR_RWDIR_CNT];
 
+	/*
+	 * Open loop arrival queue, see arrival.c
+	 */
+	struct arrival *arrival;
+
 	/*
 	 * Enforced rate submission/completion workqueue
 	 */
 	struct workqueue io_wq;
 
+	/*
+	 * Pre-generated write buffers, see buf_pool.c
+	 */
+	struct buf_pool *buf_pool;
+
 	uint64_t total_io_size;
 	uint64_t fill_device_size;
 
@@ -389,6 +407,13 @@ struct thread_data {
 	unsigned int ts_cache_mask;
 	bool ramp_time_over;
 
+	/*
+	 * gtod_batch: timestamp shared by the current submit/reap batch
+	 */
+	struct timespec batch_time;
+	unsigned int batch_time_users;
+	bool batch_time_valid;
+
 	/*
 	 * Time since last latency_window was started
 	 */
@@ -677,12 +702,12 @@ enum {
 };
 
 #define TD_ENG_FLAG_SHIFT	17
-#define TD_ENG_FLAG_MASK	((1U << 17) - 1)
+#define TD_ENG_FLAG_MASK	((1ULL << 17) - 1)
 
 static inline void td_set_ioengine_flags(struct thread_data *td)
 {
 	td->flags = (~(TD_ENG_FLAG_MASK << TD_ENG_FLAG_SHIFT) & td->flags) |
-		    (td->io_ops->flags << TD_ENG_FLAG_SHIFT);
+		    ((unsigned long long) td->io_ops->flags << TD_ENG_FLAG_SHIFT);
 }
 
 static inline bool td_ioengine_flagged(struct thread_data *td,
@@ -734,6 +759,7 @@ extern void reset_all_stats(struct thread_data *);
 extern int io_queue_event(struct thread_data *td, struct io_u *io_u, int *ret,
 		   enum fio_ddir ddir, uint64_t *bytes_issued, int from_verify,
 		   struct timespec *comp_time);
+extern void do_verify_io(struct thread_data *td, uint64_t verify_bytes);
 
 /*
  * Latency target helpers
@@ -845,6 +871,15 @@ static inline void td_flags_set(struct thread_data *td, unsigned int *flags,
 		__sync_fetch_and_or(flags, value);
 }
 
+/*
+ * gtod_batch: a shared timestamp must not be handed out across a sleep or
+ * an idle wait, or the latencies stamped from it absorb that time.
+ */
+static inline void td_batch_time_invalidate(struct thread_data *td)
+{
+	td->batch_time_valid = false;
+}
+
 extern const char *fio_get_arch_string(int);
 extern const char *fio_get_os_string(int);
 
@@ -877,6 +912,7 @@ enum {
 	FIO_RAND_GEN_TAUSWORTHE = 0,
 	FIO_RAND_GEN_LFSR,
 	FIO_RAND_GEN_TAUSWORTHE64,
+	FIO_RAND_GEN_FEISTEL,
 };
 
 enum {
@@ -1108,7 +1108,8 @@ static void gfio_show_clat_percentiles(struct gfio_client *gc,
 	struct gui_entry *ge = gc->ge;
 	char tmp[64];
 
-	len = calc_clat_percentiles(io_u_plat, nr, plist, &ovals, &maxv, &minv);
+	len = calc_clat_percentiles(io_u_plat, ts->plat_bits, nr, plist, &ovals,
+				    &maxv, &minv);
 	if (!len)
 		goto out;
 
@@ -13,6 +13,8 @@
 #include "smalloc.h"
 #include "helper_thread.h"
 #include "steadystate.h"
+#include "metrics.h"
+#include "shm-stats.h"
 #include "pshared.h"
 
 static int sleep_accuracy_ms;
@@ -280,6 +282,16 @@ static void *helper_thread_main(void *data)
 			.interval_ms = steadystate_enabled ? STEADYSTATE_MSEC :
 				0,
 			.func = steadystate_check,
+		},
+		{
+			.name = "metrics",
+			.interval_ms = metrics_port ? METRICS_MSEC : 0,
+			.func = metrics_check,
+		},
+		{
+			.name = "shm_stats",
+			.interval_ms = shm_stats_file ? SHM_STATS_MSEC : 0,
+			.func = shm_stats_update,
 		}
 	};
 	struct timespec ts;
@@ -357,6 +369,9 @@ static void *helper_thread_main(void *data)
 
 	fio_writeout_logs(false);
 
+	metrics_exit();
+	shm_stats_exit();
+
 	sk_out_drop();
 	return NULL;
 }
@@ -414,6 +429,9 @@ int helper_thread_create(struct fio_sem *startup_sem, struct sk_out *sk_out)
 	struct helper_data *hd;
 	int ret;
 
+	if (metrics_setup() || shm_stats_setup())
+		return 1;
+
 	hd = scalloc(1, sizeof(*hd));
 
 	setup_disk_util();
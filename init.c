@@ -30,6 +30,9 @@
 #include "idletime.h"
 #include "filelock.h"
 #include "steadystate.h"
+#include "arrival.h"
+#include "metrics.h"
+#include "shm-stats.h"
 #include "blktrace.h"
 
 #include "oslib/asprintf.h"
@@ -263,6 +266,16 @@ static struct option l_opts[FIO_NR_OPTIONS] = {
 		.has_arg	= required_argument,
 		.val		= 'L' | FIO_CLIENT_FLAG,
 	},
+	{
+		.name		= (char *) "metrics-port",
+		.has_arg	= required_argument,
+		.val		= 'y',
+	},
+	{
+		.name		= (char *) "shm-stats",
+		.has_arg	= required_argument,
+		.val		= 'Z',
+	},
 	{
 		.name		= (char *) "trigger-file",
 		.has_arg	= required_argument,
@@ -663,6 +676,11 @@ static int fixup_options(struct thread_data *td)
 	if (o->zone_mode == ZONE_MODE_STRIDED && !o->zone_range)
 		o->zone_range = o->zone_size;
 
+	if (o->zone_append && o->zone_mode != ZONE_MODE_ZBD) {
+		log_err("fio: --zone_append requires --zonemode=zbd.\n");
+		ret |= 1;
+	}
+
 	/*
 	 * Reads can do overwrites, we always need to pre-create the file
 	 */
@@ -766,6 +784,30 @@ static int fixup_options(struct thread_data *td)
 		log_err("fio: rate and rate_iops are mutually exclusive\n");
 		ret |= 1;
 	}
+	if (o->arrival_process != ARRIVAL_NONE) {
+		if (o->rate[DDIR_READ] + o->rate[DDIR_WRITE] + o->rate[DDIR_TRIM] +
+		    o->rate_iops[DDIR_READ] + o->rate_iops[DDIR_WRITE] +
+		    o->rate_iops[DDIR_TRIM]) {
+			log_err("fio: arrival_process and rate are mutually exclusive\n");
+			ret |= 1;
+		}
+		if (o->arrival_process == ARRIVAL_TRACE && !o->arrival_trace) {
+			log_err("fio: arrival_process=trace needs arrival_trace\n");
+			ret |= 1;
+		} else if (o->arrival_process != ARRIVAL_TRACE &&
+			   !o->arrival_rate) {
+			log_err("fio: arrival_process needs arrival_rate\n");
+			ret |= 1;
+		}
+		if (o->read_iolog_file) {
+			log_err("fio: arrival_process can't be used with read_iolog\n");
+			ret |= 1;
+		}
+		if (o->io_submit_mode == IO_MODE_OFFLOAD) {
+			log_err("fio: arrival_process needs io_submit_mode=inline\n");
+			ret |= 1;
+		}
+	}
 	for_each_rw_ddir(ddir) {
 		if ((o->rate[ddir] && (o->rate[ddir] < o->ratemin[ddir])) ||
 		    (o->rate_iops[ddir] && (o->rate_iops[ddir] < o->rate_iops_min[ddir]))) {
@@ -833,6 +875,20 @@ static int fixup_options(struct thread_data *td)
 		    (o->max_bs[DDIR_WRITE] % o->verify_interval))
 			o->verify_interval = gcd(o->min_bs[DDIR_WRITE],
 							o->max_bs[DDIR_WRITE]);
+
+		/*
+		 * These depend on the verify reads being issued in write
+		 * order, from the job thread
+		 */
+		if (o->verify_workers &&
+		    (o->experimental_verify || o->verify_state ||
+		     o->io_submit_mode == IO_MODE_OFFLOAD)) {
+			log_info("fio: verify_workers does not work with "
+				 "experimental_verify, verify_state_load or "
+				 "io_submit_mode=offload. Disabling.\n");
+			o->verify_workers = 0;
+			ret |= warnings_fatal;
+		}
 	}
 
 	if (o->pre_read) {
@@ -900,6 +956,18 @@ static int fixup_options(struct thread_data *td)
 	if (o->random_distribution != FIO_RAND_DIST_RANDOM)
 		o->norandommap = 1;
 
+	/*
+	 * The feistel permutation covers the whole file, it can't hand out
+	 * offsets from the sub-ranges of a zoned distribution.
+	 */
+	if (o->random_generator == FIO_RAND_GEN_FEISTEL &&
+	    (o->random_distribution == FIO_RAND_DIST_ZONED ||
+	     o->random_distribution == FIO_RAND_DIST_ZONED_ABS)) {
+		log_err("fio: random_generator=feistel doesn't support zoned "
+			"random distributions\n");
+		ret |= 1;
+	}
+
 	/*
 	 * If size is set but less than the min block size, complain
 	 */
@@ -943,6 +1011,29 @@ static int fixup_options(struct thread_data *td)
 		ret |= 1;
 	}
 
+	if (o->log_binary && (o->log_gz || o->log_gz_store)) {
+		log_err("fio: log_binary can't be combined with log compression\n");
+		ret |= 1;
+	}
+	if (o->log_binary && !o->per_job_logs) {
+		log_err("fio: log_binary requires per_job_logs\n");
+		ret |= 1;
+	}
+	if (o->log_mem_limit && (o->log_gz || o->log_gz_store)) {
+		log_err("fio: log_mem_limit can't be combined with log compression\n");
+		ret |= 1;
+	}
+	if (o->log_mem_limit && !o->per_job_logs) {
+		log_err("fio: log_mem_limit requires per_job_logs\n");
+		ret |= 1;
+	}
+
+	if (o->write_hist_log && o->lat_hist_bits != FIO_IO_U_PLAT_BITS) {
+		log_err("fio: histogram logging requires lat_hist_bits=%d\n",
+			FIO_IO_U_PLAT_BITS);
+		ret |= 1;
+	}
+
 	if (o->disable_lat)
 		o->lat_percentiles = 0;
 	if (o->disable_clat)
@@ -1547,17 +1638,22 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 	td->ts.percentile_precision = o->percentile_precision;
 	memcpy(td->ts.percentile_list, o->percentile_list, sizeof(o->percentile_list));
 	td->ts.sig_figs = o->sig_figs;
+	td->ts.plat_bits = o->lat_hist_bits;
 
 	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
 		td->ts.clat_stat[i].min_val = ULONG_MAX;
 		td->ts.slat_stat[i].min_val = ULONG_MAX;
 		td->ts.lat_stat[i].min_val = ULONG_MAX;
+		td->ts.co_lat_stat[i].min_val = ULONG_MAX;
 		td->ts.bw_stat[i].min_val = ULONG_MAX;
 		td->ts.iops_stat[i].min_val = ULONG_MAX;
 		td->ts.clat_high_prio_stat[i].min_val = ULONG_MAX;
 		td->ts.clat_low_prio_stat[i].min_val = ULONG_MAX;
 	}
 	td->ts.sync_stat.min_val = ULONG_MAX;
+	td->ts.clock_batch_stat.min_val = ULONG_MAX;
+	td->ts.arrival_wait_stat.min_val = ULONG_MAX;
+	td->ts.arrival_depth_stat.min_val = ULONG_MAX;
 	td->ddir_seq_nr = o->ddir_seq_nr;
 
 	if ((o->stonewall || o->new_group) && prev_group_jobs) {
@@ -1586,12 +1682,16 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 			.log_prio = o->log_prio,
 			.log_gz = o->log_gz,
 			.log_gz_store = o->log_gz_store,
+			.log_binary = o->log_binary,
+			.log_mem_limit = o->log_mem_limit,
 		};
 		const char *pre = make_log_name(o->lat_log_file, o->name);
 		const char *suf;
 
 		if (p.log_gz_store)
 			suf = "log.fz";
+		else if (p.log_binary)
+			suf = "log.bin";
 		else
 			suf = "log";
 
@@ -1599,10 +1699,12 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 				td->thread_number, suf, o->per_job_logs);
 		setup_log(&td->lat_log, &p, logname);
 
+		p.log_type = IO_LOG_TYPE_SLAT;
 		gen_log_name(logname, sizeof(logname), "slat", pre,
 				td->thread_number, suf, o->per_job_logs);
 		setup_log(&td->slat_log, &p, logname);
 
+		p.log_type = IO_LOG_TYPE_CLAT;
 		gen_log_name(logname, sizeof(logname), "clat", pre,
 				td->thread_number, suf, o->per_job_logs);
 		setup_log(&td->clat_log, &p, logname);
@@ -1652,6 +1754,8 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 			.log_prio = o->log_prio,
 			.log_gz = o->log_gz,
 			.log_gz_store = o->log_gz_store,
+			.log_binary = o->log_binary,
+			.log_mem_limit = o->log_mem_limit,
 		};
 		const char *pre = make_log_name(o->bw_log_file, o->name);
 		const char *suf;
@@ -1666,6 +1770,8 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 
 		if (p.log_gz_store)
 			suf = "log.fz";
+		else if (p.log_binary)
+			suf = "log.bin";
 		else
 			suf = "log";
 
@@ -1684,6 +1790,8 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 			.log_prio = o->log_prio,
 			.log_gz = o->log_gz,
 			.log_gz_store = o->log_gz_store,
+			.log_binary = o->log_binary,
+			.log_mem_limit = o->log_mem_limit,
 		};
 		const char *pre = make_log_name(o->iops_log_file, o->name);
 		const char *suf;
@@ -1698,6 +1806,8 @@ static int add_job(struct thread_data *td, const char *jobname, int job_add_num,
 
 		if (p.log_gz_store)
 			suf = "log.fz";
+		else if (p.log_binary)
+			suf = "log.bin";
 		else
 			suf = "log";
 
@@ -2248,6 +2358,10 @@ static void usage(const char *name)
 	printf(" period passed\n");
 	printf("  --status-interval=t\tForce full status dump every");
 	printf(" 't' period passed\n");
+	printf("  --metrics-port=port\tServe OpenMetrics stats on this"
+		" loopback port\n");
+	printf("  --shm-stats=file\tPublish live stats in this shared"
+		" memory file\n");
 	printf("  --readonly\t\tTurn on safety read-only checks, preventing"
 		" writes\n");
 	printf("  --section=name\tOnly run specified section in job file,"
@@ -2908,6 +3022,19 @@ int parse_cmd_line(int argc, char *argv[], int client_type)
 			status_interval = val / 1000;
 			break;
 			}
+		case 'y':
+			metrics_port = atoi(optarg);
+			if (metrics_port < 1 || metrics_port > 65535) {
+				log_err("fio: bad metrics port %s\n", optarg);
+				do_exit++;
+				exit_val = 1;
+			}
+			break;
+		case 'Z':
+			if (shm_stats_file)
+				free(shm_stats_file);
+			shm_stats_file = strdup(optarg);
+			break;
 		case 'W':
 			if (trigger_file)
 				free(trigger_file);
@@ -11,13 +11,21 @@
 #include "lib/pow2.h"
 #include "minmax.h"
 #include "zbd.h"
+#include "buf_pool.h"
+#include "arrival.h"
+
+#define IO_U_PUT_BATCH	64
 
 struct io_completion_data {
 	int nr;				/* input */
+	bool account;			/* input */
 
 	int error;			/* output */
 	uint64_t bytes_done[DDIR_RWDIR_CNT];	/* output */
 	struct timespec time;		/* output */
+
+	unsigned int nr_lat;
+	struct lat_sample lat[IO_U_PUT_BATCH];
 };
 
 /*
@@ -98,6 +106,17 @@ static int __get_next_rand_offset(struct thread_data *td, struct fio_file *f,
 		dprint(FD_RANDOM, "off rand %llu\n", (unsigned long long) r);
 
 		*b = lastb * (r / (rand_max(&td->random_state) + 1.0));
+	} else if (td->o.random_generator == FIO_RAND_GEN_FEISTEL) {
+		assert(fio_file_feistel(f));
+
+		/*
+		 * The permutation is sized for the smallest block size, skip
+		 * blocks past the last one for this direction.
+		 */
+		do {
+			if (feistel_next(&f->feistel, b))
+				return 1;
+		} while (*b >= lastb);
 	} else {
 		uint64_t off = 0;
 
@@ -136,6 +155,8 @@ static int __get_next_rand_offset_zipf(struct thread_data *td,
 				       uint64_t *b)
 {
 	*b = zipf_next(&f->zipf);
+	if (fio_file_feistel(f))
+		*b = feistel_map(&f->feistel, *b);
 	return 0;
 }
 
@@ -144,6 +165,8 @@ static int __get_next_rand_offset_pareto(struct thread_data *td,
 					 uint64_t *b)
 {
 	*b = pareto_next(&f->zipf);
+	if (fio_file_feistel(f))
+		*b = feistel_map(&f->feistel, *b);
 	return 0;
 }
 
@@ -152,6 +175,8 @@ static int __get_next_rand_offset_gauss(struct thread_data *td,
 					uint64_t *b)
 {
 	*b = gauss_next(&f->gauss);
+	if (fio_file_feistel(f))
+		*b = feistel_map(&f->feistel, *b);
 	return 0;
 }
 
@@ -630,6 +655,12 @@ int io_u_quiesce(struct thread_data *td)
 			err = ret;
 	}
 
+	/*
+	 * The caller goes idle now, whatever it issues next must not share
+	 * the timestamp of the last reap.
+	 */
+	td_batch_time_invalidate(td);
+
 	if (td->flags & TD_F_REGROW_LOGS)
 		regrow_logs(td);
 
@@ -755,6 +786,9 @@ static enum fio_ddir get_rw_ddir(struct thread_data *td)
 	else
 		ddir = DDIR_INVAL;
 
+	if (td->arrival && ddir_rw(ddir) && arrival_wait(td))
+		return DDIR_INVAL;
+
 	td->rwmix_ddir = rate_ddir(td, ddir);
 	return td->rwmix_ddir;
 }
@@ -781,6 +815,21 @@ static void set_rw_ddir(struct thread_data *td, struct io_u *io_u)
 	   !(td->io_issues[DDIR_WRITE] % td->o.barrier_blocks) &&
 	     td->io_issues[DDIR_WRITE])
 		io_u_set(td, io_u, IO_U_F_BARRIER);
+
+	/*
+	 * Remember the slot the rate schedule has for this IO. If we're
+	 * running behind, that's in the past, and the IO is charged for
+	 * the time it spent waiting to be issued. In open loop mode, the
+	 * IO carries the oldest queued arrival instead.
+	 */
+	if (td->arrival && ddir_rw(ddir)) {
+		io_u->rate_intended = arrival_pop(td);
+		io_u_set(td, io_u, IO_U_F_CO_LAT);
+	} else if (td->o.rate_co_lat && should_check_rate(td) &&
+		   ddir_rw(ddir) && td->rate_bps[ddir]) {
+		io_u->rate_intended = td->rate_next_io_time[ddir];
+		io_u_set(td, io_u, IO_U_F_CO_LAT);
+	}
 }
 
 void put_file_log(struct thread_data *td, struct fio_file *f)
@@ -791,6 +840,24 @@ void put_file_log(struct thread_data *td, struct fio_file *f)
 		td_verror(td, ret, "file close");
 }
 
+/*
+ * Return an io_u to the freelist. Caller holds the io_u lock if needed.
+ */
+static void __put_io_u(struct thread_data *td, struct io_u *io_u)
+{
+	if (io_u->file && !(io_u->flags & IO_U_F_NO_FILE_PUT))
+		put_file_log(td, io_u->file);
+
+	io_u->file = NULL;
+	io_u_set(td, io_u, IO_U_F_FREE);
+
+	if (io_u->flags & IO_U_F_IN_CUR_DEPTH) {
+		td->cur_depth--;
+		assert(!(td->flags & TD_F_CHILD));
+	}
+	io_u_qpush(&td->io_u_freelist, io_u);
+}
+
 void put_io_u(struct thread_data *td, struct io_u *io_u)
 {
 	const bool needs_lock = td_async_processing(td);
@@ -803,17 +870,34 @@ void put_io_u(struct thread_data *td, struct io_u *io_u)
 	if (needs_lock)
 		__td_io_u_lock(td);
 
-	if (io_u->file && !(io_u->flags & IO_U_F_NO_FILE_PUT))
-		put_file_log(td, io_u->file);
+	__put_io_u(td, io_u);
+	td_io_u_free_notify(td);
 
-	io_u->file = NULL;
-	io_u_set(td, io_u, IO_U_F_FREE);
+	if (needs_lock)
+		__td_io_u_unlock(td);
+}
 
-	if (io_u->flags & IO_U_F_IN_CUR_DEPTH) {
-		td->cur_depth--;
-		assert(!(td->flags & TD_F_CHILD));
-	}
-	io_u_qpush(&td->io_u_freelist, io_u);
+/*
+ * Return a batch of completed io_us to the freelist, taking the io_u lock
+ * and waking up waiters only once for the whole batch.
+ */
+void put_io_u_batch(struct thread_data *td, struct io_u **io_us,
+		    unsigned int nr)
+{
+	const bool needs_lock = td_async_processing(td);
+	unsigned int i;
+
+	for (i = 0; i < nr; i++)
+		zbd_put_io_u(td, io_us[i]);
+
+	if (td->parent)
+		td = td->parent;
+
+	if (needs_lock)
+		__td_io_u_lock(td);
+
+	for (i = 0; i < nr; i++)
+		__put_io_u(td, io_us[i]);
 	td_io_u_free_notify(td);
 
 	if (needs_lock)
@@ -966,7 +1050,14 @@ static int fill_io_u(struct thread_data *td, struct io_u *io_u)
 
 out:
 	dprint_io_u(io_u, "fill");
-	io_u->verify_offset = io_u->offset;
+	/*
+	 * Where a zone append lands in its zone is only known when it
+	 * completes, so its verify headers carry the zone start instead.
+	 */
+	if (io_u->flags & IO_U_F_ZONE_APPEND)
+		io_u->verify_offset = zbd_zone_start(io_u->file, io_u->offset);
+	else
+		io_u->verify_offset = io_u->offset;
 	td->zone_bytes += io_u->buflen;
 	return 0;
 }
@@ -1589,13 +1680,17 @@ again:
 		io_u->buflen = 0;
 		io_u->resid = 0;
 		io_u->end_io = NULL;
+		/* a requeued io_u keeps its intended time */
+		io_u_clear(td, io_u, IO_U_F_CO_LAT);
 	}
 
 	if (io_u) {
 		assert(io_u->flags & IO_U_F_FREE);
 		io_u_clear(td, io_u, IO_U_F_FREE | IO_U_F_NO_FILE_PUT |
 				 IO_U_F_TRIMMED | IO_U_F_BARRIER |
-				 IO_U_F_VER_LIST | IO_U_F_HIGH_PRIO);
+				 IO_U_F_VER_LIST | IO_U_F_HIGH_PRIO |
+				 IO_U_F_VER_INDEX | IO_U_F_VER_NONUM |
+				 IO_U_F_ZONE_APPEND);
 
 		io_u->error = 0;
 		io_u->acct_ddir = -1;
@@ -1807,7 +1902,7 @@ out:
 	assert(io_u->file);
 	if (!td_io_prep(td, io_u)) {
 		if (!td->o.disable_lat)
-			fio_gettime(&io_u->start_time, NULL);
+			td_batch_gettime(td, &io_u->start_time);
 
 		if (do_scramble)
 			small_content_scramble(io_u);
@@ -1868,12 +1963,64 @@ static void trim_block_info(struct thread_data *td, struct io_u *io_u)
 	*info = BLOCK_INFO(BLOCK_STATE_TRIMMED, BLOCK_INFO_TRIMS(*info) + 1);
 }
 
+/*
+ * Latency as seen by a client issuing at the rate: from the intended
+ * issue time to completion. When the device stalls, fio stops issuing and
+ * the IOs it should have issued never get measured, this charges the
+ * stall to every IO that was held back by it. It's never less than the
+ * measured latency, which covers IOs that were issued early.
+ */
+static void account_co_lat(struct thread_data *td, struct io_u *io_u,
+			   struct io_completion_data *icd,
+			   const enum fio_ddir idx, unsigned long long llnsec)
+{
+	uint64_t intended = io_u->rate_intended * 1000;
+	uint64_t now = ntime_since(&td->epoch, &icd->time);
+	unsigned long long nsec = llnsec;
+
+	if (!td->o.disable_lat)
+		nsec = ntime_since(&io_u->start_time, &icd->time);
+	if (now > intended && now - intended > nsec)
+		nsec = now - intended;
+
+	add_co_lat_sample(td, idx, nsec);
+}
+
+static void icd_flush_lat(struct thread_data *td,
+			  struct io_completion_data *icd)
+{
+	if (!icd->nr_lat)
+		return;
+
+	if (td->parent)
+		td = td->parent;
+
+	add_lat_samples(td, icd->lat, icd->nr_lat);
+	icd->nr_lat = 0;
+}
+
+static struct lat_sample *icd_get_lat(struct io_u *io_u,
+				      struct io_completion_data *icd,
+				      const enum fio_ddir idx,
+				      unsigned int bytes)
+{
+	struct lat_sample *s = &icd->lat[icd->nr_lat++];
+
+	s->bs = bytes;
+	s->offset = io_u->offset;
+	s->ioprio = io_u->ioprio;
+	s->ddir = idx;
+	s->flags = io_u_is_high_prio(io_u) ? LAT_SAMPLE_HIGH_PRIO : 0;
+	return s;
+}
+
 static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 				  struct io_completion_data *icd,
 				  const enum fio_ddir idx, unsigned int bytes)
 {
 	const int no_reduce = !gtod_reduce(td);
 	unsigned long long llnsec = 0;
+	struct lat_sample *s = NULL;
 
 	if (td->parent)
 		td = td->parent;
@@ -1884,12 +2031,21 @@ static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 	if (no_reduce)
 		llnsec = ntime_since(&io_u->issue_time, &icd->time);
 
+	/*
+	 * lat/clat samples are queued and added for the whole reaped batch
+	 * at once, see icd_flush_lat().
+	 */
+	if (ddir_rw(idx) && (!td->o.disable_lat || !td->o.disable_clat))
+		s = icd_get_lat(io_u, icd, idx, bytes);
+
 	if (!td->o.disable_lat) {
 		unsigned long long tnsec;
 
 		tnsec = ntime_since(&io_u->start_time, &icd->time);
-		add_lat_sample(td, idx, tnsec, bytes, io_u->offset,
-			       io_u->ioprio, io_u_is_high_prio(io_u));
+		if (s) {
+			s->lat = tnsec;
+			s->flags |= LAT_SAMPLE_LAT;
+		}
 
 		if (td->flags & TD_F_PROFILE_OPS) {
 			struct prof_io_ops *ops = &td->prof_io_ops;
@@ -1910,11 +2066,14 @@ static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 
 	if (ddir_rw(idx)) {
 		if (!td->o.disable_clat) {
-			add_clat_sample(td, idx, llnsec, bytes, io_u->offset,
-					io_u->ioprio, io_u_is_high_prio(io_u));
+			s->clat = llnsec;
+			s->flags |= LAT_SAMPLE_CLAT;
 			io_u_mark_latency(td, llnsec);
 		}
 
+		if (no_reduce && (io_u->flags & IO_U_F_CO_LAT))
+			account_co_lat(td, io_u, icd, idx, llnsec);
+
 		if (!td->o.disable_bw && per_unit_log(td->bw_log))
 			add_bw_sample(td, io_u, bytes, llnsec);
 
@@ -1925,6 +2084,9 @@ static void account_io_completion(struct thread_data *td, struct io_u *io_u,
 
 	if (td->ts.nr_block_infos && io_u->ddir == DDIR_TRIM)
 		trim_block_info(td, io_u);
+
+	if (icd->nr_lat == IO_U_PUT_BATCH)
+		icd_flush_lat(td, icd);
 }
 
 static void file_log_write_comp(const struct thread_data *td, struct fio_file *f,
@@ -1967,6 +2129,18 @@ static void io_completed(struct thread_data *td, struct io_u **io_u_ptr,
 	assert(io_u->flags & IO_U_F_FLIGHT);
 	io_u_clear(td, io_u, IO_U_F_FLIGHT | IO_U_F_BUSY_OK);
 
+	if ((io_u->flags & IO_U_F_VER_INDEX) && io_u->error)
+		unlog_io_piece(td, io_u);
+
+	/*
+	 * Zone appends are logged for verify once the engine has reported
+	 * where the data went.
+	 */
+	if ((io_u->flags & IO_U_F_ZONE_APPEND) && !io_u->error &&
+	    ddir == DDIR_WRITE && td->o.do_verify &&
+	    td->o.verify != VERIFY_NONE && !td->o.experimental_verify)
+		log_io_piece(td, io_u);
+
 	/*
 	 * Mark IO ok to verify
 	 */
@@ -1988,7 +2162,7 @@ static void io_completed(struct thread_data *td, struct io_u **io_u_ptr,
 			f->first_write = -1ULL;
 			f->last_write = -1ULL;
 		}
-		if (should_account(td))
+		if (icd->account)
 			account_io_completion(td, io_u, icd, ddir, io_u->buflen);
 		return;
 	}
@@ -2023,10 +2197,12 @@ static void io_completed(struct thread_data *td, struct io_u **io_u_ptr,
 			td->this_io_bytes[ddir] += bytes;
 		}
 
-		if (ddir == DDIR_WRITE)
+		if (ddir == DDIR_WRITE) {
 			file_log_write_comp(td, f, io_u->offset, bytes);
+			verify_journal_add(td, f, io_u->offset, bytes);
+		}
 
-		if (should_account(td))
+		if (icd->account)
 			account_io_completion(td, io_u, icd, ddir, bytes);
 
 		icd->bytes_done[ddir] += bytes;
@@ -2064,19 +2240,31 @@ static void init_icd(struct thread_data *td, struct io_completion_data *icd,
 {
 	int ddir;
 
-	if (!gtod_reduce(td))
+	if (!gtod_reduce(td)) {
 		fio_gettime(&icd->time, NULL);
+		if (td->o.gtod_batch)
+			td_batch_time_set(td, &icd->time);
+	}
 
 	icd->nr = nr;
 
+	/*
+	 * Whether to account is decided once for the whole batch, which
+	 * saves a clock read per completion while ramping up.
+	 */
+	icd->account = should_account(td);
+
 	icd->error = 0;
 	for (ddir = 0; ddir < DDIR_RWDIR_CNT; ddir++)
 		icd->bytes_done[ddir] = 0;
+	icd->nr_lat = 0;
 }
 
 static void ios_completed(struct thread_data *td,
 			  struct io_completion_data *icd)
 {
+	struct io_u *done[IO_U_PUT_BATCH];
+	unsigned int nr_done = 0;
 	struct io_u *io_u;
 	int i;
 
@@ -2085,9 +2273,21 @@ static void ios_completed(struct thread_data *td,
 
 		io_completed(td, &io_u, icd);
 
-		if (io_u)
-			put_io_u(td, io_u);
+		if (!io_u)
+			continue;
+
+		done[nr_done++] = io_u;
+		if (nr_done == IO_U_PUT_BATCH) {
+			put_io_u_batch(td, done, nr_done);
+			nr_done = 0;
+		}
 	}
+
+	icd_flush_lat(td, icd);
+	if (nr_done)
+		put_io_u_batch(td, done, nr_done);
+
+	verify_async_flush(td);
 }
 
 /*
@@ -2100,9 +2300,12 @@ int io_u_sync_complete(struct thread_data *td, struct io_u *io_u)
 
 	init_icd(td, &icd, 1);
 	io_completed(td, &io_u, &icd);
+	icd_flush_lat(td, &icd);
 
 	if (io_u)
 		put_io_u(td, io_u);
+	else
+		verify_async_flush(td);
 
 	if (icd.error) {
 		td_verror(td, icd.error, "io_u_sync_complete");
@@ -2172,6 +2375,56 @@ void io_u_queued(struct thread_data *td, struct io_u *io_u)
 	}
 }
 
+#define GTOD_BATCH_AGE_CHECK	8
+#define GTOD_BATCH_MAX_NSEC	10000
+
+/*
+ * With gtod_batch the clock is read once per batch and every io_u stamped
+ * in that batch shares the timestamp. A batch starts at each reap, at each
+ * commit and at each issue of a sync engine, and ends before any sleep.
+ * Every GTOD_BATCH_AGE_CHECK stamps the clock is read again, and a batch
+ * older than GTOD_BATCH_MAX_NSEC is replaced. When a batch is replaced, the
+ * age of its timestamp bounds the error of the stamps handed out from it.
+ */
+void td_batch_time_set(struct thread_data *td, const struct timespec *now)
+{
+	if (td->batch_time_users && td->o.stats && ramp_time_over(td)) {
+		struct thread_data *ptd = td->parent ? td->parent : td;
+
+		add_clock_batch_sample(&ptd->ts,
+				       ntime_since(&td->batch_time, now));
+	}
+
+	td->batch_time = *now;
+	td->batch_time_users = 0;
+	td->batch_time_valid = true;
+}
+
+void td_batch_gettime(struct thread_data *td, struct timespec *ts)
+{
+	if (!td->o.gtod_batch) {
+		fio_gettime(ts, NULL);
+		return;
+	}
+
+	if (td->batch_time_valid) {
+		if (++td->batch_time_users % GTOD_BATCH_AGE_CHECK) {
+			*ts = td->batch_time;
+			return;
+		}
+
+		fio_gettime(ts, NULL);
+		if (ntime_since(&td->batch_time, ts) > GTOD_BATCH_MAX_NSEC)
+			td_batch_time_set(td, ts);
+		else
+			*ts = td->batch_time;
+		return;
+	}
+
+	fio_gettime(ts, NULL);
+	td_batch_time_set(td, ts);
+}
+
 /*
  * See if we should reuse the last seed, if dedupe is enabled
  */
@@ -2220,6 +2473,8 @@ static void save_buf_state(struct thread_data *td, struct frand_state *rs)
 		frand_copy(&td->buf_state_prev, rs);
 }
 
+#define FILL_BATCH	16
+
 void fill_io_buffer(struct thread_data *td, void *buf, unsigned long long min_write,
 		    unsigned long long max_bs)
 {
@@ -2230,11 +2485,19 @@ void fill_io_buffer(struct thread_data *td, void *buf, unsigned long long min_wr
 
 	if (o->compress_percentage || o->dedupe_percentage) {
 		unsigned int perc = td->o.compress_percentage;
+		struct frand_fill fills[FILL_BATCH];
+		unsigned int nr_fills = 0;
 		struct frand_state *rs;
 		unsigned long long left = max_bs;
 		unsigned long long this_write;
 
+		/*
+		 * Only advance the random state per chunk here, and fill the
+		 * random parts of the chunks in batches.
+		 */
 		do {
+			struct frand_fill *fill = &fills[nr_fills++];
+
 			rs = get_buf_state(td);
 
 			min_write = min(min_write, left);
@@ -2243,19 +2506,27 @@ void fill_io_buffer(struct thread_data *td, void *buf, unsigned long long min_wr
 				this_write = min_not_zero(min_write,
 							(unsigned long long) td->o.compress_chunk);
 
-				fill_random_buf_percentage(rs, buf, perc,
-					this_write, this_write,
-					o->buffer_pattern,
+				prep_random_buf_percentage(rs, fill, buf, perc,
+					this_write, o->buffer_pattern,
 					o->buffer_pattern_bytes);
 			} else {
-				fill_random_buf(rs, buf, min_write);
 				this_write = min_write;
+				fill->buf = buf;
+				fill->len = this_write;
+				fill->seed = __get_next_seed(rs);
 			}
 
 			buf += this_write;
 			left -= this_write;
 			save_buf_state(td, rs);
+
+			if (nr_fills == FILL_BATCH) {
+				__fill_random_bufs(fills, nr_fills);
+				nr_fills = 0;
+			}
 		} while (left);
+
+		__fill_random_bufs(fills, nr_fills);
 	} else if (o->buffer_pattern_bytes)
 		fill_buffer_pattern(td, buf, max_bs);
 	else if (o->zero_buffers)
@@ -2271,7 +2542,11 @@ void io_u_fill_buffer(struct thread_data *td, struct io_u *io_u,
 		      unsigned long long min_write, unsigned long long max_bs)
 {
 	io_u->buf_filled_len = 0;
-	fill_io_buffer(td, io_u->buf, min_write, max_bs);
+
+	if (td->buf_pool)
+		buf_pool_get(td, io_u->buf, max_bs);
+	else
+		fill_io_buffer(td, io_u->buf, min_write, max_bs);
 }
 
 static int do_sync_file_range(const struct thread_data *td,
@@ -22,6 +22,10 @@ enum {
 	IO_U_F_BARRIER		= 1 << 6,
 	IO_U_F_VER_LIST		= 1 << 7,
 	IO_U_F_HIGH_PRIO	= 1 << 8,
+	IO_U_F_VER_INDEX	= 1 << 9,
+	IO_U_F_VER_NONUM	= 1 << 10,
+	IO_U_F_ZONE_APPEND	= 1 << 11,
+	IO_U_F_CO_LAT		= 1 << 12,
 };
 
 /*
@@ -31,6 +35,12 @@ struct io_u {
 	struct timespec start_time;
 	struct timespec issue_time;
 
+	/*
+	 * rate_co_lat: when the rate schedule meant this IO to be issued,
+	 * in usec since td->epoch
+	 */
+	uint64_t rate_intended;
+
 	struct fio_file *file;
 	unsigned int flags;
 	enum fio_ddir ddir;
@@ -143,11 +153,14 @@ struct io_u {
 extern struct io_u *__get_io_u(struct thread_data *);
 extern struct io_u *get_io_u(struct thread_data *);
 extern void put_io_u(struct thread_data *, struct io_u *);
+extern void put_io_u_batch(struct thread_data *, struct io_u **, unsigned int);
 extern void clear_io_u(struct thread_data *, struct io_u *);
 extern void requeue_io_u(struct thread_data *, struct io_u **);
 extern int __must_check io_u_sync_complete(struct thread_data *, struct io_u *);
 extern int __must_check io_u_queued_complete(struct thread_data *, int);
 extern void io_u_queued(struct thread_data *, struct io_u *);
+extern void td_batch_gettime(struct thread_data *, struct timespec *);
+extern void td_batch_time_set(struct thread_data *, const struct timespec *);
 extern int io_u_quiesce(struct thread_data *);
 extern void io_u_log_error(struct thread_data *, struct io_u *);
 extern void io_u_mark_depth(struct thread_data *, unsigned int);
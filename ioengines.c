@@ -350,8 +350,11 @@ enum fio_q_status td_io_queue(struct thread_data *td, struct io_u *io_u)
 	if (td_ioengine_flagged(td, FIO_SYNCIO) ||
 		(td_ioengine_flagged(td, FIO_ASYNCIO_SYNC_TRIM) && 
 		io_u->ddir == DDIR_TRIM)) {
-		if (fio_fill_issue_time(td))
+		if (fio_fill_issue_time(td)) {
 			fio_gettime(&io_u->issue_time, NULL);
+			if (td->o.gtod_batch)
+				td_batch_time_set(td, &io_u->issue_time);
+		}
 
 		/*
 		 * only used for iolog
@@ -436,7 +439,7 @@ enum fio_q_status td_io_queue(struct thread_data *td, struct io_u *io_u)
 		(!td_ioengine_flagged(td, FIO_ASYNCIO_SYNC_TRIM) ||
 		 io_u->ddir != DDIR_TRIM)) {
 		if (fio_fill_issue_time(td))
-			fio_gettime(&io_u->issue_time, NULL);
+			td_batch_gettime(td, &io_u->issue_time);
 
 		/*
 		 * only used for iolog
@@ -480,6 +483,13 @@ void td_io_commit(struct thread_data *td)
 
 	io_u_mark_depth(td, td->io_u_queued);
 
+	/*
+	 * The commit starts a new clock batch, the engine stamps the issue
+	 * time of what it submits with a fresh timestamp.
+	 */
+	if (td->o.gtod_batch)
+		td_batch_time_invalidate(td);
+
 	if (td->io_ops->commit) {
 		ret = td->io_ops->commit(td);
 		if (ret)
@@ -83,6 +83,7 @@ enum fio_ioengine_flags {
 	FIO_ASYNCIO_SYNC_TRIM
 			= 1 << 14,	/* io engine has async ->queue except for trim */
 	FIO_NO_OFFLOAD	= 1 << 15,	/* no async offload */
+	FIO_ZONE_APPEND	= 1 << 16,	/* engine can issue zone appends */
 };
 
 /*
@@ -18,6 +18,7 @@
 #include "filelock.h"
 #include "smalloc.h"
 #include "blktrace.h"
+#include "verify.h"
 #include "pshared.h"
 #include "lib/roundup.h"
 
@@ -29,6 +30,8 @@
 #include <sys/un.h>
 
 static int iolog_flush(struct io_log *log);
+static int iolog_stream_open(struct io_log *log);
+static void iolog_stream_close(struct io_log *log);
 
 static const char iolog_ver2[] = "fio version 2 iolog";
 
@@ -219,6 +222,42 @@ void prune_io_piece_log(struct thread_data *td)
 		td->io_hist_len--;
 		free(ipo);
 	}
+
+	verify_index_prune(td);
+}
+
+/*
+ * Drop sorted entries overlapping a write that went to the verify index
+ */
+static void prune_overlapping_ipos(struct thread_data *td, struct io_u *io_u)
+{
+	struct fio_rb_node *n;
+	struct io_piece *__ipo;
+
+restart:
+	n = td->io_hist_tree.rb_node;
+	while (n) {
+		__ipo = rb_entry(n, struct io_piece, rb_node);
+		if (io_u->file < __ipo->file)
+			n = n->rb_left;
+		else if (io_u->file > __ipo->file)
+			n = n->rb_right;
+		else if (io_u->offset + io_u->buflen <= __ipo->offset)
+			n = n->rb_left;
+		else if (__ipo->offset + __ipo->len <= io_u->offset)
+			n = n->rb_right;
+		else {
+			dprint(FD_IO, "iolog: overlap %llu/%lu, %llu/%llu\n",
+				__ipo->offset, __ipo->len,
+				io_u->offset, io_u->buflen);
+			td->io_hist_len--;
+			rb_erase(n, &td->io_hist_tree);
+			remove_trim_entry(td, __ipo);
+			if (!(__ipo->flags & IP_F_IN_FLIGHT))
+				free(__ipo);
+			goto restart;
+		}
+	}
 }
 
 /*
@@ -229,6 +268,17 @@ void log_io_piece(struct thread_data *td, struct io_u *io_u)
 	struct fio_rb_node **p, *parent;
 	struct io_piece *ipo, *__ipo;
 
+	/*
+	 * Writes that fit the verify index go there. For the others,
+	 * make sure the index and the sorted list don't both hold a block.
+	 */
+	if (verify_index_log(td, io_u)) {
+		if (!RB_EMPTY_ROOT(&td->io_hist_tree))
+			prune_overlapping_ipos(td, io_u);
+		return;
+	} else if (td->vindex)
+		verify_index_drop(td, io_u);
+
 	ipo = calloc(1, sizeof(struct io_piece));
 	init_ipo(ipo);
 	ipo->file = io_u->file;
@@ -236,6 +286,8 @@ void log_io_piece(struct thread_data *td, struct io_u *io_u)
 	ipo->len = io_u->buflen;
 	ipo->numberio = io_u->numberio;
 	ipo->flags = IP_F_IN_FLIGHT;
+	if (io_u->flags & IO_U_F_ZONE_APPEND)
+		ipo->flags |= IP_F_ZONE_APPEND;
 
 	io_u->ipo = ipo;
 
@@ -320,6 +372,8 @@ void unlog_io_piece(struct thread_data *td, struct io_u *io_u)
 		}
 	}
 
+	verify_index_unlog(td, io_u);
+
 	if (!ipo)
 		return;
 
@@ -740,6 +794,8 @@ void setup_log(struct io_log **log, struct log_params *p,
 	l->log_prio = p->log_prio;
 	l->log_gz = p->log_gz;
 	l->log_gz_store = p->log_gz_store;
+	l->log_binary = p->log_binary;
+	l->log_mem_limit = p->log_mem_limit;
 	l->avg_msec = p->avg_msec;
 	l->hist_msec = p->hist_msec;
 	l->hist_coarseness = p->hist_coarseness;
@@ -777,7 +833,8 @@ void setup_log(struct io_log **log, struct log_params *p,
 
 	if (l->log_gz && !p->td)
 		l->log_gz = 0;
-	else if (l->log_gz || l->log_gz_store) {
+	else if (l->log_gz || l->log_gz_store || l->log_binary ||
+		 l->log_mem_limit) {
 		mutex_init_pshared(&l->chunk_lock);
 		mutex_init_pshared(&l->deferred_free_lock);
 		p->td->flags |= TD_F_COMPRESS_LOG;
@@ -830,6 +887,7 @@ void free_log(struct io_log *log)
 	}
 
 	free(log->pending);
+	free(log->spare_chunk);
 	free(log->filename);
 	sfree(log);
 }
@@ -951,8 +1009,6 @@ void flush_samples(FILE *f, void *samples, uint64_t sample_size)
 	}
 }
 
-#ifdef CONFIG_ZLIB
-
 struct iolog_flush_data {
 	struct workqueue_work work;
 	struct io_log *log;
@@ -961,6 +1017,8 @@ struct iolog_flush_data {
 	bool free;
 };
 
+#ifdef CONFIG_ZLIB
+
 #define GZ_CHUNK	131072
 
 static struct iolog_compress *get_new_chunk(unsigned int seq)
@@ -1260,8 +1318,29 @@ void flush_log(struct io_log *log, bool do_append)
 	clear_file_buffer(buf);
 }
 
+/*
+ * Logs written from the job are appended to as chunks fill up, wait for
+ * those to land and write out what is left.
+ */
+static int finish_stream_log(struct thread_data *td, struct io_log *log)
+{
+	if (stream_log(log))
+		workqueue_flush(&td->log_compress_wq);
+	iolog_flush(log);
+
+	if (!log->stream_f)
+		iolog_stream_open(log);
+	iolog_stream_close(log);
+
+	free_log(log);
+	return 0;
+}
+
 static int finish_log(struct thread_data *td, struct io_log *log, int trylock)
 {
+	if (log->log_binary || log->log_mem_limit)
+		return finish_stream_log(td, log);
+
 	if (td->flags & TD_F_COMPRESS_LOG)
 		iolog_flush(log);
 
@@ -1301,8 +1380,6 @@ size_t log_chunk_sizes(struct io_log *log)
 	return ret;
 }
 
-#ifdef CONFIG_ZLIB
-
 static void iolog_put_deferred(struct io_log *log, void *ptr)
 {
 	if (!ptr)
@@ -1335,6 +1412,48 @@ static void iolog_free_deferred(struct io_log *log)
 	pthread_mutex_unlock(&log->deferred_free_lock);
 }
 
+/*
+ * With log_mem_limit, all chunks are the same size. Hand a written chunk
+ * back to the job for reuse, so that growing the log doesn't have to
+ * allocate and fault in new memory while I/O is running.
+ */
+static void iolog_put_spare(struct io_log *log, void *ptr)
+{
+	if (log->log_mem_limit) {
+		pthread_mutex_lock(&log->deferred_free_lock);
+		if (!log->spare_chunk) {
+			log->spare_chunk = ptr;
+			ptr = NULL;
+		}
+		pthread_mutex_unlock(&log->deferred_free_lock);
+
+		/*
+		 * The job doesn't wait for the helper, so more chunks than
+		 * fit the deferred list can be written before it frees them
+		 */
+		free(ptr);
+		return;
+	}
+
+	iolog_put_deferred(log, ptr);
+}
+
+void *iolog_get_spare(struct io_log *log)
+{
+	void *ptr;
+
+	if (!log->log_mem_limit || !log->spare_chunk)
+		return NULL;
+
+	pthread_mutex_lock(&log->deferred_free_lock);
+	ptr = log->spare_chunk;
+	log->spare_chunk = NULL;
+	pthread_mutex_unlock(&log->deferred_free_lock);
+	return ptr;
+}
+
+#ifdef CONFIG_ZLIB
+
 static int gz_work(struct iolog_flush_data *data)
 {
 	struct iolog_compress *c = NULL;
@@ -1450,14 +1569,154 @@ err:
 	goto done;
 }
 
+#endif
+
+static int iolog_stream_open(struct io_log *log)
+{
+	struct iolog_bin_header hdr;
+	uint32_t flags = 0, size = sizeof(struct iolog_bin_sample);
+
+	log->stream_f = fopen(log->filename, "w");
+	if (!log->stream_f) {
+		log_err("fio: failed to open log %s: %s\n", log->filename,
+			strerror(errno));
+		return 1;
+	}
+
+	log->stream_buf = set_file_buffer(log->stream_f);
+
+	if (!log->log_binary)
+		return 0;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, FIO_BIN_LOG_MAGIC, sizeof(hdr.magic));
+	if (log->log_offset)
+		flags |= FIO_BIN_LOG_F_OFFSET;
+	if (log->log_prio)
+		flags |= FIO_BIN_LOG_F_PRIO;
+
+	hdr.version = cpu_to_le32(FIO_BIN_LOG_VERSION);
+	hdr.log_type = cpu_to_le32(log->log_type);
+	hdr.flags = cpu_to_le32(flags);
+	hdr.sample_size = cpu_to_le32(size);
+
+	if (fwrite(&hdr, sizeof(hdr), 1, log->stream_f) != 1) {
+		log_err("fio: failed to write binary log header\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+static void iolog_stream_close(struct io_log *log)
+{
+	if (!log->stream_f)
+		return;
+
+	fclose(log->stream_f);
+	clear_file_buffer(log->stream_buf);
+	log->stream_f = NULL;
+	log->stream_buf = NULL;
+}
+
+static int bin_write_samples(struct io_log *log, void *samples,
+			     uint64_t nr_samples)
+{
+	struct iolog_bin_sample out[256];
+	uint64_t i, nr = 0;
+
+	for (i = 0; i < nr_samples; i++) {
+		struct io_sample *s = __get_sample(samples, log->log_offset, i);
+		struct iolog_bin_sample *bs = &out[nr];
+		uint32_t ddir = io_sample_ddir(s), prio;
+		uint64_t offset = 0;
+
+		if (log->log_offset)
+			offset = ((struct io_sample_offset *) s)->offset;
+		if (log->log_prio)
+			prio = s->priority;
+		else
+			prio = ioprio_value_is_class_rt(s->priority);
+
+		bs->time = cpu_to_le64(s->time);
+		bs->val = cpu_to_le64(s->data.val);
+		bs->bs = cpu_to_le64(s->bs);
+		bs->offset = cpu_to_le64(offset);
+		bs->ddir = cpu_to_le32(ddir);
+		bs->prio = cpu_to_le32(prio);
+
+		if (++nr < FIO_ARRAY_SIZE(out) && i + 1 < nr_samples)
+			continue;
+
+		if (fwrite(out, sizeof(out[0]), nr, log->stream_f) != nr)
+			return 1;
+		nr = 0;
+	}
+
+	return 0;
+}
+
+/*
+ * Append a chunk of samples to a binary or streamed text log. The file
+ * (and header, for binary logs) is created on the first chunk.
+ */
+static int stream_work(struct iolog_flush_data *data)
+{
+	struct io_log *log = data->log;
+	size_t size = data->nr_samples * log_entry_sz(log);
+	int ret = 1;
+
+	if (!log->stream_f && iolog_stream_open(log))
+		goto done;
+
+	dprint(FD_COMPRESS, "stream log write samples=%u, log=%s\n",
+				data->nr_samples, log->filename);
+
+	if (log->log_binary)
+		ret = bin_write_samples(log, data->samples, data->nr_samples);
+	else {
+		flush_samples(log->stream_f, data->samples, size);
+		ret = ferror(log->stream_f);
+	}
+
+	if (ret)
+		log_err("fio: failed writing log %s\n", log->filename);
+done:
+	if (data->free) {
+		iolog_put_spare(log, data->samples);
+		if (log->log_mem_limit) {
+			pthread_mutex_lock(&log->chunk_lock);
+			log->stream_bytes -= size;
+			pthread_mutex_unlock(&log->chunk_lock);
+		}
+		sfree(data);
+	} else
+		free(data->samples);
+
+	return ret;
+}
+
+static int iolog_flush_work(struct iolog_flush_data *data)
+{
+	if (data->log->log_binary || data->log->log_mem_limit)
+		return stream_work(data);
+
+#ifdef CONFIG_ZLIB
+	return gz_work(data);
+#else
+	return 1;
+#endif
+}
+
 /*
- * Invoked from our compress helper thread, when logging would have exceeded
+ * Invoked from our log helper thread, when logging would have exceeded
  * the specified memory limitation. Compresses the previously stored
- * entries.
+ * entries, or appends them to a binary log.
  */
-static int gz_work_async(struct submit_worker *sw, struct workqueue_work *work)
+static int iolog_work_async(struct submit_worker *sw,
+			    struct workqueue_work *work)
 {
-	return gz_work(container_of(work, struct iolog_flush_data, work));
+	return iolog_flush_work(container_of(work, struct iolog_flush_data, work));
 }
 
 static int gz_init_worker(struct submit_worker *sw)
@@ -1476,7 +1735,7 @@ static int gz_init_worker(struct submit_worker *sw)
 }
 
 static struct workqueue_ops log_compress_wq_ops = {
-	.fn		= gz_work_async,
+	.fn		= iolog_work_async,
 	.init_worker_fn	= gz_init_worker,
 	.nice		= 1,
 };
@@ -1528,7 +1787,7 @@ static int iolog_flush(struct io_log *log)
 
 		sfree(cur_log);
 
-		gz_work(data);
+		iolog_flush_work(data);
 	}
 
 	free(data);
@@ -1538,6 +1797,7 @@ static int iolog_flush(struct io_log *log)
 int iolog_cur_flush(struct io_log *log, struct io_logs *cur_log)
 {
 	struct iolog_flush_data *data;
+	bool over_limit = false;
 
 	data = smalloc(sizeof(*data));
 	if (!data)
@@ -1552,35 +1812,33 @@ int iolog_cur_flush(struct io_log *log, struct io_logs *cur_log)
 	cur_log->nr_samples = cur_log->max_samples = 0;
 	cur_log->log = NULL;
 
-	workqueue_enqueue(&log->td->log_compress_wq, &data->work);
+	if (log->log_mem_limit) {
+		size_t size = data->nr_samples * log_entry_sz(log);
 
-	iolog_free_deferred(log);
+		pthread_mutex_lock(&log->chunk_lock);
+		log->stream_bytes += size;
+		over_limit = log->stream_bytes > log->log_mem_limit / 2;
+		pthread_mutex_unlock(&log->chunk_lock);
+	}
 
-	return 0;
-}
-#else
+	workqueue_enqueue(&log->td->log_compress_wq, &data->work);
 
-static int iolog_flush(struct io_log *log)
-{
-	return 1;
-}
+	/*
+	 * The log helper can't keep up with the samples we generate. Waiting
+	 * for it here would stall submission, so let the queue go over the
+	 * limit and say so once.
+	 */
+	if (over_limit && !log->mem_limit_warned) {
+		log_info("fio: %s: log writes falling behind, over log_mem_limit\n",
+				log->filename);
+		log->mem_limit_warned = true;
+	}
 
-int iolog_cur_flush(struct io_log *log, struct io_logs *cur_log)
-{
-	return 1;
-}
+	iolog_free_deferred(log);
 
-int iolog_compress_init(struct thread_data *td, struct sk_out *sk_out)
-{
 	return 0;
 }
 
-void iolog_compress_exit(struct thread_data *td)
-{
-}
-
-#endif
-
 struct io_logs *iolog_cur_log(struct io_log *log)
 {
 	if (flist_empty(&log->io_logs))
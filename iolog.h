@@ -51,6 +51,35 @@ struct io_sample_offset {
 	uint64_t offset;
 };
 
+/*
+ * On-disk format of log_binary logs: a struct iolog_bin_header followed by
+ * fixed size struct iolog_bin_sample records, all little endian.
+ */
+#define FIO_BIN_LOG_MAGIC	"fiobinlg"
+#define FIO_BIN_LOG_VERSION	1U
+
+enum {
+	FIO_BIN_LOG_F_OFFSET	= 1 << 0,	/* offset field is valid */
+	FIO_BIN_LOG_F_PRIO	= 1 << 1,	/* prio is the full priority */
+};
+
+struct iolog_bin_header {
+	uint8_t magic[8];
+	uint32_t version;
+	uint32_t log_type;
+	uint32_t flags;
+	uint32_t sample_size;
+};
+
+struct iolog_bin_sample {
+	uint64_t time;		/* msec */
+	uint64_t val;
+	uint64_t bs;
+	uint64_t offset;
+	uint32_t ddir;
+	uint32_t prio;		/* RT class flag unless FIO_BIN_LOG_F_PRIO */
+};
+
 enum {
 	IO_LOG_TYPE_LAT = 1,
 	IO_LOG_TYPE_CLAT,
@@ -119,6 +148,25 @@ struct io_log {
 	 */
 	unsigned int log_gz_store;
 
+	/*
+	 * Write struct iolog_bin_sample records instead of text. Per unit
+	 * logs are appended from the log helper thread as chunks fill up.
+	 */
+	unsigned int log_binary;
+
+	/*
+	 * If set, per unit text logs are streamed like binary logs, and the
+	 * chunks kept in memory are sized so that the current, queued and
+	 * spare chunks stay below this many bytes.
+	 */
+	unsigned long long log_mem_limit;
+	uint64_t stream_bytes;
+	bool mem_limit_warned;
+	void *spare_chunk;
+
+	FILE *stream_f;
+	void *stream_buf;
+
 	/*
 	 * Windowed average, for logging single entries average over some
 	 * period of time.
@@ -207,6 +255,7 @@ enum {
 	IP_F_ONLIST	= 2,
 	IP_F_TRIMMED	= 4,
 	IP_F_IN_FLIGHT	= 8,
+	IP_F_ZONE_APPEND = 16,
 };
 
 /*
@@ -257,6 +306,9 @@ extern void write_iolog_close(struct thread_data *);
 extern int iolog_compress_init(struct thread_data *, struct sk_out *);
 extern void iolog_compress_exit(struct thread_data *);
 extern size_t log_chunk_sizes(struct io_log *);
+extern void *iolog_get_spare(struct io_log *);
+extern int init_io_u(struct thread_data *);
+extern void cleanup_io_u(struct thread_data *);
 extern int init_io_u_buffers(struct thread_data *);
 
 #ifdef CONFIG_ZLIB
@@ -277,6 +329,8 @@ struct log_params {
 	int log_gz;
 	int log_gz_store;
 	int log_compress;
+	int log_binary;
+	unsigned long long log_mem_limit;
 };
 
 static inline bool per_unit_log(struct io_log *log)
@@ -284,6 +338,15 @@ static inline bool per_unit_log(struct io_log *log)
 	return log && (!log->avg_msec || log->log_gz || log->log_gz_store);
 }
 
+/*
+ * Logs that the job writes out itself as they fill up, rather than keeping
+ * all samples around until the end of the run.
+ */
+static inline bool stream_log(struct io_log *log)
+{
+	return (log->log_binary || log->log_mem_limit) && per_unit_log(log);
+}
+
 static inline bool inline_log(struct io_log *log)
 {
 	return log->log_type == IO_LOG_TYPE_LAT ||
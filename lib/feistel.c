@@ -0,0 +1,91 @@
+#include "feistel.h"
+
+/*
+ * A balanced Feistel network over the smallest even number of bits that
+ * holds nr - 1 is a bijection on a domain of less than 4 * nr values.
+ * Values outside 0..nr-1 are fed through the network again (cycle walking)
+ * until they land inside it, which keeps the result a permutation of
+ * 0..nr-1 and takes fewer than four passes on average.
+ */
+
+static uint64_t splitmix64(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+static inline uint64_t feistel_round(uint64_t r, uint64_t key)
+{
+	r ^= key;
+	r *= 0xff51afd7ed558ccdULL;
+	r ^= r >> 33;
+	r *= 0xc4ceb9fe1a85ec53ULL;
+	return r ^ (r >> 29);
+}
+
+static uint64_t feistel_permute(const struct fio_feistel *fp, uint64_t val)
+{
+	uint64_t l = val >> fp->half_bits;
+	uint64_t r = val & fp->half_mask;
+	unsigned int i;
+
+	for (i = 0; i < FIO_FEISTEL_ROUNDS; i++) {
+		uint64_t t = r;
+
+		r = l ^ (feistel_round(r, fp->keys[i]) & fp->half_mask);
+		l = t;
+	}
+
+	return (l << fp->half_bits) | r;
+}
+
+uint64_t feistel_map(const struct fio_feistel *fp, uint64_t idx)
+{
+	uint64_t val = idx;
+
+	do {
+		val = feistel_permute(fp, val);
+	} while (val >= fp->nr);
+
+	return val;
+}
+
+int feistel_next(struct fio_feistel *fp, uint64_t *off)
+{
+	if (fp->pos >= fp->nr)
+		return 1;
+
+	*off = feistel_map(fp, fp->pos++);
+	return 0;
+}
+
+void feistel_reset(struct fio_feistel *fp, uint64_t seed)
+{
+	unsigned int i;
+
+	for (i = 0; i < FIO_FEISTEL_ROUNDS; i++)
+		fp->keys[i] = splitmix64(&seed);
+
+	fp->pos = 0;
+}
+
+int feistel_init(struct fio_feistel *fp, uint64_t nr, uint64_t seed)
+{
+	unsigned int bits = 0;
+	uint64_t max;
+
+	if (!nr)
+		return 1;
+
+	for (max = nr - 1; max; max >>= 1)
+		bits++;
+
+	fp->nr = nr;
+	fp->half_bits = bits < 2 ? 1 : (bits + 1) / 2;
+	fp->half_mask = (1ULL << fp->half_bits) - 1;
+	feistel_reset(fp, seed);
+	return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef FIO_FEISTEL_H
+#define FIO_FEISTEL_H
+
+#include <inttypes.h>
+
+#define FIO_FEISTEL_ROUNDS	6
+
+/*
+ * Keyed permutation of the block indexes 0..nr-1. The i'th value handed out
+ * is feistel_map(i), so the sequence can be restarted or seeked into at any
+ * point without replaying it.
+ */
+struct fio_feistel {
+	uint64_t nr;
+	uint64_t pos;
+	uint64_t half_mask;
+	unsigned int half_bits;
+	uint64_t keys[FIO_FEISTEL_ROUNDS];
+};
+
+int feistel_init(struct fio_feistel *fp, uint64_t nr, uint64_t seed);
+void feistel_reset(struct fio_feistel *fp, uint64_t seed);
+uint64_t feistel_map(const struct fio_feistel *fp, uint64_t idx);
+int feistel_next(struct fio_feistel *fp, uint64_t *off);
+
+#endif
@@ -122,6 +122,55 @@ void __fill_random_buf(void *buf, unsigned int len, uint64_t seed)
 	}
 }
 
+/*
+ * Each buffer is filled from a serial multiply/shift chain, so a single
+ * buffer is bound by the latency of that chain. Run several independent
+ * chains in lockstep to fill a batch of buffers, the contents are the same
+ * as from __fill_random_buf() on each of them.
+ */
+#define FRAND_FILL_LANES	4
+
+static void __fill_random_buf_lanes(struct frand_fill *fills)
+{
+	uint64_t *p[FRAND_FILL_LANES], s[FRAND_FILL_LANES];
+	unsigned int i, j, words = -1U;
+
+	for (j = 0; j < FRAND_FILL_LANES; j++) {
+		p[j] = fills[j].buf;
+		s[j] = fills[j].seed;
+		if (fills[j].len / sizeof(uint64_t) < words)
+			words = fills[j].len / sizeof(uint64_t);
+	}
+
+	for (i = 0; i < words; i++) {
+		for (j = 0; j < FRAND_FILL_LANES; j++) {
+			p[j][i] = s[j];
+			s[j] *= GOLDEN_RATIO_PRIME;
+			s[j] >>= 3;
+		}
+	}
+
+	for (j = 0; j < FRAND_FILL_LANES; j++) {
+		unsigned int done = words * sizeof(uint64_t);
+
+		__fill_random_buf(p[j] + words, fills[j].len - done, s[j]);
+	}
+}
+
+void __fill_random_bufs(struct frand_fill *fills, unsigned int nr)
+{
+	while (nr >= FRAND_FILL_LANES) {
+		__fill_random_buf_lanes(fills);
+		fills += FRAND_FILL_LANES;
+		nr -= FRAND_FILL_LANES;
+	}
+
+	while (nr--) {
+		__fill_random_buf(fills->buf, fills->len, fills->seed);
+		fills++;
+	}
+}
+
 uint64_t fill_random_buf(struct frand_state *fs, void *buf,
 			 unsigned int len)
 {
@@ -180,6 +229,36 @@ void __fill_random_buf_percentage(uint64_t seed, void *buf,
 	}
 }
 
+/*
+ * Like fill_random_buf_percentage() with segment == len, except that only
+ * the pattern part is filled here. The random part is described in 'fill',
+ * for the caller to batch up with __fill_random_bufs().
+ */
+uint64_t prep_random_buf_percentage(struct frand_state *fs,
+				    struct frand_fill *fill, void *buf,
+				    unsigned int percentage, unsigned int len,
+				    char *pattern, unsigned int pbytes)
+{
+	uint64_t r = __get_next_seed(fs);
+	unsigned int rand_len = 0;
+
+	if (percentage != 100)
+		rand_len = ((unsigned long long)len * (100 - percentage)) / 100;
+
+	if (rand_len < len) {
+		if (pbytes)
+			(void)cpy_pattern(pattern, pbytes, buf + rand_len,
+					  len - rand_len);
+		else
+			memset(buf + rand_len, 0, len - rand_len);
+	}
+
+	fill->buf = buf;
+	fill->len = rand_len;
+	fill->seed = r;
+	return r;
+}
+
 uint64_t fill_random_buf_percentage(struct frand_state *fs, void *buf,
 				    unsigned int percentage,
 				    unsigned int segment, unsigned int len,
@@ -160,11 +160,22 @@ static inline uint64_t __get_next_seed(struct frand_state *fs)
 	return r;
 }
 
+/*
+ * A deferred __fill_random_buf() call, see __fill_random_bufs()
+ */
+struct frand_fill {
+	void *buf;
+	unsigned int len;
+	uint64_t seed;
+};
+
 extern void init_rand(struct frand_state *, bool);
 extern void init_rand_seed(struct frand_state *, uint64_t seed, bool);
 extern void __fill_random_buf(void *buf, unsigned int len, uint64_t seed);
 extern uint64_t fill_random_buf(struct frand_state *, void *buf, unsigned int len);
 extern void __fill_random_buf_percentage(uint64_t, void *, unsigned int, unsigned int, unsigned int, char *, unsigned int);
 extern uint64_t fill_random_buf_percentage(struct frand_state *, void *, unsigned int, unsigned int, unsigned int, char *, unsigned int);
+extern void __fill_random_bufs(struct frand_fill *, unsigned int);
+extern uint64_t prep_random_buf_percentage(struct frand_state *, struct frand_fill *, void *, unsigned int, unsigned int, char *, unsigned int);
 
 #endif
@@ -34,6 +34,8 @@
 #include "filelock.h"
 #include "helper_thread.h"
 #include "filehash.h"
+#include "arrival.h"
+#include "buf_pool.h"
 
 FLIST_HEAD(disk_list);
 
@@ -122,10 +124,15 @@ void clear_io_state(struct thread_data *td, int all)
 	}
 
 	/*
-	 * Re-Seed random number generator if rand_repeatable is true
+	 * Re-Seed random number generator if rand_repeatable is true. The
+	 * buffer pool helper generates from td->buf_state, so stop it first
+	 * and have it start over from the new seeds.
 	 */
-	if (td->o.rand_repeatable)
+	if (td->o.rand_repeatable) {
+		buf_pool_drain(td);
 		td_fill_rand_seeds(td);
+		buf_pool_refill(td);
+	}
 }
 
 void reset_all_stats(struct thread_data *td)
@@ -148,6 +155,7 @@ void reset_all_stats(struct thread_data *td)
 	memcpy(&td->iops_sample_time, &td->epoch, sizeof(td->epoch));
 	memcpy(&td->bw_sample_time, &td->epoch, sizeof(td->epoch));
 	memcpy(&td->ss.prev_time, &td->epoch, sizeof(td->epoch));
+	arrival_reset(td);
 
 	lat_target_reset(td);
 	clear_rusage_stat(td);
@@ -374,7 +382,10 @@ int initialize_fio(char *envp[])
 	compiletime_assert((offsetof(struct jobs_eta, m_rate) % 8) == 0, "m_rate");
 
 	compiletime_assert(__TD_F_LAST <= TD_ENG_FLAG_SHIFT, "TD_ENG_FLAG_SHIFT");
+	compiletime_assert(FIO_ZONE_APPEND <= TD_ENG_FLAG_MASK, "TD_ENG_FLAG_MASK");
+	compiletime_assert(TD_ENG_FLAG_SHIFT + 17 <= 8 * sizeof(((struct thread_data *) NULL)->flags), "td->flags engine bits");
 	compiletime_assert(BSSPLIT_MAX <= ZONESPLIT_MAX, "bsssplit/zone max");
+	compiletime_assert(FIO_IO_U_PLAT_GROUP_NR <= 32, "io_u_plat_groups");
 
 	err = endian_check();
 	if (err) {
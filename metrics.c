@@ -0,0 +1,548 @@
+/*
+ * OpenMetrics exporter. When --metrics-port is given, the helper thread
+ * listens on that port on the loopback interface and answers HTTP GETs
+ * with the current per-job, per-group and per-disk stats.
+ *
+ * Rates are sampled once per METRICS_RATE_MSEC from the helper timer, so
+ * a scrape only formats what's already there. Latency histograms are
+ * folded into power of two buckets, skipping the bucket groups that have
+ * no samples.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "fio.h"
+#include "diskutil.h"
+#include "metrics.h"
+#include "lib/output_buffer.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL	0
+#endif
+
+/* how long a client gets to send its request, and to read the reply */
+#define METRICS_REQ_MSEC	1000
+#define METRICS_REPLY_MSEC	10000
+
+/* scrapes served at the same time, others wait in the listen backlog */
+#define METRICS_MAX_CLIENTS	4
+
+unsigned int metrics_port;
+
+struct metrics_job {
+	uint64_t bytes[DDIR_RWDIR_CNT];
+	uint64_t ios[DDIR_RWDIR_CNT];
+	uint64_t bw[DDIR_RWDIR_CNT];
+	uint64_t iops[DDIR_RWDIR_CNT];
+};
+
+struct metrics_client {
+	int fd;
+	struct timespec start;
+	char req[1024];
+	size_t req_len;
+	char *reply;
+	size_t reply_len;
+	size_t reply_off;
+};
+
+static struct metrics_data {
+	int fd;
+	struct metrics_client clients[METRICS_MAX_CLIENTS];
+	unsigned int nr_jobs;
+	struct metrics_job *jobs;
+	struct timespec last_sample;
+	struct buf_output out;
+} *metrics;
+
+static void metrics_printf(struct buf_output *out, const char *fmt, ...)
+{
+	char buf[512];
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+
+	if (len < 0)
+		return;
+	buf_output_add(out, buf, min((size_t) len, sizeof(buf) - 1));
+}
+
+/*
+ * Job names are free form, quote them as OpenMetrics label values.
+ */
+static const char *metrics_label(const char *name, char *buf, size_t len)
+{
+	size_t i = 0;
+
+	for (; *name && i + 2 < len; name++) {
+		if (*name == '\\' || *name == '"') {
+			buf[i++] = '\\';
+			buf[i++] = *name;
+		} else if (*name == '\n') {
+			buf[i++] = '\\';
+			buf[i++] = 'n';
+		} else
+			buf[i++] = *name;
+	}
+	buf[i] = '\0';
+	return buf;
+}
+
+static void metrics_sample_rates(void)
+{
+	struct thread_data *td;
+	struct timespec now;
+	uint64_t msec;
+	int i;
+
+	fio_gettime(&now, NULL);
+	msec = mtime_since(&metrics->last_sample, &now);
+	if (msec < METRICS_RATE_MSEC)
+		return;
+
+	for_each_td(td, i) {
+		struct metrics_job *mj;
+
+		if (i >= metrics->nr_jobs)
+			break;
+
+		mj = &metrics->jobs[i];
+		for_each_rw_ddir(ddir) {
+			uint64_t bytes = td->io_bytes[ddir];
+			uint64_t ios = td->io_blocks[ddir];
+
+			mj->bw[ddir] = (bytes - mj->bytes[ddir]) * 1000 / msec;
+			mj->iops[ddir] = (ios - mj->ios[ddir]) * 1000 / msec;
+			mj->bytes[ddir] = bytes;
+			mj->ios[ddir] = ios;
+		}
+	}
+
+	metrics->last_sample = now;
+}
+
+static void metrics_job_counters(struct buf_output *out)
+{
+	static const char *names[] = { "io_bytes", "ios" };
+	struct thread_data *td;
+	char label[256];
+	int i, j;
+
+	for (j = 0; j < FIO_ARRAY_SIZE(names); j++) {
+		metrics_printf(out, "# TYPE fio_job_%s counter\n", names[j]);
+		for_each_td(td, i) {
+			metrics_label(td->o.name, label, sizeof(label));
+			for_each_rw_ddir(ddir) {
+				metrics_printf(out,
+					"fio_job_%s_total{job=\"%s\",jobid=\"%d\",group=\"%u\",ddir=\"%s\"} %llu\n",
+					names[j], label, i, td->groupid,
+					io_ddir_name(ddir),
+					(unsigned long long) (j ? td->io_blocks[ddir] :
+							      td->io_bytes[ddir]));
+			}
+		}
+	}
+}
+
+static void metrics_job_rates(struct buf_output *out)
+{
+	struct thread_data *td;
+	char label[256];
+	int i;
+
+	metrics_printf(out, "# TYPE fio_job_iops gauge\n");
+	for_each_td(td, i) {
+		if (i >= metrics->nr_jobs)
+			break;
+		metrics_label(td->o.name, label, sizeof(label));
+		for_each_rw_ddir(ddir) {
+			metrics_printf(out,
+				"fio_job_iops{job=\"%s\",jobid=\"%d\",group=\"%u\",ddir=\"%s\"} %llu\n",
+				label, i, td->groupid, io_ddir_name(ddir),
+				(unsigned long long) metrics->jobs[i].iops[ddir]);
+		}
+	}
+
+	metrics_printf(out, "# TYPE fio_job_bandwidth_bytes_per_second gauge\n");
+	for_each_td(td, i) {
+		if (i >= metrics->nr_jobs)
+			break;
+		metrics_label(td->o.name, label, sizeof(label));
+		for_each_rw_ddir(ddir) {
+			metrics_printf(out,
+				"fio_job_bandwidth_bytes_per_second{job=\"%s\",jobid=\"%d\",group=\"%u\",ddir=\"%s\"} %llu\n",
+				label, i, td->groupid, io_ddir_name(ddir),
+				(unsigned long long) metrics->jobs[i].bw[ddir]);
+		}
+	}
+
+	metrics_printf(out, "# TYPE fio_job_inflight gauge\n");
+	for_each_td(td, i) {
+		metrics_label(td->o.name, label, sizeof(label));
+		metrics_printf(out,
+			"fio_job_inflight{job=\"%s\",jobid=\"%d\",group=\"%u\"} %u\n",
+			label, i, td->groupid, td->io_u_in_flight);
+	}
+}
+
+static void metrics_job_hist(struct buf_output *out, enum fio_lat lat,
+			     const char *name)
+{
+	uint64_t hist[FIO_PLAT_POW2_NR], cum;
+	struct thread_data *td;
+	char label[256];
+	int i, j;
+
+	metrics_printf(out, "# TYPE fio_job_%s_seconds histogram\n", name);
+	for_each_td(td, i) {
+		struct thread_stat *ts = &td->ts;
+
+		if (lat == FIO_CLAT && !ts->clat_percentiles)
+			continue;
+		if (lat == FIO_LAT && !ts->lat_percentiles)
+			continue;
+
+		metrics_label(td->o.name, label, sizeof(label));
+		for_each_rw_ddir(ddir) {
+			struct io_stat *is = lat == FIO_CLAT ?
+				&ts->clat_stat[ddir] : &ts->lat_stat[ddir];
+			uint64_t total;
+
+			total = plat_fold_pow2(ts->io_u_plat[lat][ddir],
+					ts->io_u_plat_groups[lat][ddir],
+					ts->plat_bits, hist);
+
+			cum = 0;
+			for (j = 0; j < FIO_PLAT_POW2_NR - 1; j++) {
+				cum += hist[j];
+				metrics_printf(out,
+					"fio_job_%s_seconds_bucket{job=\"%s\",jobid=\"%d\",group=\"%u\",ddir=\"%s\",le=\"%.9g\"} %llu\n",
+					name, label, i, td->groupid,
+					io_ddir_name(ddir),
+					(double) (1ULL << (j + FIO_PLAT_POW2_MIN)) / 1e9,
+					(unsigned long long) cum);
+			}
+			metrics_printf(out,
+				"fio_job_%s_seconds_bucket{job=\"%s\",jobid=\"%d\",group=\"%u\",ddir=\"%s\",le=\"+Inf\"} %llu\n",
+				name, label, i, td->groupid, io_ddir_name(ddir),
+				(unsigned long long) total);
+			metrics_printf(out,
+				"fio_job_%s_seconds_count{job=\"%s\",jobid=\"%d\",group=\"%u\",ddir=\"%s\"} %llu\n",
+				name, label, i, td->groupid, io_ddir_name(ddir),
+				(unsigned long long) total);
+			metrics_printf(out,
+				"fio_job_%s_seconds_sum{job=\"%s\",jobid=\"%d\",group=\"%u\",ddir=\"%s\"} %g\n",
+				name, label, i, td->groupid, io_ddir_name(ddir),
+				is->mean.u.f * is->samples / 1e9);
+		}
+	}
+}
+
+static void metrics_groups(struct buf_output *out)
+{
+	static const char *names[] = { "iops", "bandwidth_bytes_per_second",
+				       "inflight" };
+	struct thread_data *td;
+	uint64_t sum[DDIR_RWDIR_CNT];
+	unsigned int groupid;
+	int i, j;
+
+	for (j = 0; j < FIO_ARRAY_SIZE(names); j++) {
+		metrics_printf(out, "# TYPE fio_group_%s gauge\n", names[j]);
+
+		/* jobs of a group are contiguous */
+		groupid = -1U;
+		memset(sum, 0, sizeof(sum));
+		for_each_td(td, i) {
+			if (i >= metrics->nr_jobs)
+				break;
+
+			if (td->groupid != groupid && groupid != -1U) {
+				if (j == 2)
+					metrics_printf(out,
+						"fio_group_inflight{group=\"%u\"} %llu\n",
+						groupid,
+						(unsigned long long) sum[0]);
+				else
+					for_each_rw_ddir(ddir)
+						metrics_printf(out,
+							"fio_group_%s{group=\"%u\",ddir=\"%s\"} %llu\n",
+							names[j], groupid,
+							io_ddir_name(ddir),
+							(unsigned long long) sum[ddir]);
+				memset(sum, 0, sizeof(sum));
+			}
+			groupid = td->groupid;
+
+			if (j == 2) {
+				sum[0] += td->io_u_in_flight;
+				continue;
+			}
+			for_each_rw_ddir(ddir)
+				sum[ddir] += j ? metrics->jobs[i].bw[ddir] :
+						 metrics->jobs[i].iops[ddir];
+		}
+
+		if (groupid == -1U)
+			continue;
+		if (j == 2)
+			metrics_printf(out, "fio_group_inflight{group=\"%u\"} %llu\n",
+				       groupid, (unsigned long long) sum[0]);
+		else
+			for_each_rw_ddir(ddir)
+				metrics_printf(out,
+					"fio_group_%s{group=\"%u\",ddir=\"%s\"} %llu\n",
+					names[j], groupid, io_ddir_name(ddir),
+					(unsigned long long) sum[ddir]);
+	}
+}
+
+static void metrics_disks(struct buf_output *out)
+{
+	struct flist_head *entry;
+	struct disk_util *du;
+	char label[256];
+
+	if (flist_empty(&disk_list))
+		return;
+
+	metrics_printf(out, "# TYPE fio_disk_util_ratio gauge\n");
+	flist_for_each(entry, &disk_list) {
+		struct disk_util_stats *s;
+		double util = 0.0;
+
+		du = flist_entry(entry, struct disk_util, list);
+		s = &du->dus.s;
+		if (s->msec)
+			util = (double) s->io_ticks / (double) s->msec;
+		if (util > 1.0)
+			util = 1.0;
+
+		metrics_label((char *) du->dus.name, label, sizeof(label));
+		metrics_printf(out, "fio_disk_util_ratio{disk=\"%s\"} %g\n",
+			       label, util);
+	}
+
+	metrics_printf(out, "# TYPE fio_disk_ios counter\n");
+	flist_for_each(entry, &disk_list) {
+		struct disk_util_stats *s;
+
+		du = flist_entry(entry, struct disk_util, list);
+		s = &du->dus.s;
+
+		metrics_label((char *) du->dus.name, label, sizeof(label));
+		metrics_printf(out,
+			       "fio_disk_ios_total{disk=\"%s\",ddir=\"read\"} %llu\n",
+			       label, (unsigned long long) s->ios[0]);
+		metrics_printf(out,
+			       "fio_disk_ios_total{disk=\"%s\",ddir=\"write\"} %llu\n",
+			       label, (unsigned long long) s->ios[1]);
+	}
+}
+
+static void metrics_build(struct buf_output *out)
+{
+	out->buflen = 0;
+
+	metrics_job_counters(out);
+	metrics_job_rates(out);
+	metrics_job_hist(out, FIO_CLAT, "clat");
+	metrics_job_hist(out, FIO_LAT, "lat");
+	metrics_groups(out);
+	metrics_disks(out);
+	metrics_printf(out, "# EOF\n");
+}
+
+/*
+ * Scrapers are served from the helper thread without ever blocking it.
+ * Client sockets are non-blocking, and each timer tick only reads and
+ * writes what the socket takes without waiting. A client that doesn't
+ * get its request in or its reply out in time is dropped.
+ */
+static void metrics_client_close(struct metrics_client *c)
+{
+	close(c->fd);
+	free(c->reply);
+	memset(c, 0, sizeof(*c));
+	c->fd = -1;
+}
+
+static void metrics_client_reply(struct metrics_client *c)
+{
+	static const char not_found[] =
+		"HTTP/1.0 404 Not Found\r\n"
+		"Content-Length: 0\r\n"
+		"Connection: close\r\n\r\n";
+	struct buf_output *out = &metrics->out;
+	char hdr[256];
+	int len;
+
+	if (strncmp(c->req, "GET /metrics", 12) && strncmp(c->req, "GET / ", 6)) {
+		c->reply = strdup(not_found);
+		c->reply_len = sizeof(not_found) - 1;
+		return;
+	}
+
+	metrics_build(out);
+
+	len = snprintf(hdr, sizeof(hdr),
+		"HTTP/1.0 200 OK\r\n"
+		"Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+		"Content-Length: %zu\r\n"
+		"Connection: close\r\n\r\n", out->buflen);
+
+	c->reply = malloc(len + out->buflen);
+	memcpy(c->reply, hdr, len);
+	memcpy(c->reply + len, out->buf, out->buflen);
+	c->reply_len = len + out->buflen;
+}
+
+/*
+ * Read the request line, then send the reply. Returns false when the
+ * client is done with, or should be dropped.
+ */
+static bool metrics_client_run(struct metrics_client *c, struct timespec *now)
+{
+	ssize_t ret;
+
+	while (!c->reply) {
+		if (mtime_since(&c->start, now) > METRICS_REQ_MSEC)
+			return false;
+
+		ret = recv(c->fd, c->req + c->req_len,
+			   sizeof(c->req) - 1 - c->req_len, MSG_DONTWAIT);
+		if (ret < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK ||
+				errno == EINTR;
+		if (!ret)
+			return false;
+
+		c->req_len += ret;
+		c->req[c->req_len] = '\0';
+		if (strchr(c->req, '\n') || c->req_len == sizeof(c->req) - 1)
+			metrics_client_reply(c);
+	}
+
+	while (c->reply_off < c->reply_len) {
+		if (mtime_since(&c->start, now) > METRICS_REPLY_MSEC)
+			return false;
+
+		ret = send(c->fd, c->reply + c->reply_off,
+			   c->reply_len - c->reply_off,
+			   MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (ret < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK ||
+				errno == EINTR;
+
+		c->reply_off += ret;
+	}
+
+	return false;
+}
+
+/*
+ * Helper thread timer: refresh the rates and make progress on scrapes.
+ */
+int metrics_check(void)
+{
+	struct timespec now;
+	int i;
+
+	if (!metrics)
+		return 0;
+
+	metrics_sample_rates();
+	fio_gettime(&now, NULL);
+
+	for (i = 0; i < METRICS_MAX_CLIENTS; i++) {
+		struct metrics_client *c = &metrics->clients[i];
+
+		if (c->fd < 0) {
+			c->fd = accept(metrics->fd, NULL, NULL);
+			if (c->fd < 0)
+				continue;
+			c->start = now;
+		}
+
+		if (!metrics_client_run(c, &now))
+			metrics_client_close(c);
+	}
+
+	return 0;
+}
+
+int metrics_setup(void)
+{
+	struct sockaddr_in addr = { .sin_family = AF_INET };
+	int fd, i, opt = 1;
+
+	if (!metrics_port)
+		return 0;
+
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		log_err("fio: metrics socket: %s\n", strerror(errno));
+		return 1;
+	}
+
+	if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (void *) &opt,
+		       sizeof(opt)) < 0) {
+		log_err("fio: metrics setsockopt: %s\n", strerror(errno));
+		goto err;
+	}
+
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(metrics_port);
+	if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		log_err("fio: metrics bind to port %u: %s\n", metrics_port,
+			strerror(errno));
+		goto err;
+	}
+	if (listen(fd, 16) < 0) {
+		log_err("fio: metrics listen: %s\n", strerror(errno));
+		goto err;
+	}
+	if (fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+		log_err("fio: metrics fcntl: %s\n", strerror(errno));
+		goto err;
+	}
+
+	metrics = calloc(1, sizeof(*metrics));
+	metrics->fd = fd;
+	for (i = 0; i < METRICS_MAX_CLIENTS; i++)
+		metrics->clients[i].fd = -1;
+	metrics->nr_jobs = thread_number;
+	metrics->jobs = calloc(thread_number, sizeof(struct metrics_job));
+	buf_output_init(&metrics->out);
+	fio_gettime(&metrics->last_sample, NULL);
+	return 0;
+err:
+	close(fd);
+	return 1;
+}
+
+void metrics_exit(void)
+{
+	int i;
+
+	if (!metrics)
+		return;
+
+	for (i = 0; i < METRICS_MAX_CLIENTS; i++) {
+		if (metrics->clients[i].fd >= 0)
+			metrics_client_close(&metrics->clients[i]);
+	}
+	close(metrics->fd);
+	buf_output_free(&metrics->out);
+	free(metrics->jobs);
+	free(metrics);
+	metrics = NULL;
+}
@@ -0,0 +1,15 @@
+#ifndef FIO_METRICS_H
+#define FIO_METRICS_H
+
+extern int metrics_setup(void);
+extern int metrics_check(void);
+extern void metrics_exit(void);
+
+extern unsigned int metrics_port;
+
+/* how often the helper thread looks for scrapes */
+#define METRICS_MSEC		100
+/* rate sampling period */
+#define METRICS_RATE_MSEC	1000
+
+#endif
@@ -189,6 +189,10 @@ static const struct opt_group fio_opt_cat_groups[] = {
 		.name	= "NFS I/O engine", /* nfs */
 		.mask	= FIO_OPT_G_NFS,
 	},
+	{
+		.name	= "Emulated zoned block device I/O engine", /* zbdemu */
+		.mask	= FIO_OPT_G_ZBDEMU,
+	},
 	{
 		.name	= NULL,
 	},
@@ -14,6 +14,7 @@
 #include "options.h"
 #include "optgroup.h"
 #include "zbd.h"
+#include "arrival.h"
 
 char client_sockaddr_str[INET6_ADDRSTRLEN] = { 0 };
 
@@ -2377,6 +2378,10 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 			    .oval = FIO_RAND_GEN_TAUSWORTHE64,
 			    .help = "64-bit Tausworthe variant",
 			  },
+			  { .ival = "feistel",
+			    .oval = FIO_RAND_GEN_FEISTEL,
+			    .help = "Keyed Feistel permutation of the blocks",
+			  },
 		},
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_RANDOM,
@@ -2951,6 +2956,10 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 			    .oval = VERIFY_XXHASH,
 			    .help = "Use xxhash checksums for verification",
 			  },
+			  { .ival = "xxh3",
+			    .oval = VERIFY_XXH3,
+			    .help = "Use xxh3 checksums for verification",
+			  },
 			  /* Meta information was included into verify_header,
 			   * 'meta' verification is implied by default. */
 			  { .ival = "meta",
@@ -3069,6 +3078,20 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_VERIFY,
 	},
+	{
+		.name	= "verify_workers",
+		.lname	= "Verify workers",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, verify_workers),
+		.minval	= 0,
+		.maxval	= 128,
+		.def	= "0",
+		.help	= "Number of threads issuing the verify phase reads",
+		.parent	= "verify",
+		.hide	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_VERIFY,
+	},
 	{
 		.name	= "verify_backlog",
 		.lname	= "Verify backlog",
@@ -3143,6 +3166,19 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_VERIFY,
 	},
+	{
+		.name	= "verify_state_journal",
+		.lname	= "Verify state journal",
+		.off1	= offsetof(struct thread_options, verify_state_journal),
+		.type	= FIO_OPT_INT,
+		.minval	= 0,
+		.maxval	= VJOURNAL_MAX_RECS,
+		.def	= "0",
+		.help	= "Journal completed writes in batches of this many",
+		.parent	= "verify",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_VERIFY,
+	},
 #ifdef FIO_HAVE_TRIM
 	{
 		.name	= "trim_percentage",
@@ -3494,6 +3530,26 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_INVALID,
 	},
+	{
+		.name	= "exclusive_zones",
+		.lname	= "Exclusive zones",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, exclusive_zones),
+		.def	= "0",
+		.help	= "Only write to zones opened by this job, without zone locks",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "zone_append",
+		.lname	= "Zone append",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, zone_append),
+		.def	= "0",
+		.help	= "Issue writes to sequential zones as zone appends",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_INVALID,
+	},
 	{
 		.name	= "zone_reset_threshold",
 		.lname	= "Zone reset threshold",
@@ -3789,6 +3845,67 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_RATE,
 	},
+	{
+		.name	= "rate_co_lat",
+		.lname	= "Rate corrected latency",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, rate_co_lat),
+		.help	= "Also measure latency from when the rate meant to issue each IO",
+		.def	= "0",
+		.parent = "rate",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_RATE,
+	},
+	{
+		.name	= "arrival_process",
+		.lname	= "Arrival process",
+		.type	= FIO_OPT_STR,
+		.off1	= offsetof(struct thread_options, arrival_process),
+		.help	= "Issue IO as it arrives, independent of completions",
+		.def	= "none",
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_RATE,
+		.posval = {
+			  { .ival = "none",
+			    .oval = ARRIVAL_NONE,
+			    .help = "Closed loop, issue as soon as an io_u is free",
+			  },
+			  { .ival = "fixed",
+			    .oval = ARRIVAL_FIXED,
+			    .help = "Arrive at a fixed interval",
+			  },
+			  { .ival = "poisson",
+			    .oval = ARRIVAL_POISSON,
+			    .help = "Exponential inter-arrival times",
+			  },
+			  { .ival = "trace",
+			    .oval = ARRIVAL_TRACE,
+			    .help = "Replay arrival times from arrival_trace",
+			  },
+		},
+	},
+	{
+		.name	= "arrival_rate",
+		.lname	= "Arrival rate",
+		.type	= FIO_OPT_ULL,
+		.off1	= offsetof(struct thread_options, arrival_rate),
+		.help	= "Mean number of arrivals per second",
+		.parent = "arrival_process",
+		.hide	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_RATE,
+	},
+	{
+		.name	= "arrival_trace",
+		.lname	= "Arrival trace",
+		.type	= FIO_OPT_STR_STORE,
+		.off1	= offsetof(struct thread_options, arrival_trace),
+		.help	= "File of arrival times in usec, one per line",
+		.parent = "arrival_process",
+		.hide	= 1,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_RATE,
+	},
 	{
 		.name	= "max_latency",
 		.lname	= "Max Latency (usec)",
@@ -4371,6 +4488,27 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.help	= "Install libz-dev(el) to get compression support",
 	},
 #endif
+	{
+		.name	= "log_binary",
+		.lname	= "Log in binary format",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, log_binary),
+		.help	= "Write bw/iops/lat logs in a binary format",
+		.def	= "0",
+		.category = FIO_OPT_C_LOG,
+		.group	= FIO_OPT_G_INVALID,
+	},
+	{
+		.name	= "log_mem_limit",
+		.lname	= "Log memory limit",
+		.type	= FIO_OPT_STR_VAL,
+		.off1	= offsetof(struct thread_options, log_mem_limit),
+		.help	= "Stream per-I/O logs to disk, keeping at most this much in memory per log",
+		.def	= "0",
+		.interval = 1024 * 1024,
+		.category = FIO_OPT_C_LOG,
+		.group	= FIO_OPT_G_INVALID,
+	},
 	{
 		.name = "log_unix_epoch",
 		.lname = "Log epoch unix",
@@ -4547,6 +4685,17 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_IO,
 		.group	= FIO_OPT_G_IO_BUF,
 	},
+	{
+		.name	= "buffer_pool",
+		.lname	= "Buffer pool",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, buffer_pool),
+		.help	= "Number of write buffers to generate ahead of time when refilling buffers",
+		.def	= "0",
+		.maxval	= 65536,
+		.category = FIO_OPT_C_IO,
+		.group	= FIO_OPT_G_IO_BUF,
+	},
 	{
 		.name	= "clat_percentiles",
 		.lname	= "Completion latency percentiles",
@@ -4605,6 +4754,19 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_STAT,
 		.group	= FIO_OPT_G_INVALID,
 	},
+	{
+		.name	= "lat_hist_bits",
+		.lname	= "Latency histogram precision bits",
+		.type	= FIO_OPT_INT,
+		.off1	= offsetof(struct thread_options, lat_hist_bits),
+		.maxval	= FIO_IO_U_PLAT_BITS,
+		.minval	= 2,
+		.help	= "Bits of precision for the latency percentile histograms",
+		.def	= __fio_stringify(FIO_IO_U_PLAT_BITS),
+		.interval = 1,
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_INVALID,
+	},
 
 #ifdef FIO_HAVE_DISK_UTIL
 	{
@@ -4695,6 +4857,16 @@ struct fio_option fio_options[FIO_MAX_OPTS] = {
 		.category = FIO_OPT_C_GENERAL,
 		.group	= FIO_OPT_G_CLOCK,
 	},
+	{
+		.name	= "gtod_batch",
+		.lname	= "Share gettimeofday() across a batch",
+		.type	= FIO_OPT_BOOL,
+		.off1	= offsetof(struct thread_options, gtod_batch),
+		.help	= "Read the clock once per submit or reap batch",
+		.def	= "0",
+		.category = FIO_OPT_C_STAT,
+		.group	= FIO_OPT_G_CLOCK,
+	},
 	{
 		.name	= "unified_rw_reporting",
 		.lname	= "Unified RW Reporting",
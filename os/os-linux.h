@@ -23,6 +23,12 @@
 #ifndef HWCAP_CRC32
 #define HWCAP_CRC32             (1 << 7)
 #endif /* HWCAP_CRC32 */
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1              (1 << 5)
+#endif /* HWCAP_SHA1 */
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2              (1 << 6)
+#endif /* HWCAP_SHA2 */
 #endif /* ARCH_HAVE_CRC_CRYPTO */
 
 #include "./os-linux-syscall.h"
@@ -407,6 +413,11 @@ static inline bool os_cpu_has(cpu_features feature)
 		hwcap = getauxval(AT_HWCAP);
 		have_feature = (hwcap & HWCAP_CRC32) != 0;
 		break;
+	case CPU_ARM64_SHA:
+		hwcap = getauxval(AT_HWCAP);
+		have_feature = (hwcap & (HWCAP_SHA1 | HWCAP_SHA2)) ==
+				(HWCAP_SHA1 | HWCAP_SHA2);
+		break;
 #endif
 	default:
 		have_feature = false;
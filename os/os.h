@@ -30,6 +30,7 @@ enum {
 
 typedef enum {
         CPU_ARM64_CRC32C,
+        CPU_ARM64_SHA,
 } cpu_features;
 
 /* IWYU pragma: begin_exports */
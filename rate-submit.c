@@ -162,7 +162,6 @@ static int io_workqueue_init_worker_fn(struct submit_worker *sw)
 
 	INIT_FLIST_HEAD(&td->io_log_list);
 	INIT_FLIST_HEAD(&td->io_hist_list);
-	INIT_FLIST_HEAD(&td->verify_list);
 	INIT_FLIST_HEAD(&td->trim_list);
 	td->io_hist_tree = RB_ROOT;
 
@@ -1457,6 +1457,48 @@ static void convert_gs(struct group_run_stats *dst, struct group_run_stats *src)
 	dst->sig_figs	= cpu_to_le32(src->sig_figs);
 }
 
+/*
+ * Run-length encode the zero words of a CMD_TS payload, see
+ * struct cmd_ts_rle_pdu. 'buf' must be padded to a multiple of 8 bytes.
+ */
+static void *fio_server_rle_ts(const void *buf, size_t len, size_t *out_len)
+{
+	const uint64_t *src = buf;
+	size_t i, start, nr = (len + 7) / 8;
+	struct cmd_ts_rle_pdu *pdu;
+	struct cmd_ts_rle_run run;
+	uint8_t *out;
+	uint32_t zeroes, words;
+
+	/* worst case is a run header for every literal word */
+	pdu = malloc(sizeof(*pdu) + nr * (sizeof(run) + sizeof(uint64_t)));
+	pdu->size = cpu_to_le64(len);
+	out = pdu->data;
+
+	i = 0;
+	while (i < nr) {
+		zeroes = 0;
+		while (i < nr && !src[i]) {
+			zeroes++;
+			i++;
+		}
+		start = i;
+		while (i < nr && src[i])
+			i++;
+
+		words = i - start;
+		run.zeroes = cpu_to_le32(zeroes);
+		run.words = cpu_to_le32(words);
+		memcpy(out, &run, sizeof(run));
+		out += sizeof(run);
+		memcpy(out, &src[start], words * sizeof(uint64_t));
+		out += words * sizeof(uint64_t);
+	}
+
+	*out_len = out - (uint8_t *) pdu;
+	return pdu;
+}
+
 /*
  * Send a CMD_TS, which packs struct thread_stat and group_run_stats
  * into a single payload.
@@ -1465,7 +1507,8 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 {
 	struct cmd_ts_pdu p;
 	int i, j, k;
-	void *ss_buf;
+	size_t len, pdu_len;
+	void *ts_buf, *pdu;
 	uint64_t *ss_iops, *ss_bw;
 
 	dprint(FD_NET, "server sending end stats\n");
@@ -1488,10 +1531,14 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 		convert_io_stat(&p.ts.clat_stat[i], &ts->clat_stat[i]);
 		convert_io_stat(&p.ts.slat_stat[i], &ts->slat_stat[i]);
 		convert_io_stat(&p.ts.lat_stat[i], &ts->lat_stat[i]);
+		convert_io_stat(&p.ts.co_lat_stat[i], &ts->co_lat_stat[i]);
 		convert_io_stat(&p.ts.bw_stat[i], &ts->bw_stat[i]);
 		convert_io_stat(&p.ts.iops_stat[i], &ts->iops_stat[i]);
 	}
 	convert_io_stat(&p.ts.sync_stat, &ts->sync_stat);
+	convert_io_stat(&p.ts.clock_batch_stat, &ts->clock_batch_stat);
+	convert_io_stat(&p.ts.arrival_wait_stat, &ts->arrival_wait_stat);
+	convert_io_stat(&p.ts.arrival_depth_stat, &ts->arrival_depth_stat);
 
 	p.ts.usr_time		= cpu_to_le64(ts->usr_time);
 	p.ts.sys_time		= cpu_to_le64(ts->sys_time);
@@ -1501,6 +1548,7 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	p.ts.clat_percentiles	= cpu_to_le32(ts->clat_percentiles);
 	p.ts.lat_percentiles	= cpu_to_le32(ts->lat_percentiles);
 	p.ts.slat_percentiles	= cpu_to_le32(ts->slat_percentiles);
+	p.ts.plat_bits		= cpu_to_le32(ts->plat_bits);
 	p.ts.percentile_precision = cpu_to_le64(ts->percentile_precision);
 
 	for (i = 0; i < FIO_IO_U_LIST_MAX_LEN; i++) {
@@ -1577,6 +1625,13 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	p.ts.cachehit		= cpu_to_le64(ts->cachehit);
 	p.ts.cachemiss		= cpu_to_le64(ts->cachemiss);
 
+	for (i = 0; i < FIO_LAT_CNT; i++)
+		for (j = 0; j < DDIR_RWDIR_CNT; j++)
+			p.ts.io_u_plat_groups[i][j] = cpu_to_le32(ts->io_u_plat_groups[i][j]);
+	for (i = 0; i < DDIR_RWDIR_CNT; i++)
+		p.ts.io_u_plat_prio_groups[i] = cpu_to_le32(ts->io_u_plat_prio_groups[i]);
+	p.ts.io_u_sync_plat_groups = cpu_to_le32(ts->io_u_sync_plat_groups);
+
 	for (i = 0; i < DDIR_RWDIR_CNT; i++) {
 		for (j = 0; j < FIO_IO_U_PLAT_NR; j++) {
 			p.ts.io_u_plat_high_prio[i][j] = cpu_to_le64(ts->io_u_plat_high_prio[i][j]);
@@ -1589,26 +1644,30 @@ void fio_server_send_ts(struct thread_stat *ts, struct group_run_stats *rs)
 	convert_gs(&p.rs, rs);
 
 	dprint(FD_NET, "ts->ss_state = %d\n", ts->ss_state);
+	len = sizeof(p);
 	if (ts->ss_state & FIO_SS_DATA) {
 		dprint(FD_NET, "server sending steadystate ring buffers\n");
+		len += 2 * ts->ss_dur * sizeof(uint64_t);
+	}
 
-		ss_buf = malloc(sizeof(p) + 2*ts->ss_dur*sizeof(uint64_t));
-
-		memcpy(ss_buf, &p, sizeof(p));
+	ts_buf = calloc(1, (len + 7) & ~7UL);
+	memcpy(ts_buf, &p, sizeof(p));
 
-		ss_iops = (uint64_t *) ((struct cmd_ts_pdu *)ss_buf + 1);
+	if (ts->ss_state & FIO_SS_DATA) {
+		ss_iops = (uint64_t *) ((struct cmd_ts_pdu *)ts_buf + 1);
 		ss_bw = ss_iops + (int) ts->ss_dur;
 		for (i = 0; i < ts->ss_dur; i++) {
 			ss_iops[i] = cpu_to_le64(ts->ss_iops_data[i]);
 			ss_bw[i] = cpu_to_le64(ts->ss_bw_data[i]);
 		}
+	}
 
-		fio_net_queue_cmd(FIO_NET_CMD_TS, ss_buf, sizeof(p) + 2*ts->ss_dur*sizeof(uint64_t), NULL, SK_F_COPY);
+	pdu = fio_server_rle_ts(ts_buf, len, &pdu_len);
+	dprint(FD_NET, "server: ts pdu %zu bytes, %zu encoded\n", len, pdu_len);
+	fio_net_queue_cmd(FIO_NET_CMD_TS, pdu, pdu_len, NULL, SK_F_COPY);
 
-		free(ss_buf);
-	}
-	else
-		fio_net_queue_cmd(FIO_NET_CMD_TS, &p, sizeof(p), NULL, SK_F_COPY);
+	free(pdu);
+	free(ts_buf);
 }
 
 void fio_server_send_gs(struct group_run_stats *rs)
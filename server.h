@@ -48,7 +48,7 @@ struct fio_net_cmd_reply {
 };
 
 enum {
-	FIO_SERVER_VER			= 94,
+	FIO_SERVER_VER			= 107,
 
 	FIO_SERVER_MAX_FRAGMENT_PDU	= 1024,
 	FIO_SERVER_MAX_CMD_MB		= 2048,
@@ -120,6 +120,22 @@ struct cmd_ts_pdu {
 	struct group_run_stats rs;
 };
 
+/*
+ * A cmd_ts_pdu is mostly empty latency histogram buckets, so it is sent
+ * run-length encoded as 64-bit words. 'size' is the decoded length. Each
+ * run header is followed by 'words' literal words, after skipping 'zeroes'
+ * zero words.
+ */
+struct cmd_ts_rle_pdu {
+	uint64_t size;
+	uint8_t data[];
+};
+
+struct cmd_ts_rle_run {
+	uint32_t zeroes;
+	uint32_t words;
+};
+
 struct cmd_du_pdu {
 	struct disk_util_stat dus;
 	struct disk_util_agg agg;
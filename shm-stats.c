@@ -0,0 +1,190 @@
+/*
+ * Live stats in a shared memory file. With --shm-stats=file the helper
+ * thread maps the file and copies the per-job counters, rates and latency
+ * histograms into it every SHM_STATS_MSEC. Other processes can map it
+ * and read it as often as they like without touching the I/O threads, see
+ * tools/fio_shmstat.py.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "fio.h"
+#include "shm-stats.h"
+
+char *shm_stats_file;
+
+struct shm_stats_prev {
+	uint64_t io_bytes[DDIR_RWDIR_CNT];
+	uint64_t io_blocks[DDIR_RWDIR_CNT];
+	uint64_t hist_samples[DDIR_RWDIR_CNT];
+};
+
+static struct shm_stats_data {
+	struct shm_stats_header *hdr;
+	size_t size;
+	unsigned int nr_jobs;
+	struct shm_stats_prev *prev;
+	struct timespec last_rate;
+} *shm_stats;
+
+static struct shm_stats_job *shm_stats_job(unsigned int i)
+{
+	return (void *) shm_stats->hdr + sizeof(struct shm_stats_header) +
+		i * sizeof(struct shm_stats_job);
+}
+
+static void shm_stats_update_job(struct thread_data *td,
+				 struct shm_stats_job *sj,
+				 struct shm_stats_prev *prev,
+				 uint64_t now_ms, uint64_t rate_msec)
+{
+	struct thread_stat *ts = &td->ts;
+
+	write_seqlock_begin(&sj->seqlock);
+
+	sj->groupid = td->groupid;
+	sj->runstate = td->runstate;
+	sj->inflight = td->io_u_in_flight;
+	sj->time_ms = now_ms;
+
+	for_each_rw_ddir(ddir) {
+		struct io_stat *is = &ts->clat_stat[ddir];
+
+		sj->io_bytes[ddir] = td->io_bytes[ddir];
+		sj->io_blocks[ddir] = td->io_blocks[ddir];
+
+		if (rate_msec) {
+			sj->bw[ddir] = (sj->io_bytes[ddir] - prev->io_bytes[ddir]) *
+					1000 / rate_msec;
+			sj->iops[ddir] = (sj->io_blocks[ddir] -
+					  prev->io_blocks[ddir]) * 1000 / rate_msec;
+			prev->io_bytes[ddir] = sj->io_bytes[ddir];
+			prev->io_blocks[ddir] = sj->io_blocks[ddir];
+		}
+
+		sj->clat_min[ddir] = is->samples ? is->min_val : 0;
+		sj->clat_max[ddir] = is->max_val;
+		sj->clat_mean[ddir] = is->mean.u.f;
+
+		/* only refold histograms that got new samples */
+		if (ts->clat_percentiles &&
+		    is->samples != prev->hist_samples[ddir]) {
+			plat_fold_pow2(ts->io_u_plat[FIO_CLAT][ddir],
+				       ts->io_u_plat_groups[FIO_CLAT][ddir],
+				       ts->plat_bits, sj->clat_hist[ddir]);
+			prev->hist_samples[ddir] = is->samples;
+		}
+	}
+
+	write_seqlock_end(&sj->seqlock);
+}
+
+/*
+ * Helper thread timer: publish a fresh copy of every job's stats.
+ */
+int shm_stats_update(void)
+{
+	struct thread_data *td;
+	struct timespec now;
+	uint64_t rate_msec, now_ms;
+	int i;
+
+	if (!shm_stats)
+		return 0;
+
+	fio_gettime(&now, NULL);
+	now_ms = mtime_since_genesis();
+	rate_msec = mtime_since(&shm_stats->last_rate, &now);
+	if (rate_msec < SHM_STATS_RATE_MSEC)
+		rate_msec = 0;
+	else
+		shm_stats->last_rate = now;
+
+	for_each_td(td, i) {
+		if (i >= shm_stats->nr_jobs)
+			break;
+		shm_stats_update_job(td, shm_stats_job(i), &shm_stats->prev[i],
+				     now_ms, rate_msec);
+	}
+
+	atomic_store_release(&shm_stats->hdr->time_ms, now_ms);
+	return 0;
+}
+
+int shm_stats_setup(void)
+{
+	struct shm_stats_header *hdr;
+	struct thread_data *td;
+	size_t size;
+	int fd, i;
+
+	if (!shm_stats_file)
+		return 0;
+
+	size = sizeof(*hdr) + thread_number * sizeof(struct shm_stats_job);
+
+	fd = open(shm_stats_file, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		log_err("fio: open shm stats %s: %s\n", shm_stats_file,
+			strerror(errno));
+		return 1;
+	}
+	if (ftruncate(fd, size) < 0) {
+		log_err("fio: truncate shm stats %s: %s\n", shm_stats_file,
+			strerror(errno));
+		close(fd);
+		return 1;
+	}
+
+	hdr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (hdr == MAP_FAILED) {
+		log_err("fio: mmap shm stats %s: %s\n", shm_stats_file,
+			strerror(errno));
+		return 1;
+	}
+
+	shm_stats = calloc(1, sizeof(*shm_stats));
+	shm_stats->hdr = hdr;
+	shm_stats->size = size;
+	shm_stats->nr_jobs = thread_number;
+	shm_stats->prev = calloc(thread_number, sizeof(struct shm_stats_prev));
+	fio_gettime(&shm_stats->last_rate, NULL);
+
+	for_each_td(td, i) {
+		struct shm_stats_job *sj = shm_stats_job(i);
+
+		seqlock_init(&sj->seqlock);
+		sj->jobid = i;
+		snprintf(sj->name, sizeof(sj->name), "%s",
+			 td->o.name ? td->o.name : "");
+	}
+
+	hdr->version = FIO_SHM_STATS_VERSION;
+	hdr->header_size = sizeof(*hdr);
+	hdr->job_size = sizeof(struct shm_stats_job);
+	hdr->nr_jobs = thread_number;
+	hdr->hist_nr = FIO_PLAT_POW2_NR;
+	hdr->hist_min_bit = FIO_PLAT_POW2_MIN;
+	hdr->interval_ms = SHM_STATS_MSEC;
+	hdr->pid = getpid();
+	write_barrier();
+	/* the magic goes last, readers can tell the file is set up */
+	memcpy(hdr->magic, FIO_SHM_STATS_MAGIC, sizeof(hdr->magic));
+	return 0;
+}
+
+void shm_stats_exit(void)
+{
+	if (!shm_stats)
+		return;
+
+	shm_stats_update();
+	atomic_store_release(&shm_stats->hdr->done, 1);
+	munmap(shm_stats->hdr, shm_stats->size);
+	free(shm_stats->prev);
+	free(shm_stats);
+	shm_stats = NULL;
+}
@@ -0,0 +1,65 @@
+#ifndef FIO_SHM_STATS_H
+#define FIO_SHM_STATS_H
+
+#include <inttypes.h>
+
+#include "io_ddir.h"
+#include "stat.h"
+#include "lib/seqlock.h"
+
+/*
+ * Layout of the --shm-stats file: a struct shm_stats_header followed by
+ * nr_jobs struct shm_stats_job entries of job_size bytes each, in host
+ * byte order. The helper thread rewrites a job entry under its seqlock, a
+ * reader copies the entry and retries if the sequence was odd or changed.
+ * Fields are only ever appended, readers must use the sizes in the header.
+ */
+#define FIO_SHM_STATS_MAGIC	"fioshmst"
+#define FIO_SHM_STATS_VERSION	1U
+
+#define FIO_SHM_STATS_NAME_SZ	64
+
+struct shm_stats_header {
+	uint8_t magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t job_size;
+	uint32_t nr_jobs;
+	uint32_t hist_nr;	/* FIO_PLAT_POW2_NR */
+	uint32_t hist_min_bit;	/* FIO_PLAT_POW2_MIN */
+	uint32_t interval_ms;
+	uint32_t pid;
+	uint64_t time_ms;	/* of the last update, since fio started */
+	uint32_t done;		/* set once fio stopped updating */
+	uint32_t pad;
+};
+
+struct shm_stats_job {
+	struct seqlock seqlock;
+	uint32_t jobid;
+	uint32_t groupid;
+	uint32_t runstate;
+	uint32_t inflight;
+	uint32_t pad;
+	char name[FIO_SHM_STATS_NAME_SZ];
+	uint64_t time_ms;
+	uint64_t io_bytes[DDIR_RWDIR_CNT];
+	uint64_t io_blocks[DDIR_RWDIR_CNT];
+	uint64_t bw[DDIR_RWDIR_CNT];		/* bytes/sec */
+	uint64_t iops[DDIR_RWDIR_CNT];
+	uint64_t clat_min[DDIR_RWDIR_CNT];	/* nsec */
+	uint64_t clat_max[DDIR_RWDIR_CNT];
+	uint64_t clat_mean[DDIR_RWDIR_CNT];
+	uint64_t clat_hist[DDIR_RWDIR_CNT][FIO_PLAT_POW2_NR];
+};
+
+extern int shm_stats_setup(void);
+extern int shm_stats_update(void);
+extern void shm_stats_exit(void);
+
+extern char *shm_stats_file;
+
+#define SHM_STATS_MSEC		100
+#define SHM_STATS_RATE_MSEC	1000
+
+#endif
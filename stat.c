@@ -11,6 +11,7 @@
 #include "lib/getrusage.h"
 #include "idletime.h"
 #include "lib/pow2.h"
+#include "lib/ffz.h"
 #include "lib/output_buffer.h"
 #include "helper_thread.h"
 #include "smalloc.h"
@@ -48,6 +49,18 @@ void update_rusage_stat(struct thread_data *td)
 	memcpy(&td->ru_start, &td->ru_end, sizeof(td->ru_end));
 }
 
+/*
+ * Number of buckets a histogram indexed with 'bits' of precision can use.
+ * Lower precision needs fewer buckets per power-of-two group, so a 64-bit
+ * value may not reach the end of the FIO_IO_U_PLAT_NR array.
+ */
+static unsigned int plat_nr(unsigned int bits)
+{
+	unsigned int nr = (65 - bits) << bits;
+
+	return nr < FIO_IO_U_PLAT_NR ? nr : FIO_IO_U_PLAT_NR;
+}
+
 /*
  * Given a latency, return the index of the corresponding bucket in
  * the structure tracking percentiles.
@@ -57,7 +70,7 @@ void update_rusage_stat(struct thread_data *td)
  * group by looking at the index bits.
  *
  */
-static unsigned int plat_val_to_idx(unsigned long long val)
+static unsigned int plat_val_to_idx(unsigned long long val, unsigned int bits)
 {
 	unsigned int msb, error_bits, base, offset, idx;
 
@@ -68,27 +81,27 @@ static unsigned int plat_val_to_idx(unsigned long long val)
 		msb = (sizeof(val)*8) - __builtin_clzll(val) - 1;
 
 	/*
-	 * MSB <= (FIO_IO_U_PLAT_BITS-1), cannot be rounded off. Use
-	 * all bits of the sample as index
+	 * MSB <= (bits-1), cannot be rounded off. Use all bits of the
+	 * sample as index
 	 */
-	if (msb <= FIO_IO_U_PLAT_BITS)
+	if (msb <= bits)
 		return val;
 
 	/* Compute the number of error bits to discard*/
-	error_bits = msb - FIO_IO_U_PLAT_BITS;
+	error_bits = msb - bits;
 
 	/* Compute the number of buckets before the group */
-	base = (error_bits + 1) << FIO_IO_U_PLAT_BITS;
+	base = (error_bits + 1) << bits;
 
 	/*
 	 * Discard the error bits and apply the mask to find the
 	 * index for the buckets in the group
 	 */
-	offset = (FIO_IO_U_PLAT_VAL - 1) & (val >> error_bits);
+	offset = ((1U << bits) - 1) & (val >> error_bits);
 
 	/* Make sure the index does not exceed (array size - 1) */
-	idx = (base + offset) < (FIO_IO_U_PLAT_NR - 1) ?
-		(base + offset) : (FIO_IO_U_PLAT_NR - 1);
+	idx = (base + offset) < (plat_nr(bits) - 1) ?
+		(base + offset) : (plat_nr(bits) - 1);
 
 	return idx;
 }
@@ -97,27 +110,75 @@ static unsigned int plat_val_to_idx(unsigned long long val)
  * Convert the given index of the bucket array to the value
  * represented by the bucket
  */
-static unsigned long long plat_idx_to_val(unsigned int idx)
+static unsigned long long plat_idx_to_val(unsigned int idx, unsigned int bits)
 {
 	unsigned int error_bits;
 	unsigned long long k, base;
 
-	assert(idx < FIO_IO_U_PLAT_NR);
+	assert(idx < plat_nr(bits));
 
-	/* MSB <= (FIO_IO_U_PLAT_BITS-1), cannot be rounded off. Use
-	 * all bits of the sample as index */
-	if (idx < (FIO_IO_U_PLAT_VAL << 1))
+	/* MSB <= (bits-1), cannot be rounded off. Use all bits of the
+	 * sample as index */
+	if (idx < (2U << bits))
 		return idx;
 
 	/* Find the group and compute the minimum value of that group */
-	error_bits = (idx >> FIO_IO_U_PLAT_BITS) - 1;
-	base = ((unsigned long long) 1) << (error_bits + FIO_IO_U_PLAT_BITS);
+	error_bits = (idx >> bits) - 1;
+	base = ((unsigned long long) 1) << (error_bits + bits);
 
 	/* Find its bucket number of the group */
-	k = idx % FIO_IO_U_PLAT_VAL;
+	k = idx & ((1U << bits) - 1);
 
 	/* Return the mean of the range of the bucket */
-	return base + ((k + 0.5) * (1 << error_bits));
+	return base + ((k + 0.5) * (1ULL << error_bits));
+}
+
+/*
+ * Bit in the io_u_plat_groups maps covering the given bucket index
+ */
+static inline uint32_t plat_idx_to_group(unsigned int idx)
+{
+	return 1U << (idx >> FIO_IO_U_PLAT_BITS);
+}
+
+/*
+ * Fold a latency histogram into FIO_PLAT_POW2_NR power of two buckets,
+ * skipping the bucket groups that have no samples. A bucket never
+ * straddles a power of two, so its value decides where it goes. Returns
+ * the number of samples.
+ */
+uint64_t plat_fold_pow2(const uint64_t *io_u_plat, uint32_t groups,
+			unsigned int plat_bits, uint64_t *hist)
+{
+	unsigned int g, i, nr, msb;
+	unsigned long long val;
+	uint64_t total = 0;
+
+	memset(hist, 0, FIO_PLAT_POW2_NR * sizeof(uint64_t));
+
+	nr = plat_nr(plat_bits);
+	for (g = 0; g < FIO_IO_U_PLAT_GROUP_NR; g++) {
+		if (!(groups & (1U << g)))
+			continue;
+
+		for (i = g * FIO_IO_U_PLAT_VAL;
+		     i < (g + 1) * FIO_IO_U_PLAT_VAL && i < nr; i++) {
+			if (!io_u_plat[i])
+				continue;
+
+			val = plat_idx_to_val(i, plat_bits);
+			msb = val ? 64 - __builtin_clzll(val) : 0;
+			if (msb < FIO_PLAT_POW2_MIN)
+				msb = FIO_PLAT_POW2_MIN;
+			if (msb > FIO_PLAT_POW2_MAX)
+				msb = FIO_PLAT_POW2_MAX + 1;
+
+			hist[msb - FIO_PLAT_POW2_MIN] += io_u_plat[i];
+			total += io_u_plat[i];
+		}
+	}
+
+	return total;
 }
 
 static int double_cmp(const void *a, const void *b)
@@ -134,8 +195,8 @@ static int double_cmp(const void *a, const void *b)
 	return cmp;
 }
 
-unsigned int calc_clat_percentiles(uint64_t *io_u_plat, unsigned long long nr,
-				   fio_fp64_t *plist, unsigned long long **output,
+unsigned int calc_clat_percentiles(uint64_t *io_u_plat, unsigned int plat_bits,
+				   unsigned long long nr, fio_fp64_t *plist, unsigned long long **output,
 				   unsigned long long *maxv, unsigned long long *minv)
 {
 	unsigned long long sum = 0;
@@ -169,12 +230,12 @@ unsigned int calc_clat_percentiles(uint64_t *io_u_plat, unsigned long long nr,
 	 * Calculate bucket values, note down max and min values
 	 */
 	is_last = false;
-	for (i = 0; i < FIO_IO_U_PLAT_NR && !is_last; i++) {
+	for (i = 0; i < plat_nr(plat_bits) && !is_last; i++) {
 		sum += io_u_plat[i];
 		while (sum >= ((long double) plist[j].u.f / 100.0 * nr)) {
 			assert(plist[j].u.f <= 100.0);
 
-			ovals[j] = plat_idx_to_val(i);
+			ovals[j] = plat_idx_to_val(i, plat_bits);
 			if (ovals[j] < *minv)
 				*minv = ovals[j];
 			if (ovals[j] > *maxv)
@@ -198,8 +259,8 @@ unsigned int calc_clat_percentiles(uint64_t *io_u_plat, unsigned long long nr,
 /*
  * Find and display the p-th percentile of clat
  */
-static void show_clat_percentiles(uint64_t *io_u_plat, unsigned long long nr,
-				  fio_fp64_t *plist, unsigned int precision,
+static void show_clat_percentiles(uint64_t *io_u_plat, unsigned int plat_bits,
+				  unsigned long long nr, fio_fp64_t *plist, unsigned int precision,
 				  const char *pre, struct buf_output *out)
 {
 	unsigned int divisor, len, i, j = 0;
@@ -209,7 +270,8 @@ static void show_clat_percentiles(uint64_t *io_u_plat, unsigned long long nr,
 	bool is_last;
 	char fmt[32];
 
-	len = calc_clat_percentiles(io_u_plat, nr, plist, &ovals, &maxv, &minv);
+	len = calc_clat_percentiles(io_u_plat, plat_bits, nr, plist, &ovals,
+				    &maxv, &minv);
 	if (!len || !ovals)
 		return;
 
@@ -457,6 +519,41 @@ static void display_lat(const char *name, unsigned long long min,
 	free(maxp);
 }
 
+/*
+ * gtod_batch: how stale a shared timestamp got before it was replaced,
+ * which bounds the error of the latencies measured with it.
+ */
+static void show_clock_batch(struct thread_stat *ts, struct buf_output *out)
+{
+	unsigned long long min, max;
+	double mean, dev;
+
+	if (!calc_lat(&ts->clock_batch_stat, &min, &max, &mean, &dev))
+		return;
+
+	log_buf(out, "  clock batch  : %llu shared timestamps, error bound\n",
+		(unsigned long long) ts->clock_batch_stat.samples);
+	display_lat("err", min, max, mean, dev, out);
+}
+
+/*
+ * arrival_process: how long requests waited for an io_u, and how many
+ * were queued when one was handed out.
+ */
+static void show_arrival_queue(struct thread_stat *ts, struct buf_output *out)
+{
+	unsigned long long min, max;
+	double mean, dev;
+
+	if (!calc_lat(&ts->arrival_depth_stat, &min, &max, &mean, &dev))
+		return;
+
+	log_buf(out, "  arrival queue: depth min=%llu, max=%llu, avg=%5.02f,"
+		" stdev=%5.02f\n", min, max, mean, dev);
+	if (calc_lat(&ts->arrival_wait_stat, &min, &max, &mean, &dev))
+		display_lat("wait", min, max, mean, dev, out);
+}
+
 static double convert_agg_kbytes_percent(struct group_run_stats *rs, int ddir, int mean)
 {
 	double p_of_agg = 100.0;
@@ -489,6 +586,7 @@ static void show_mixed_ddir_status(struct group_run_stats *rs, struct thread_sta
 		ts_lcl->clat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->slat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->lat_stat[i].min_val = ULONG_MAX;
+		ts_lcl->co_lat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->bw_stat[i].min_val = ULONG_MAX;
 		ts_lcl->iops_stat[i].min_val = ULONG_MAX;
 		ts_lcl->clat_high_prio_stat[i].min_val = ULONG_MAX;
@@ -531,6 +629,8 @@ static void show_mixed_ddir_status(struct group_run_stats *rs, struct thread_sta
 		display_lat("clat", min, max, mean, dev, out);
 	if (calc_lat(&ts_lcl->lat_stat[ddir], &min, &max, &mean, &dev))
 		display_lat(" lat", min, max, mean, dev, out);
+	if (calc_lat(&ts_lcl->co_lat_stat[ddir], &min, &max, &mean, &dev))
+		display_lat("co lat", min, max, mean, dev, out);
 	if (calc_lat(&ts_lcl->clat_high_prio_stat[ddir], &min, &max, &mean, &dev)) {
 		display_lat(ts_lcl->lat_percentiles ? "high prio_lat" : "high prio_clat",
 				min, max, mean, dev, out);
@@ -541,19 +641,24 @@ static void show_mixed_ddir_status(struct group_run_stats *rs, struct thread_sta
 
 	if (ts->slat_percentiles && ts_lcl->slat_stat[ddir].samples > 0)
 		show_clat_percentiles(ts_lcl->io_u_plat[FIO_SLAT][ddir],
-				ts_lcl->slat_stat[ddir].samples,
+				ts_lcl->plat_bits, ts_lcl->slat_stat[ddir].samples,
 				ts->percentile_list,
 				ts->percentile_precision, "slat", out);
 	if (ts->clat_percentiles && ts_lcl->clat_stat[ddir].samples > 0)
 		show_clat_percentiles(ts_lcl->io_u_plat[FIO_CLAT][ddir],
-				ts_lcl->clat_stat[ddir].samples,
+				ts_lcl->plat_bits, ts_lcl->clat_stat[ddir].samples,
 				ts->percentile_list,
 				ts->percentile_precision, "clat", out);
 	if (ts->lat_percentiles && ts_lcl->lat_stat[ddir].samples > 0)
 		show_clat_percentiles(ts_lcl->io_u_plat[FIO_LAT][ddir],
-				ts_lcl->lat_stat[ddir].samples,
+				ts_lcl->plat_bits, ts_lcl->lat_stat[ddir].samples,
 				ts->percentile_list,
 				ts->percentile_precision, "lat", out);
+	if (ts_lcl->co_lat_stat[ddir].samples > 0)
+		show_clat_percentiles(ts_lcl->io_u_plat[FIO_CO_LAT][ddir],
+				ts_lcl->plat_bits, ts_lcl->co_lat_stat[ddir].samples,
+				ts->percentile_list,
+				ts->percentile_precision, "co lat", out);
 
 	if (ts->clat_percentiles || ts->lat_percentiles) {
 		const char *name = ts->lat_percentiles ? "lat" : "clat";
@@ -573,7 +678,7 @@ static void show_mixed_ddir_status(struct group_run_stats *rs, struct thread_sta
 					100. * (double) ts_lcl->clat_high_prio_stat[ddir].samples / (double) samples,
 					name);
 			show_clat_percentiles(ts_lcl->io_u_plat_high_prio[ddir],
-					ts_lcl->clat_high_prio_stat[ddir].samples,
+					ts_lcl->plat_bits, ts_lcl->clat_high_prio_stat[ddir].samples,
 					ts->percentile_list,
 					ts->percentile_precision, prio_name, out);
 
@@ -581,7 +686,7 @@ static void show_mixed_ddir_status(struct group_run_stats *rs, struct thread_sta
 					100. * (double) ts_lcl->clat_low_prio_stat[ddir].samples / (double) samples,
 					name);
 			show_clat_percentiles(ts_lcl->io_u_plat_low_prio[ddir],
-					ts_lcl->clat_low_prio_stat[ddir].samples,
+					ts_lcl->plat_bits, ts_lcl->clat_low_prio_stat[ddir].samples,
 					ts->percentile_list,
 					ts->percentile_precision, prio_name, out);
 		}
@@ -645,7 +750,7 @@ static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 			log_buf(out, "  %s:\n", "fsync/fdatasync/sync_file_range");
 			display_lat(io_ddir_name(ddir), min, max, mean, dev, out);
 			show_clat_percentiles(ts->io_u_sync_plat,
-						ts->sync_stat.samples,
+						ts->plat_bits, ts->sync_stat.samples,
 						ts->percentile_list,
 						ts->percentile_precision,
 						io_ddir_name(ddir), out);
@@ -699,6 +804,8 @@ static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 		display_lat("clat", min, max, mean, dev, out);
 	if (calc_lat(&ts->lat_stat[ddir], &min, &max, &mean, &dev))
 		display_lat(" lat", min, max, mean, dev, out);
+	if (calc_lat(&ts->co_lat_stat[ddir], &min, &max, &mean, &dev))
+		display_lat("co lat", min, max, mean, dev, out);
 	if (calc_lat(&ts->clat_high_prio_stat[ddir], &min, &max, &mean, &dev)) {
 		display_lat(ts->lat_percentiles ? "high prio_lat" : "high prio_clat",
 				min, max, mean, dev, out);
@@ -709,19 +816,24 @@ static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 
 	if (ts->slat_percentiles && ts->slat_stat[ddir].samples > 0)
 		show_clat_percentiles(ts->io_u_plat[FIO_SLAT][ddir],
-					ts->slat_stat[ddir].samples,
+					ts->plat_bits, ts->slat_stat[ddir].samples,
 					ts->percentile_list,
 					ts->percentile_precision, "slat", out);
 	if (ts->clat_percentiles && ts->clat_stat[ddir].samples > 0)
 		show_clat_percentiles(ts->io_u_plat[FIO_CLAT][ddir],
-					ts->clat_stat[ddir].samples,
+					ts->plat_bits, ts->clat_stat[ddir].samples,
 					ts->percentile_list,
 					ts->percentile_precision, "clat", out);
 	if (ts->lat_percentiles && ts->lat_stat[ddir].samples > 0)
 		show_clat_percentiles(ts->io_u_plat[FIO_LAT][ddir],
-					ts->lat_stat[ddir].samples,
+					ts->plat_bits, ts->lat_stat[ddir].samples,
 					ts->percentile_list,
 					ts->percentile_precision, "lat", out);
+	if (ts->co_lat_stat[ddir].samples > 0)
+		show_clat_percentiles(ts->io_u_plat[FIO_CO_LAT][ddir],
+					ts->plat_bits, ts->co_lat_stat[ddir].samples,
+					ts->percentile_list,
+					ts->percentile_precision, "co lat", out);
 
 	if (ts->clat_percentiles || ts->lat_percentiles) {
 		const char *name = ts->lat_percentiles ? "lat" : "clat";
@@ -741,7 +853,7 @@ static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 					100. * (double) ts->clat_high_prio_stat[ddir].samples / (double) samples,
 					name);
 			show_clat_percentiles(ts->io_u_plat_high_prio[ddir],
-						ts->clat_high_prio_stat[ddir].samples,
+						ts->plat_bits, ts->clat_high_prio_stat[ddir].samples,
 						ts->percentile_list,
 						ts->percentile_precision, prio_name, out);
 
@@ -749,7 +861,7 @@ static void show_ddir_status(struct group_run_stats *rs, struct thread_stat *ts,
 					100. * (double) ts->clat_low_prio_stat[ddir].samples / (double) samples,
 					name);
 			show_clat_percentiles(ts->io_u_plat_low_prio[ddir],
-						ts->clat_low_prio_stat[ddir].samples,
+						ts->plat_bits, ts->clat_low_prio_stat[ddir].samples,
 						ts->percentile_list,
 						ts->percentile_precision, prio_name, out);
 		}
@@ -1296,6 +1408,9 @@ static void show_thread_status_normal(struct thread_stat *ts,
 	if (ts->sync_stat.samples)
 		show_ddir_status(rs, ts, DDIR_SYNC, out);
 
+	show_clock_batch(ts, out);
+	show_arrival_queue(ts, out);
+
 	runtime = ts->total_run_time;
 	if (runtime) {
 		double runt = (double) runtime;
@@ -1403,11 +1518,13 @@ static void show_ddir_status_terse(struct thread_stat *ts,
 
 	if (ts->lat_percentiles)
 		len = calc_clat_percentiles(ts->io_u_plat[FIO_LAT][ddir],
+					ts->plat_bits,
 					ts->lat_stat[ddir].samples,
 					ts->percentile_list, &ovals, &maxv,
 					&minv);
 	else if (ts->clat_percentiles)
 		len = calc_clat_percentiles(ts->io_u_plat[FIO_CLAT][ddir],
+					ts->plat_bits,
 					ts->clat_stat[ddir].samples,
 					ts->percentile_list, &ovals, &maxv,
 					&minv);
@@ -1472,6 +1589,7 @@ static void show_mixed_ddir_status_terse(struct thread_stat *ts,
 		ts_lcl->clat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->slat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->lat_stat[i].min_val = ULONG_MAX;
+		ts_lcl->co_lat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->bw_stat[i].min_val = ULONG_MAX;
 		ts_lcl->iops_stat[i].min_val = ULONG_MAX;
 		ts_lcl->clat_high_prio_stat[i].min_val = ULONG_MAX;
@@ -1512,7 +1630,8 @@ static struct json_object *add_ddir_lat_json(struct thread_stat *ts, uint32_t pe
 	json_object_add_value_int(lat_object, "N", lat_stat->samples);
 
 	if (percentiles && lat_stat->samples) {
-		len = calc_clat_percentiles(io_u_plat, lat_stat->samples,
+		len = calc_clat_percentiles(io_u_plat, ts->plat_bits,
+				lat_stat->samples,
 				ts->percentile_list, &ovals, &maxv, &minv);
 
 		if (len > FIO_IO_U_LIST_MAX_LEN)
@@ -1530,9 +1649,10 @@ static struct json_object *add_ddir_lat_json(struct thread_stat *ts, uint32_t pe
 			clat_bins_object = json_create_object();
 			json_object_add_value_object(lat_object, "bins", clat_bins_object);
 
-			for(i = 0; i < FIO_IO_U_PLAT_NR; i++)
+			for(i = 0; i < plat_nr(ts->plat_bits); i++)
 				if (io_u_plat[i]) {
-					snprintf(buf, sizeof(buf), "%llu", plat_idx_to_val(i));
+					snprintf(buf, sizeof(buf), "%llu",
+						 plat_idx_to_val(i, ts->plat_bits));
 					json_object_add_value_int(clat_bins_object, buf, io_u_plat[i]);
 				}
 		}
@@ -1592,6 +1712,14 @@ static void add_ddir_status_json(struct thread_stat *ts,
 		tmp_object = add_ddir_lat_json(ts, ts->lat_percentiles,
 				&ts->lat_stat[ddir], ts->io_u_plat[FIO_LAT][ddir]);
 		json_object_add_value_object(dir_object, "lat_ns", tmp_object);
+
+		if (ts->co_lat_stat[ddir].samples) {
+			tmp_object = add_ddir_lat_json(ts, 1,
+					&ts->co_lat_stat[ddir],
+					ts->io_u_plat[FIO_CO_LAT][ddir]);
+			json_object_add_value_object(dir_object, "co_lat_ns",
+						     tmp_object);
+		}
 	} else {
 		json_object_add_value_int(dir_object, "total_ios", ts->total_io_u[DDIR_SYNC]);
 		tmp_object = add_ddir_lat_json(ts, ts->lat_percentiles | ts->clat_percentiles,
@@ -1674,6 +1802,7 @@ static void add_mixed_ddir_status_json(struct thread_stat *ts,
 		ts_lcl->clat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->slat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->lat_stat[i].min_val = ULONG_MAX;
+		ts_lcl->co_lat_stat[i].min_val = ULONG_MAX;
 		ts_lcl->bw_stat[i].min_val = ULONG_MAX;
 		ts_lcl->iops_stat[i].min_val = ULONG_MAX;
 		ts_lcl->clat_high_prio_stat[i].min_val = ULONG_MAX;
@@ -1828,6 +1957,21 @@ static struct json_object *show_thread_status_json(struct thread_stat *ts,
 	if (ts->unified_rw_rep == UNIFIED_BOTH)
 		add_mixed_ddir_status_json(ts, rs, root);
 
+	if (ts->clock_batch_stat.samples) {
+		tmp = add_ddir_lat_json(ts, 0, &ts->clock_batch_stat, NULL);
+		json_object_add_value_object(root, "clock_batch_ns", tmp);
+	}
+
+	if (ts->arrival_depth_stat.samples) {
+		struct json_object *queue = json_create_object();
+
+		json_object_add_value_object(root, "arrival_queue", queue);
+		tmp = add_ddir_lat_json(ts, 0, &ts->arrival_wait_stat, NULL);
+		json_object_add_value_object(queue, "wait_ns", tmp);
+		tmp = add_ddir_lat_json(ts, 0, &ts->arrival_depth_stat, NULL);
+		json_object_add_value_object(queue, "depth", tmp);
+	}
+
 	/* CPU Usage */
 	if (ts->total_run_time) {
 		double runt = (double) ts->total_run_time;
@@ -2150,11 +2294,51 @@ void sum_group_stats(struct group_run_stats *dst, struct group_run_stats *src)
 		dst->sig_figs = src->sig_figs;
 }
 
+/*
+ * Add the latency histogram in src to dst. Only the bucket groups marked in
+ * src_groups can hold samples, so skip the rest of the (mostly empty)
+ * FIO_IO_U_PLAT_NR buckets. Histograms recorded with a different precision
+ * are re-binned by the value each bucket represents.
+ */
+static void sum_plat_groups(uint64_t *dst, uint32_t *dst_groups,
+			    unsigned int dst_bits, const uint64_t *src,
+			    uint32_t src_groups, unsigned int src_bits)
+{
+	uint32_t groups = src_groups;
+
+	if (dst_bits == src_bits)
+		*dst_groups |= src_groups;
+
+	while (groups) {
+		unsigned int start, i, idx;
+
+		start = ffs64(groups) << FIO_IO_U_PLAT_BITS;
+		for (i = start; i < start + FIO_IO_U_PLAT_VAL; i++) {
+			if (dst_bits == src_bits) {
+				dst[i] += src[i];
+				continue;
+			}
+			if (!src[i])
+				continue;
+
+			idx = plat_val_to_idx(plat_idx_to_val(i, src_bits),
+						dst_bits);
+			dst[idx] += src[i];
+			*dst_groups |= plat_idx_to_group(idx);
+		}
+
+		groups &= groups - 1;
+	}
+}
+
 void sum_thread_stats(struct thread_stat *dst, struct thread_stat *src,
 		      bool first)
 {
 	int k, l, m;
 
+	if (first)
+		dst->plat_bits = src->plat_bits;
+
 	for (l = 0; l < DDIR_RWDIR_CNT; l++) {
 		if (!(dst->unified_rw_rep == UNIFIED_MIXED)) {
 			sum_stat(&dst->clat_stat[l], &src->clat_stat[l], first, false);
@@ -2162,6 +2346,7 @@ void sum_thread_stats(struct thread_stat *dst, struct thread_stat *src,
 			sum_stat(&dst->clat_low_prio_stat[l], &src->clat_low_prio_stat[l], first, false);
 			sum_stat(&dst->slat_stat[l], &src->slat_stat[l], first, false);
 			sum_stat(&dst->lat_stat[l], &src->lat_stat[l], first, false);
+			sum_stat(&dst->co_lat_stat[l], &src->co_lat_stat[l], first, false);
 			sum_stat(&dst->bw_stat[l], &src->bw_stat[l], first, true);
 			sum_stat(&dst->iops_stat[l], &src->iops_stat[l], first, true);
 
@@ -2175,6 +2360,7 @@ void sum_thread_stats(struct thread_stat *dst, struct thread_stat *src,
 			sum_stat(&dst->clat_low_prio_stat[0], &src->clat_low_prio_stat[l], first, false);
 			sum_stat(&dst->slat_stat[0], &src->slat_stat[l], first, false);
 			sum_stat(&dst->lat_stat[0], &src->lat_stat[l], first, false);
+			sum_stat(&dst->co_lat_stat[0], &src->co_lat_stat[l], first, false);
 			sum_stat(&dst->bw_stat[0], &src->bw_stat[l], first, true);
 			sum_stat(&dst->iops_stat[0], &src->iops_stat[l], first, true);
 
@@ -2192,6 +2378,9 @@ void sum_thread_stats(struct thread_stat *dst, struct thread_stat *src,
 	}
 
 	sum_stat(&dst->sync_stat, &src->sync_stat, first, false);
+	sum_stat(&dst->clock_batch_stat, &src->clock_batch_stat, first, false);
+	sum_stat(&dst->arrival_wait_stat, &src->arrival_wait_stat, first, false);
+	sum_stat(&dst->arrival_depth_stat, &src->arrival_depth_stat, first, false);
 	dst->usr_time += src->usr_time;
 	dst->sys_time += src->sys_time;
 	dst->ctx += src->ctx;
@@ -2225,28 +2414,31 @@ void sum_thread_stats(struct thread_stat *dst, struct thread_stat *src,
 
 	dst->total_io_u[DDIR_SYNC] += src->total_io_u[DDIR_SYNC];
 
-	for (k = 0; k < FIO_LAT_CNT; k++)
-		for (l = 0; l < DDIR_RWDIR_CNT; l++)
-			for (m = 0; m < FIO_IO_U_PLAT_NR; m++)
-				if (!(dst->unified_rw_rep == UNIFIED_MIXED))
-					dst->io_u_plat[k][l][m] += src->io_u_plat[k][l][m];
-				else
-					dst->io_u_plat[k][0][m] += src->io_u_plat[k][l][m];
+	for (k = 0; k < FIO_LAT_CNT; k++) {
+		for (l = 0; l < DDIR_RWDIR_CNT; l++) {
+			m = (dst->unified_rw_rep == UNIFIED_MIXED) ? 0 : l;
+			sum_plat_groups(dst->io_u_plat[k][m],
+					&dst->io_u_plat_groups[k][m],
+					dst->plat_bits, src->io_u_plat[k][l],
+					src->io_u_plat_groups[k][l],
+					src->plat_bits);
+		}
+	}
 
-	for (k = 0; k < FIO_IO_U_PLAT_NR; k++)
-		dst->io_u_sync_plat[k] += src->io_u_sync_plat[k];
+	sum_plat_groups(dst->io_u_sync_plat, &dst->io_u_sync_plat_groups,
+			dst->plat_bits, src->io_u_sync_plat,
+			src->io_u_sync_plat_groups, src->plat_bits);
 
 	for (k = 0; k < DDIR_RWDIR_CNT; k++) {
-		for (m = 0; m < FIO_IO_U_PLAT_NR; m++) {
-			if (!(dst->unified_rw_rep == UNIFIED_MIXED)) {
-				dst->io_u_plat_high_prio[k][m] += src->io_u_plat_high_prio[k][m];
-				dst->io_u_plat_low_prio[k][m] += src->io_u_plat_low_prio[k][m];
-			} else {
-				dst->io_u_plat_high_prio[0][m] += src->io_u_plat_high_prio[k][m];
-				dst->io_u_plat_low_prio[0][m] += src->io_u_plat_low_prio[k][m];
-			}
-
-		}
+		m = (dst->unified_rw_rep == UNIFIED_MIXED) ? 0 : k;
+		sum_plat_groups(dst->io_u_plat_high_prio[m],
+				&dst->io_u_plat_prio_groups[m], dst->plat_bits,
+				src->io_u_plat_high_prio[k],
+				src->io_u_plat_prio_groups[k], src->plat_bits);
+		sum_plat_groups(dst->io_u_plat_low_prio[m],
+				&dst->io_u_plat_prio_groups[m], dst->plat_bits,
+				src->io_u_plat_low_prio[k],
+				src->io_u_plat_prio_groups[k], src->plat_bits);
 	}
 
 	dst->total_run_time += src->total_run_time;
@@ -2274,6 +2466,7 @@ void init_thread_stat(struct thread_stat *ts)
 
 	for (j = 0; j < DDIR_RWDIR_CNT; j++) {
 		ts->lat_stat[j].min_val = -1UL;
+		ts->co_lat_stat[j].min_val = -1UL;
 		ts->clat_stat[j].min_val = -1UL;
 		ts->slat_stat[j].min_val = -1UL;
 		ts->bw_stat[j].min_val = -1UL;
@@ -2282,6 +2475,9 @@ void init_thread_stat(struct thread_stat *ts)
 		ts->clat_low_prio_stat[j].min_val = -1UL;
 	}
 	ts->sync_stat.min_val = -1UL;
+	ts->clock_batch_stat.min_val = -1UL;
+	ts->arrival_wait_stat.min_val = -1UL;
+	ts->arrival_depth_stat.min_val = -1UL;
 	ts->groupid = -1;
 }
 
@@ -2715,7 +2911,24 @@ static struct io_logs *get_new_log(struct io_log *iolog)
 	 * Cap the size at MAX_LOG_ENTRIES, so we don't keep doubling
 	 * forever
 	 */
-	if (!iolog->cur_log_max)
+	if (iolog->log_mem_limit) {
+		size_t avail = iolog->log_mem_limit;
+
+		/*
+		 * Fixed size chunks, a quarter of what the pending chunk
+		 * leaves of the limit. One is being filled, up to two are
+		 * queued for writing, and one is kept as a spare.
+		 */
+		if (iolog->pending) {
+			size_t pending_size = iolog->pending->max_samples *
+						log_entry_sz(iolog);
+
+			avail = avail > pending_size ? avail - pending_size : 0;
+		}
+		new_samples = avail / (4 * log_entry_sz(iolog));
+		if (new_samples > MAX_LOG_ENTRIES)
+			new_samples = MAX_LOG_ENTRIES;
+	} else if (!iolog->cur_log_max)
 		new_samples = DEF_LOG_ENTRIES;
 	else {
 		new_samples = iolog->cur_log_max * 2;
@@ -2723,12 +2936,22 @@ static struct io_logs *get_new_log(struct io_log *iolog)
 			new_samples = MAX_LOG_ENTRIES;
 	}
 
+	/*
+	 * A regrow moves all of the pending samples into the new chunk
+	 */
+	if (iolog->pending && new_samples < iolog->pending->max_samples)
+		new_samples = iolog->pending->max_samples;
+	else if (!new_samples)
+		new_samples = 1;
+
 	new_size = new_samples * log_entry_sz(iolog);
 
 	cur_log = smalloc(sizeof(*cur_log));
 	if (cur_log) {
 		INIT_FLIST_HEAD(&cur_log->list);
-		cur_log->log = malloc(new_size);
+		cur_log->log = iolog_get_spare(iolog);
+		if (!cur_log->log)
+			cur_log->log = malloc(new_size);
 		if (cur_log->log) {
 			cur_log->nr_samples = 0;
 			cur_log->max_samples = new_samples;
@@ -2748,7 +2971,6 @@ static struct io_logs *get_new_log(struct io_log *iolog)
 static struct io_logs *regrow_log(struct io_log *iolog)
 {
 	struct io_logs *cur_log;
-	int i;
 
 	if (!iolog || iolog->disabled)
 		goto disable;
@@ -2764,10 +2986,10 @@ static struct io_logs *regrow_log(struct io_log *iolog)
 		return cur_log;
 
 	/*
-	 * No room for a new sample. If we're compressing on the fly, flush
-	 * out the current chunk
+	 * No room for a new sample. If we're compressing on the fly, or
+	 * streaming the log from the job, flush out the current chunk
 	 */
-	if (iolog->log_gz) {
+	if (iolog->log_gz || stream_log(iolog)) {
 		if (iolog_cur_flush(iolog, cur_log)) {
 			log_err("fio: failed flushing iolog! Will stop logging.\n");
 			return NULL;
@@ -2787,15 +3009,11 @@ static struct io_logs *regrow_log(struct io_log *iolog)
 		return cur_log;
 
 	/*
-	 * Flush pending items to new log
+	 * Flush pending items to new log, get_new_log() made it big enough
 	 */
-	for (i = 0; i < iolog->pending->nr_samples; i++) {
-		struct io_sample *src, *dst;
-
-		src = get_sample(iolog, iolog->pending, i);
-		dst = get_sample(iolog, cur_log, i);
-		memcpy(dst, src, log_entry_sz(iolog));
-	}
+	assert(iolog->pending->nr_samples <= cur_log->max_samples);
+	memcpy(cur_log->log, iolog->pending->log,
+	       iolog->pending->nr_samples * log_entry_sz(iolog));
 	cur_log->nr_samples = iolog->pending->nr_samples;
 
 	iolog->pending->nr_samples = 0;
@@ -2852,8 +3070,15 @@ static struct io_logs *get_cur_log(struct io_log *iolog)
 
 	if (iolog->td)
 		iolog->td->flags |= TD_F_REGROW_LOGS;
-	if (iolog->pending)
-		assert(iolog->pending->nr_samples < iolog->pending->max_samples);
+
+	/*
+	 * The submission side hasn't got to the regrow before the pending
+	 * chunk filled up as well, do it now.
+	 */
+	if (iolog->pending &&
+	    iolog->pending->nr_samples == iolog->pending->max_samples)
+		return regrow_log(iolog);
+
 	return iolog->pending;
 }
 
@@ -2912,6 +3137,7 @@ void reset_io_stats(struct thread_data *td)
 		reset_io_stat(&ts->clat_stat[i]);
 		reset_io_stat(&ts->slat_stat[i]);
 		reset_io_stat(&ts->lat_stat[i]);
+		reset_io_stat(&ts->co_lat_stat[i]);
 		reset_io_stat(&ts->bw_stat[i]);
 		reset_io_stat(&ts->iops_stat[i]);
 
@@ -2934,6 +3160,13 @@ void reset_io_stats(struct thread_data *td)
 			for (k = 0; k < FIO_IO_U_PLAT_NR; k++)
 				ts->io_u_plat[i][j][k] = 0;
 
+	memset(ts->io_u_plat_groups, 0, sizeof(ts->io_u_plat_groups));
+	memset(ts->io_u_plat_prio_groups, 0, sizeof(ts->io_u_plat_prio_groups));
+	ts->io_u_sync_plat_groups = 0;
+	reset_io_stat(&ts->clock_batch_stat);
+	reset_io_stat(&ts->arrival_wait_stat);
+	reset_io_stat(&ts->arrival_depth_stat);
+
 	ts->total_io_u[DDIR_SYNC] = 0;
 
 	for (i = 0; i < FIO_IO_U_MAP_NR; i++) {
@@ -3067,27 +3300,50 @@ void add_agg_sample(union io_sample_data data, enum fio_ddir ddir,
 
 void add_sync_clat_sample(struct thread_stat *ts, unsigned long long nsec)
 {
-	unsigned int idx = plat_val_to_idx(nsec);
+	unsigned int idx = plat_val_to_idx(nsec, ts->plat_bits);
 	assert(idx < FIO_IO_U_PLAT_NR);
 
 	ts->io_u_sync_plat[idx]++;
+	ts->io_u_sync_plat_groups |= plat_idx_to_group(idx);
 	add_stat_sample(&ts->sync_stat, nsec);
 }
 
+void add_arrival_sample(struct thread_data *td, unsigned long long nsec,
+			unsigned int depth)
+{
+	const bool needs_lock = td_async_processing(td);
+	struct thread_stat *ts = &td->ts;
+
+	if (needs_lock)
+		__td_io_u_lock(td);
+
+	add_stat_sample(&ts->arrival_wait_stat, nsec);
+	add_stat_sample(&ts->arrival_depth_stat, depth);
+
+	if (needs_lock)
+		__td_io_u_unlock(td);
+}
+
+void add_clock_batch_sample(struct thread_stat *ts, unsigned long long nsec)
+{
+	add_stat_sample(&ts->clock_batch_stat, nsec);
+}
+
 static void add_lat_percentile_sample_noprio(struct thread_stat *ts,
 				unsigned long long nsec, enum fio_ddir ddir, enum fio_lat lat)
 {
-	unsigned int idx = plat_val_to_idx(nsec);
+	unsigned int idx = plat_val_to_idx(nsec, ts->plat_bits);
 	assert(idx < FIO_IO_U_PLAT_NR);
 
 	ts->io_u_plat[lat][ddir][idx]++;
+	ts->io_u_plat_groups[lat][ddir] |= plat_idx_to_group(idx);
 }
 
 static void add_lat_percentile_sample(struct thread_stat *ts,
 				unsigned long long nsec, enum fio_ddir ddir,
 				bool high_prio, enum fio_lat lat)
 {
-	unsigned int idx = plat_val_to_idx(nsec);
+	unsigned int idx = plat_val_to_idx(nsec, ts->plat_bits);
 
 	add_lat_percentile_sample_noprio(ts, nsec, ddir, lat);
 
@@ -3095,20 +3351,19 @@ static void add_lat_percentile_sample(struct thread_stat *ts,
 		ts->io_u_plat_low_prio[ddir][idx]++;
 	else
 		ts->io_u_plat_high_prio[ddir][idx]++;
+
+	ts->io_u_plat_prio_groups[ddir] |= plat_idx_to_group(idx);
 }
 
-void add_clat_sample(struct thread_data *td, enum fio_ddir ddir,
-		     unsigned long long nsec, unsigned long long bs,
-		     uint64_t offset, unsigned int ioprio, bool high_prio)
+static void __add_clat_sample(struct thread_data *td, enum fio_ddir ddir,
+			      unsigned long long nsec, unsigned long long bs,
+			      uint64_t offset, unsigned int ioprio,
+			      bool high_prio)
 {
-	const bool needs_lock = td_async_processing(td);
 	unsigned long elapsed, this_window;
 	struct thread_stat *ts = &td->ts;
 	struct io_log *iolog = td->clat_hist_log;
 
-	if (needs_lock)
-		__td_io_u_lock(td);
-
 	add_stat_sample(&ts->clat_stat[ddir], nsec);
 
 	if (!ts->lat_percentiles) {
@@ -3166,6 +3421,18 @@ void add_clat_sample(struct thread_data *td, enum fio_ddir ddir,
 			hw->samples = 0;
 		}
 	}
+}
+
+void add_clat_sample(struct thread_data *td, enum fio_ddir ddir,
+		     unsigned long long nsec, unsigned long long bs,
+		     uint64_t offset, unsigned int ioprio, bool high_prio)
+{
+	const bool needs_lock = td_async_processing(td);
+
+	if (needs_lock)
+		__td_io_u_lock(td);
+
+	__add_clat_sample(td, ddir, nsec, bs, offset, ioprio, high_prio);
 
 	if (needs_lock)
 		__td_io_u_unlock(td);
@@ -3197,19 +3464,13 @@ void add_slat_sample(struct thread_data *td, enum fio_ddir ddir,
 		__td_io_u_unlock(td);
 }
 
-void add_lat_sample(struct thread_data *td, enum fio_ddir ddir,
-		    unsigned long long nsec, unsigned long long bs,
-		    uint64_t offset, unsigned int ioprio, bool high_prio)
+static void __add_lat_sample(struct thread_data *td, enum fio_ddir ddir,
+			     unsigned long long nsec, unsigned long long bs,
+			     uint64_t offset, unsigned int ioprio,
+			     bool high_prio)
 {
-	const bool needs_lock = td_async_processing(td);
 	struct thread_stat *ts = &td->ts;
 
-	if (!ddir_rw(ddir))
-		return;
-
-	if (needs_lock)
-		__td_io_u_lock(td);
-
 	add_stat_sample(&ts->lat_stat[ddir], nsec);
 
 	if (td->lat_log)
@@ -3222,8 +3483,67 @@ void add_lat_sample(struct thread_data *td, enum fio_ddir ddir,
 			add_stat_sample(&ts->clat_high_prio_stat[ddir], nsec);
 		else
 			add_stat_sample(&ts->clat_low_prio_stat[ddir], nsec);
+	}
+}
+
+void add_lat_sample(struct thread_data *td, enum fio_ddir ddir,
+		    unsigned long long nsec, unsigned long long bs,
+		    uint64_t offset, unsigned int ioprio, bool high_prio)
+{
+	const bool needs_lock = td_async_processing(td);
+
+	if (!ddir_rw(ddir))
+		return;
+
+	if (needs_lock)
+		__td_io_u_lock(td);
+
+	__add_lat_sample(td, ddir, nsec, bs, offset, ioprio, high_prio);
+
+	if (needs_lock)
+		__td_io_u_unlock(td);
+}
+
+/*
+ * Add the lat and clat samples of a batch of completions, taking the
+ * io_u lock once for all of them.
+ */
+void add_lat_samples(struct thread_data *td, const struct lat_sample *s,
+		     unsigned int nr)
+{
+	const bool needs_lock = td_async_processing(td);
+	unsigned int i;
 
+	if (needs_lock)
+		__td_io_u_lock(td);
+
+	for (i = 0; i < nr; i++, s++) {
+		const bool high_prio = s->flags & LAT_SAMPLE_HIGH_PRIO;
+
+		if (s->flags & LAT_SAMPLE_LAT)
+			__add_lat_sample(td, s->ddir, s->lat, s->bs, s->offset,
+					 s->ioprio, high_prio);
+		if (s->flags & LAT_SAMPLE_CLAT)
+			__add_clat_sample(td, s->ddir, s->clat, s->bs,
+					  s->offset, s->ioprio, high_prio);
 	}
+
+	if (needs_lock)
+		__td_io_u_unlock(td);
+}
+
+void add_co_lat_sample(struct thread_data *td, enum fio_ddir ddir,
+		       unsigned long long nsec)
+{
+	const bool needs_lock = td_async_processing(td);
+	struct thread_stat *ts = &td->ts;
+
+	if (needs_lock)
+		__td_io_u_lock(td);
+
+	add_stat_sample(&ts->co_lat_stat[ddir], nsec);
+	add_lat_percentile_sample_noprio(ts, nsec, ddir, FIO_CO_LAT);
+
 	if (needs_lock)
 		__td_io_u_unlock(td);
 }
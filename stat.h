@@ -33,6 +33,15 @@ struct group_run_stats {
 #define FIO_IO_U_PLAT_VAL (1 << FIO_IO_U_PLAT_BITS)
 #define FIO_IO_U_PLAT_GROUP_NR 29
 #define FIO_IO_U_PLAT_NR (FIO_IO_U_PLAT_GROUP_NR * FIO_IO_U_PLAT_VAL)
+
+/*
+ * Power of two latency buckets for live exporters, see plat_fold_pow2().
+ * Bucket i counts samples up to 2^(FIO_PLAT_POW2_MIN + i) nsec, the last
+ * one those above 2^FIO_PLAT_POW2_MAX nsec.
+ */
+#define FIO_PLAT_POW2_MIN	10
+#define FIO_PLAT_POW2_MAX	34
+#define FIO_PLAT_POW2_NR	(FIO_PLAT_POW2_MAX - FIO_PLAT_POW2_MIN + 2)
 #define FIO_IO_U_LIST_MAX_LEN 20 /* The size of the default and user-specified
 					list of percentiles */
 
@@ -56,6 +65,16 @@ struct group_run_stats {
  *
  * FIO_IO_U_PLAT_NR is the total number of buckets.
  *
+ * FIO_IO_U_PLAT_BITS is only the default precision. A job can pick fewer
+ * index bits with lat_hist_bits, trading precision for range within the
+ * same FIO_IO_U_PLAT_NR buckets: each bit less halves the buckets used per
+ * group and so doubles the number of groups. More bits than the default
+ * aren't allowed, the buckets would only cover a few microseconds. The
+ * arrays are always sized for FIO_IO_U_PLAT_NR, whatever the precision,
+ * since thread_stat is a fixed layout in shared memory and on the wire.
+ * The precision a histogram was recorded with is kept in
+ * thread_stat->plat_bits.
+ *
  * DETAILS
  *
  * Suppose the lat varies from 0 to 999 (usec), the straightforward
@@ -154,8 +173,9 @@ enum fio_lat {
 	FIO_SLAT = 0,
 	FIO_CLAT,
 	FIO_LAT,
+	FIO_CO_LAT,
 
-	FIO_LAT_CNT = 3,
+	FIO_LAT_CNT = 4,
 };
 
 struct thread_stat {
@@ -193,7 +213,7 @@ struct thread_stat {
 	uint32_t clat_percentiles;
 	uint32_t lat_percentiles;
 	uint32_t slat_percentiles;
-	uint32_t pad;
+	uint32_t plat_bits;
 	uint64_t percentile_precision;
 	fio_fp64_t percentile_list[FIO_IO_U_LIST_MAX_LEN];
 
@@ -269,6 +289,29 @@ struct thread_stat {
 
 	uint64_t cachehit;
 	uint64_t cachemiss;
+
+	/*
+	 * Bitmaps of the FIO_IO_U_PLAT_VAL sized bucket groups that hold
+	 * samples in the matching latency histograms above. Merging stats
+	 * only needs to walk the groups that are set.
+	 */
+	uint32_t io_u_plat_groups[FIO_LAT_CNT][DDIR_RWDIR_CNT];
+	uint32_t io_u_plat_prio_groups[DDIR_RWDIR_CNT];
+	uint32_t io_u_sync_plat_groups;
+	uint32_t pad6;
+
+	/*
+	 * With gtod_batch, the age of each shared timestamp when it was
+	 * replaced, an upper bound on the error of the stamps taken from it.
+	 */
+	struct io_stat clock_batch_stat __attribute__((aligned(8)));
+
+	/* rate_co_lat: latency from the intended issue time of the rate */
+	struct io_stat co_lat_stat[DDIR_RWDIR_CNT] __attribute__((aligned(8)));
+
+	/* arrival_process: time spent in the arrival queue, and its depth */
+	struct io_stat arrival_wait_stat __attribute__((aligned(8)));
+	struct io_stat arrival_depth_stat;
 } __attribute__((packed));
 
 #define JOBS_ETA {							\
@@ -331,7 +374,8 @@ extern void init_thread_stat(struct thread_stat *ts);
 extern void init_group_run_stat(struct group_run_stats *gs);
 extern void eta_to_str(char *str, unsigned long eta_sec);
 extern bool calc_lat(struct io_stat *is, unsigned long long *min, unsigned long long *max, double *mean, double *dev);
-extern unsigned int calc_clat_percentiles(uint64_t *io_u_plat, unsigned long long nr, fio_fp64_t *plist, unsigned long long **output, unsigned long long *maxv, unsigned long long *minv);
+extern uint64_t plat_fold_pow2(const uint64_t *io_u_plat, uint32_t groups, unsigned int plat_bits, uint64_t *hist);
+extern unsigned int calc_clat_percentiles(uint64_t *io_u_plat, unsigned int plat_bits, unsigned long long nr, fio_fp64_t *plist, unsigned long long **output, unsigned long long *maxv, unsigned long long *minv);
 extern void stat_calc_lat_n(struct thread_stat *ts, double *io_u_lat);
 extern void stat_calc_lat_m(struct thread_stat *ts, double *io_u_lat);
 extern void stat_calc_lat_u(struct thread_stat *ts, double *io_u_lat);
@@ -340,8 +384,30 @@ extern void reset_io_stats(struct thread_data *);
 extern void update_rusage_stat(struct thread_data *);
 extern void clear_rusage_stat(struct thread_data *);
 
+/*
+ * A completion's lat/clat samples, queued so that a reaped batch can be
+ * added to the stats in one go.
+ */
+enum {
+	LAT_SAMPLE_LAT		= 1 << 0,
+	LAT_SAMPLE_CLAT		= 1 << 1,
+	LAT_SAMPLE_HIGH_PRIO	= 1 << 2,
+};
+
+struct lat_sample {
+	unsigned long long lat;
+	unsigned long long clat;
+	unsigned long long bs;
+	uint64_t offset;
+	unsigned int ioprio;
+	uint8_t ddir;
+	uint8_t flags;
+};
+
 extern void add_lat_sample(struct thread_data *, enum fio_ddir, unsigned long long,
 			   unsigned long long, uint64_t, unsigned int, bool);
+extern void add_lat_samples(struct thread_data *, const struct lat_sample *,
+			    unsigned int);
 extern void add_clat_sample(struct thread_data *, enum fio_ddir, unsigned long long,
 			    unsigned long long, uint64_t, unsigned int, bool);
 extern void add_slat_sample(struct thread_data *, enum fio_ddir, unsigned long long,
@@ -351,6 +417,12 @@ extern void add_iops_sample(struct thread_data *, struct io_u *,
 				unsigned int);
 extern void add_bw_sample(struct thread_data *, struct io_u *,
 				unsigned int, unsigned long long);
+extern void add_co_lat_sample(struct thread_data *, enum fio_ddir,
+			      unsigned long long);
+extern void add_arrival_sample(struct thread_data *, unsigned long long,
+			       unsigned int);
+extern void add_clock_batch_sample(struct thread_stat *ts,
+				  unsigned long long nsec);
 extern void add_sync_clat_sample(struct thread_stat *ts,
 				unsigned long long nsec);
 extern int calc_log_samples(void);
@@ -559,6 +559,140 @@ class FioJobTest_iops_rate(FioJobTest):
             self.passed = False
 
 
+class FioJobTest_t0015(FioJobTest):
+    """Test consists of fio test job t0015
+    Confirm that with gtod_batch the mean lat of the rate_iops job is
+    well below its 1ms inter-I/O gap, and that of the thinktime job is
+    well below its 10ms thinktime"""
+
+    def check_result(self):
+        super(FioJobTest_t0015, self).check_result()
+
+        if not self.passed:
+            return
+
+        limits = [250000, 2500000]
+        for i, limit in enumerate(limits):
+            lat = self.json_data['jobs'][i]['read']['lat_ns']['mean']
+            logging.debug("Test %d: job %d lat mean: %f", self.testnum, i, lat)
+
+            if lat > limit:
+                self.failure_reason = "{0} job {1} lat mean {2} over {3},".format(
+                    self.failure_reason, i, lat, limit)
+                self.passed = False
+
+
+class FioJobTest_t0016(FioJobTest):
+    """Test consists of fio test jobs t0016-pre and t0016
+    Confirm that the verify_state_load run reads back everything the
+    pre job wrote, as listed in the verify journal"""
+
+    def check_result(self):
+        super(FioJobTest_t0016, self).check_result()
+
+        if not self.passed:
+            return
+
+        io_bytes = self.json_data['jobs'][0]['read']['io_bytes']
+        logging.debug("Test %d: verified bytes: %d", self.testnum, io_bytes)
+
+        if io_bytes != 16 * 1024 * 1024:
+            self.failure_reason = "{0} verified {1} bytes, not 16 MiB,".format(
+                self.failure_reason, io_bytes)
+            self.passed = False
+
+
+class FioJobTest_t0018(FioJobTest):
+    """Test consists of fio test job t0018
+    Confirm that the four jobs sharing a new zbdemu file wrote 64 MiB"""
+
+    def check_result(self):
+        super(FioJobTest_t0018, self).check_result()
+
+        if not self.passed:
+            return
+
+        io_bytes = self.json_data['jobs'][0]['write']['io_bytes']
+        logging.debug("Test %d: written bytes: %d", self.testnum, io_bytes)
+
+        if io_bytes != 64 * 1024 * 1024:
+            self.failure_reason = "{0} wrote {1} bytes, not 64 MiB,".format(
+                self.failure_reason, io_bytes)
+            self.passed = False
+
+
+class FioJobTest_t0019(FioJobTest):
+    """Test consists of fio test job t0019
+    Confirm that the fixed, poisson and trace arrival jobs run at their
+    arrival rates and report their arrival queues"""
+
+    def setup(self, artifact_root, testnum):
+        super(FioJobTest_t0019, self).setup(artifact_root, testnum)
+
+        with open(os.path.join(self.test_dir, "t0019.trace"), "w") as trace:
+            trace.write("# usec\n0\n500\n1000\n1500\n")
+
+    def check_result(self):
+        super(FioJobTest_t0019, self).check_result()
+
+        if not self.passed:
+            return
+
+        rates = [1000, 1000, 2000]
+        for i, rate in enumerate(rates):
+            job = self.json_data['jobs'][i]
+            iops = job['read']['iops']
+            logging.debug("Test %d: job %d iops: %f", self.testnum, i, iops)
+
+            if abs(iops - rate) > rate * 0.1:
+                self.failure_reason = "{0} job {1} iops {2} not near {3},".format(
+                    self.failure_reason, i, iops, rate)
+                self.passed = False
+            if 'arrival_queue' not in job:
+                self.failure_reason = "{0} job {1} has no arrival_queue,".format(
+                    self.failure_reason, i)
+                self.passed = False
+
+
+class FioJobTest_t0020(FioJobTest):
+    """Test consists of fio test job t0020
+    Confirm that co_lat_ns of the rate_co_lat job is at least its lat_ns
+    and includes the thinktime stalls, and that the other job doesn't
+    report co_lat_ns"""
+
+    def check_result(self):
+        super(FioJobTest_t0020, self).check_result()
+
+        if not self.passed:
+            return
+
+        stall = self.json_data['jobs'][0]['read']
+        plain = self.json_data['jobs'][1]['read']
+
+        if 'co_lat_ns' not in stall:
+            self.failure_reason = "{0} no co_lat_ns,".format(self.failure_reason)
+            self.passed = False
+            return
+
+        co_lat = stall['co_lat_ns']
+        lat = stall['lat_ns']
+        logging.debug("Test %d: co_lat mean %f max %d, lat mean %f",
+                      self.testnum, co_lat['mean'], co_lat['max'], lat['mean'])
+
+        if co_lat['mean'] < lat['mean']:
+            self.failure_reason = "{0} co_lat mean {1} below lat mean {2},".format(
+                self.failure_reason, co_lat['mean'], lat['mean'])
+            self.passed = False
+        if co_lat['max'] < 10000000:
+            self.failure_reason = "{0} co_lat max {1} misses the stalls,".format(
+                self.failure_reason, co_lat['max'])
+            self.passed = False
+        if 'co_lat_ns' in plain:
+            self.failure_reason = "{0} co_lat_ns without rate_co_lat,".format(
+                self.failure_reason)
+            self.passed = False
+
+
 class Requirements(object):
     """Requirements consists of multiple run environment characteristics.
     These are to determine if a particular test can be run"""
@@ -820,6 +954,65 @@ TEST_LIST = [
         'output_format':    'json',
         'requirements':     [],
     },
+    {
+        'test_id':          15,
+        'test_class':       FioJobTest_t0015,
+        'job':              't0015.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'output_format':    'json',
+        'requirements':     [],
+    },
+    {
+        'test_id':          16,
+        'test_class':       FioJobTest_t0016,
+        'job':              't0016.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          't0016-pre.fio',
+        'pre_success':      None,
+        'output_format':    'json',
+        'requirements':     [],
+    },
+    {
+        'test_id':          17,
+        'test_class':       FioJobTest,
+        'job':              't0017.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'requirements':     [],
+    },
+    {
+        'test_id':          18,
+        'test_class':       FioJobTest_t0018,
+        'job':              't0018.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'output_format':    'json',
+        'requirements':     [Requirements.linux],
+    },
+    {
+        'test_id':          19,
+        'test_class':       FioJobTest_t0019,
+        'job':              't0019.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'output_format':    'json',
+        'requirements':     [],
+    },
+    {
+        'test_id':          20,
+        'test_class':       FioJobTest_t0020,
+        'job':              't0020.fio',
+        'success':          SUCCESS_DEFAULT,
+        'pre_job':          None,
+        'pre_success':      None,
+        'output_format':    'json',
+        'requirements':     [],
+    },
     {
         'test_id':          1000,
         'test_class':       FioExeTest,
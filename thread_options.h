@@ -145,11 +145,13 @@ struct thread_options {
 	unsigned int verify_fatal;
 	unsigned int verify_dump;
 	unsigned int verify_async;
+	unsigned int verify_workers;
 	unsigned long long verify_backlog;
 	unsigned int verify_batch;
 	unsigned int experimental_verify;
 	unsigned int verify_state;
 	unsigned int verify_state_save;
+	unsigned int verify_state_journal;
 	unsigned int use_thread;
 	unsigned int unlink;
 	unsigned int unlink_each_loop;
@@ -165,6 +167,8 @@ struct thread_options {
 	unsigned int log_offset;
 	unsigned int log_gz;
 	unsigned int log_gz_store;
+	unsigned int log_binary;
+	unsigned long long log_mem_limit;
 	unsigned int log_unix_epoch;
 	unsigned int norandommap;
 	unsigned int softrandommap;
@@ -255,6 +259,7 @@ struct thread_options {
 	unsigned int dedupe_percentage;
 	unsigned int dedupe_mode;
 	unsigned int dedupe_working_set_percentage;
+	unsigned int buffer_pool;
 	unsigned int time_based;
 	unsigned int disable_lat;
 	unsigned int disable_clat;
@@ -263,6 +268,7 @@ struct thread_options {
 	unsigned int unified_rw_rep;
 	unsigned int gtod_reduce;
 	unsigned int gtod_cpu;
+	unsigned int gtod_batch;
 	enum fio_cs clocksource;
 	unsigned int no_stall;
 	unsigned int trim_percentage;
@@ -313,6 +319,10 @@ struct thread_options {
 	unsigned int rate_iops_min[DDIR_RWDIR_CNT];
 	unsigned int rate_process;
 	unsigned int rate_ign_think;
+	unsigned int rate_co_lat;
+	unsigned int arrival_process;
+	unsigned long long arrival_rate;
+	char *arrival_trace;
 
 	char *ioscheduler;
 
@@ -356,6 +366,7 @@ struct thread_options {
 	unsigned int flow_sleep;
 
 	unsigned int sig_figs;
+	unsigned int lat_hist_bits;
 
 	unsigned block_error_hist;
 
@@ -374,6 +385,8 @@ struct thread_options {
 	int max_open_zones;
 	unsigned int job_max_open_zones;
 	unsigned int ignore_zone_limits;
+	unsigned int exclusive_zones;
+	unsigned int zone_append;
 	fio_fp64_t zrt;
 	fio_fp64_t zrf;
 
@@ -666,6 +679,7 @@ struct thread_options_pack {
 	uint32_t flow_sleep;
 
 	uint32_t sig_figs;
+	uint32_t lat_hist_bits;
 
 	uint32_t block_error_hist;
 
@@ -684,6 +698,18 @@ struct thread_options_pack {
 	uint32_t ignore_zone_limits;
 
 	uint32_t log_prio;
+	uint32_t log_binary;
+	uint64_t log_mem_limit;
+	uint32_t buffer_pool;
+	uint32_t verify_state_journal;
+	uint32_t verify_workers;
+	uint32_t exclusive_zones;
+	uint32_t zone_append;
+	uint32_t gtod_batch;
+	uint32_t rate_co_lat;
+	uint32_t arrival_process;
+	uint64_t arrival_rate;
+	uint8_t arrival_trace[FIO_TOP_STR_MAX];
 } __attribute__((packed));
 
 extern void convert_thread_options_to_cpu(struct thread_options *o, struct thread_options_pack *top);
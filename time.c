@@ -44,6 +44,8 @@ uint64_t usec_sleep(struct thread_data *td, unsigned long usec)
 	struct timespec tv;
 	uint64_t t = 0;
 
+	td_batch_time_invalidate(td);
+
 	do {
 		unsigned long ts = usec;
 
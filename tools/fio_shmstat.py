@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""
+fio_shmstat.py
+
+Read the live stats that fio publishes with --shm-stats=file. The file is
+mmap'ed and re-read at every interval, which costs nothing on the fio side,
+so it can be polled at high frequency.
+
+Print a line per job every second until fio is done:
+$ fio_shmstat.py /dev/shm/fio-stats
+
+Poll ten times a second, and only print a group summary:
+$ fio_shmstat.py -i 0.1 --groups /dev/shm/fio-stats
+
+Dump one snapshot as JSON:
+$ fio_shmstat.py --json /dev/shm/fio-stats
+
+The format is a header followed by fixed size job entries in host byte
+order, see struct shm_stats_header and struct shm_stats_job in
+shm-stats.h. Each job entry is guarded by a sequence counter; a copy is
+only used if the counter was even and didn't change while copying.
+"""
+
+import os
+import sys
+import time
+import json
+import mmap
+import struct
+import argparse
+
+MAGIC = b'fioshmst'
+VERSION = 1
+HEADER = struct.Struct('=8sIIIIIIIIQII')
+JOB_BASE = struct.Struct('=IIIIII64sQ')
+DDIRS = ('read', 'write', 'trim')
+# A job entry that stays mid-update is retried this many times, then
+# polled every COPY_SLEEP seconds for up to COPY_TIMEOUT seconds.
+COPY_SPINS = 100
+COPY_SLEEP = 0.001
+COPY_TIMEOUT = 1.0
+RUNSTATES = {0: 'not_created', 1: 'created', 2: 'initialized', 3: 'ramp',
+             4: 'setting_up', 5: 'running', 6: 'pre_reading', 7: 'verifying',
+             8: 'fsyncing', 9: 'finishing', 10: 'exited', 11: 'reaped'}
+
+
+class ShmStats(object):
+    def __init__(self, path):
+        self.f = open(path, 'rb')
+        self.map = mmap.mmap(self.f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if len(self.map) < HEADER.size:
+            raise ValueError('%s: too short for fio shm stats' % path)
+        (magic, version, self.header_size, self.job_size, self.nr_jobs,
+         self.hist_nr, self.hist_min_bit, self.interval_ms, self.pid,
+         _, _, _) = HEADER.unpack_from(self.map, 0)
+        if magic != MAGIC:
+            raise ValueError('%s: not a fio shm stats file' % path)
+        if version != VERSION:
+            raise ValueError('%s: unsupported version %d' % (path, version))
+
+        nr_fields = 7 * len(DDIRS) + len(DDIRS) * self.hist_nr
+        self.job_fields = struct.Struct('=%dQ' % nr_fields)
+        if self.job_size < JOB_BASE.size + self.job_fields.size:
+            raise ValueError('%s: bad job size %d' % (path, self.job_size))
+
+    def header(self):
+        fields = HEADER.unpack_from(self.map, 0)
+        return {'time_ms': fields[9], 'done': fields[10] != 0}
+
+    def _writer_alive(self):
+        try:
+            os.kill(self.pid, 0)
+        except ProcessLookupError:
+            return False
+        except PermissionError:
+            pass
+        return True
+
+    def _copy_job(self, i):
+        off = self.header_size + i * self.job_size
+        deadline = None
+        tries = 0
+        while True:
+            seq = struct.unpack_from('=I', self.map, off)[0]
+            if not seq & 1:
+                buf = self.map[off:off + self.job_size]
+                if struct.unpack_from('=I', self.map, off)[0] == seq:
+                    return buf
+
+            tries += 1
+            if tries < COPY_SPINS:
+                continue
+            # fio won't finish an update it left behind when it stopped
+            if self.header()['done'] or not self._writer_alive():
+                raise ValueError('job %d: entry left mid-update by fio' % i)
+            if deadline is None:
+                deadline = time.time() + COPY_TIMEOUT
+            elif time.time() > deadline:
+                raise ValueError('job %d: no consistent copy after %.1fs' %
+                                 (i, COPY_TIMEOUT))
+            time.sleep(COPY_SLEEP)
+
+    def job(self, i):
+        buf = self._copy_job(i)
+        (_, jobid, groupid, runstate, inflight, _, name,
+         time_ms) = JOB_BASE.unpack_from(buf, 0)
+        vals = self.job_fields.unpack_from(buf, JOB_BASE.size)
+        n = len(DDIRS)
+
+        job = {
+            'jobid': jobid,
+            'groupid': groupid,
+            'name': name.split(b'\0', 1)[0].decode('utf-8', 'replace'),
+            'state': RUNSTATES.get(runstate, str(runstate)),
+            'inflight': inflight,
+            'time_ms': time_ms,
+        }
+        for k, key in enumerate(('io_bytes', 'io_blocks', 'bw', 'iops',
+                                 'clat_min', 'clat_max', 'clat_mean')):
+            job[key] = dict(zip(DDIRS, vals[k * n:(k + 1) * n]))
+
+        hist = vals[7 * n:]
+        job['clat_hist'] = dict((d, list(hist[k * self.hist_nr:
+                                              (k + 1) * self.hist_nr]))
+                                for k, d in enumerate(DDIRS))
+        return job
+
+    def jobs(self):
+        return [self.job(i) for i in range(self.nr_jobs)]
+
+    def percentile(self, hist, pct):
+        """Upper bound in nsec of the bucket holding the pct percentile."""
+        total = sum(hist)
+        if not total:
+            return 0
+        want = total * pct / 100.0
+        cum = 0
+        for i, nr in enumerate(hist):
+            cum += nr
+            if cum >= want:
+                if i == len(hist) - 1:
+                    return float('inf')
+                return 1 << (self.hist_min_bit + i)
+        return float('inf')
+
+
+def fmt_lat(nsec):
+    if not nsec:
+        return '-'
+    if nsec == float('inf'):
+        return 'inf'
+    if nsec >= 1000000:
+        return '%.1fms' % (nsec / 1000000.0)
+    return '%.1fus' % (nsec / 1000.0)
+
+
+def print_jobs(stats, jobs):
+    print('%5s %-16s %-11s %9s %9s %11s %11s %6s %9s %9s' %
+          ('jobid', 'name', 'state', 'r_iops', 'w_iops', 'r_bw(KiB/s)',
+           'w_bw(KiB/s)', 'qd', 'r_p99', 'w_p99'))
+    for j in jobs:
+        print('%5d %-16s %-11s %9d %9d %11d %11d %6d %9s %9s' %
+              (j['jobid'], j['name'][:16], j['state'], j['iops']['read'],
+               j['iops']['write'], j['bw']['read'] // 1024,
+               j['bw']['write'] // 1024, j['inflight'],
+               fmt_lat(stats.percentile(j['clat_hist']['read'], 99)),
+               fmt_lat(stats.percentile(j['clat_hist']['write'], 99))))
+
+
+def print_groups(jobs):
+    groups = {}
+    for j in jobs:
+        g = groups.setdefault(j['groupid'], [0, 0, 0, 0, 0])
+        g[0] += j['iops']['read']
+        g[1] += j['iops']['write']
+        g[2] += j['bw']['read']
+        g[3] += j['bw']['write']
+        g[4] += j['inflight']
+
+    print('%5s %9s %9s %11s %11s %6s' %
+          ('group', 'r_iops', 'w_iops', 'r_bw(KiB/s)', 'w_bw(KiB/s)', 'qd'))
+    for gid in sorted(groups):
+        g = groups[gid]
+        print('%5d %9d %9d %11d %11d %6d' %
+              (gid, g[0], g[1], g[2] // 1024, g[3] // 1024, g[4]))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Read fio --shm-stats live stats')
+    parser.add_argument('file', help='file given to fio --shm-stats')
+    parser.add_argument('-i', '--interval', type=float, default=1.0,
+                        help='seconds between reads (default 1)')
+    parser.add_argument('-n', '--count', type=int, default=0,
+                        help='stop after this many reads')
+    parser.add_argument('--groups', action='store_true',
+                        help='print a line per group instead of per job')
+    parser.add_argument('--json', action='store_true',
+                        help='dump one snapshot as JSON and exit')
+    args = parser.parse_args()
+
+    try:
+        return show(ShmStats(args.file), args)
+    except ValueError as e:
+        print('fio_shmstat: %s' % e, file=sys.stderr)
+        return 1
+
+
+def show(stats, args):
+    if args.json:
+        out = stats.header()
+        out['pid'] = stats.pid
+        out['jobs'] = stats.jobs()
+        json.dump(out, sys.stdout, indent=2)
+        print()
+        return 0
+
+    nr = 0
+    while True:
+        hdr = stats.header()
+        jobs = stats.jobs()
+        print('time %.1fs%s' % (hdr['time_ms'] / 1000.0,
+                                ' (done)' if hdr['done'] else ''))
+        if args.groups:
+            print_groups(jobs)
+        else:
+            print_jobs(stats, jobs)
+        sys.stdout.flush()
+
+        nr += 1
+        if hdr['done'] or (args.count and nr >= args.count):
+            break
+        time.sleep(args.interval)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
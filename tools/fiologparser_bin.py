@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""
+fiologparser_bin.py
+
+Read the binary lat/clat/slat/bw/iops logs that fio writes with
+log_binary=1 and convert them to other formats. The log is mmap'ed, so
+large per-I/O logs are processed without reading them into memory first.
+
+Convert a log to the same CSV layout as a text log:
+$ fiologparser_bin.py csv job_clat.1.log.bin > job_clat.1.log
+
+Split a log into one raw little endian column file per field
+(time.u64, val.u64, bs.u64, offset.u64, ddir.u32, prio.u32), suitable for
+loading with numpy.fromfile() or other columnar tools:
+$ fiologparser_bin.py columns job_clat.1.log.bin outdir
+
+Print a log2 histogram of the sample values per data direction:
+$ fiologparser_bin.py hist job_clat.1.log.bin
+
+The format is a header followed by fixed size records, all little endian,
+see struct iolog_bin_header and struct iolog_bin_sample in iolog.h.
+"""
+
+import os
+import sys
+import mmap
+import struct
+import argparse
+
+MAGIC = b'fiobinlg'
+VERSION = 1
+HEADER = struct.Struct('<8sIIII')
+SAMPLE = struct.Struct('<QQQQII')
+F_OFFSET = 1 << 0
+F_PRIO = 1 << 1
+
+LOG_TYPES = {1: 'lat', 2: 'clat', 3: 'slat', 4: 'bw', 5: 'iops'}
+DDIRS = {0: 'read', 1: 'write', 2: 'trim', 3: 'sync', 4: 'datasync',
+         5: 'sync_file_range', 6: 'wait'}
+COLUMNS = (('time', 'u64'), ('val', 'u64'), ('bs', 'u64'), ('offset', 'u64'),
+           ('ddir', 'u32'), ('prio', 'u32'))
+
+
+class BinLog(object):
+    def __init__(self, path):
+        self.f = open(path, 'rb')
+        self.map = mmap.mmap(self.f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        if len(self.map) < HEADER.size:
+            raise ValueError('%s: too short for a binary log' % path)
+        magic, version, log_type, flags, size = HEADER.unpack_from(self.map, 0)
+        if magic != MAGIC:
+            raise ValueError('%s: not a fio binary log' % path)
+        if version != VERSION:
+            raise ValueError('%s: unsupported version %d' % (path, version))
+        if size < SAMPLE.size:
+            raise ValueError('%s: bad sample size %d' % (path, size))
+
+        self.log_type = log_type
+        self.flags = flags
+        self.sample_size = size
+        self.nr_samples = (len(self.map) - HEADER.size) // size
+
+    def samples(self):
+        off = HEADER.size
+        if self.sample_size == SAMPLE.size:
+            end = off + self.nr_samples * SAMPLE.size
+            for s in SAMPLE.iter_unpack(memoryview(self.map)[off:end]):
+                yield s
+            return
+
+        # newer versions may append fields, skip over them
+        for i in range(self.nr_samples):
+            yield SAMPLE.unpack_from(self.map, off + i * self.sample_size)
+
+    def close(self):
+        self.map.close()
+        self.f.close()
+
+
+def to_csv(log, out):
+    has_offset = log.flags & F_OFFSET
+    prio_fmt = '0x%04x' if log.flags & F_PRIO else '%u'
+
+    if has_offset:
+        fmt = '%u, %u, %u, %u, %u, ' + prio_fmt + '\n'
+    else:
+        fmt = '%u, %u, %u, %u, ' + prio_fmt + '\n'
+
+    for time, val, bs, offset, ddir, prio in log.samples():
+        if has_offset:
+            out.write(fmt % (time, val, ddir, bs, offset, prio))
+        else:
+            out.write(fmt % (time, val, ddir, bs, prio))
+
+
+def to_columns(log, outdir):
+    if not os.path.isdir(outdir):
+        os.makedirs(outdir)
+
+    files = []
+    for name, kind in COLUMNS:
+        files.append(open(os.path.join(outdir, '%s.%s' % (name, kind)), 'wb'))
+
+    packers = [struct.Struct('<Q'), struct.Struct('<Q'), struct.Struct('<Q'),
+               struct.Struct('<Q'), struct.Struct('<I'), struct.Struct('<I')]
+    bufs = [bytearray() for _ in files]
+    for s in log.samples():
+        for i, v in enumerate(s):
+            bufs[i] += packers[i].pack(v)
+        if len(bufs[0]) >= 1 << 20:
+            for f, b in zip(files, bufs):
+                f.write(b)
+                del b[:]
+
+    for f, b in zip(files, bufs):
+        f.write(b)
+        f.close()
+
+
+def to_hist(log, out):
+    hists = {}
+    for time, val, bs, offset, ddir, prio in log.samples():
+        h = hists.setdefault(ddir, {})
+        bucket = val.bit_length()
+        h[bucket] = h.get(bucket, 0) + 1
+
+    for ddir in sorted(hists):
+        h = hists[ddir]
+        total = sum(h.values())
+        out.write('%s: %d samples\n' % (DDIRS.get(ddir, str(ddir)), total))
+        cum = 0
+        for bucket in sorted(h):
+            cum += h[bucket]
+            low = (1 << (bucket - 1)) if bucket else 0
+            high = (1 << bucket) - 1 if bucket else 0
+            out.write('  [%u, %u]: %d (%.2f%%)\n' %
+                      (low, high, h[bucket], 100.0 * cum / total))
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(
+        description='Convert fio binary logs (log_binary=1)')
+    sub = parser.add_subparsers(dest='cmd')
+    sub.required = True
+
+    p = sub.add_parser('csv', help='convert to the text log format')
+    p.add_argument('log')
+
+    p = sub.add_parser('columns', help='split into raw column files')
+    p.add_argument('log')
+    p.add_argument('outdir')
+
+    p = sub.add_parser('hist', help='log2 histogram of sample values')
+    p.add_argument('log')
+
+    p = sub.add_parser('info', help='show the log header')
+    p.add_argument('log')
+
+    return parser.parse_args()
+
+
+def main():
+    args = parse_args()
+
+    try:
+        log = BinLog(args.log)
+    except (IOError, OSError, ValueError) as e:
+        sys.stderr.write('%s\n' % e)
+        return 1
+
+    if args.cmd == 'csv':
+        to_csv(log, sys.stdout)
+    elif args.cmd == 'columns':
+        to_columns(log, args.outdir)
+    elif args.cmd == 'hist':
+        to_hist(log, sys.stdout)
+    else:
+        print('type=%s samples=%d offset=%d prio=%d' %
+              (LOG_TYPES.get(log.log_type, log.log_type), log.nr_samples,
+               (log.flags & F_OFFSET) != 0, (log.flags & F_PRIO) != 0))
+
+    log.close()
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except BrokenPipeError:
+        sys.exit(0)
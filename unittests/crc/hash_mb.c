@@ -0,0 +1,118 @@
+#include <string.h>
+#include "../../compiler/compiler.h"
+#include "../../crc/md5.h"
+#include "../../crc/sha256.h"
+#include "../../crc/hash-mb.h"
+#include "../unittest.h"
+
+#define BUF_LEN		4096
+
+/*
+ * Whole blocks only, a partial tail, and a short buffer the multi-buffer
+ * code leaves entirely to the scalar tail
+ */
+static const unsigned int lens[] = { BUF_LEN, 1000, 60 };
+
+static uint8_t bufs[FIO_HASH_MB_MAX_LANES][BUF_LEN];
+
+static void fill_bufs(void)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < FIO_HASH_MB_MAX_LANES; i++)
+		for (j = 0; j < BUF_LEN; j++)
+			bufs[i][j] = (i + 1) * 251 + j * 17 + (j >> 8);
+}
+
+static void test_md5_mb(void)
+{
+	uint32_t mb[FIO_HASH_MB_MAX_LANES][MD5_HASH_WORDS];
+	uint32_t single[MD5_HASH_WORDS];
+	struct fio_md5_ctx ctx[FIO_HASH_MB_MAX_LANES];
+	struct fio_md5_ctx *ctxp[FIO_HASH_MB_MAX_LANES];
+	const uint8_t *data[FIO_HASH_MB_MAX_LANES];
+	struct fio_md5_ctx sctx;
+	unsigned int nr, i, l;
+
+	fill_bufs();
+
+	for (l = 0; l < FIO_ARRAY_SIZE(lens); l++) {
+		for (nr = 1; nr <= FIO_HASH_MB_MAX_LANES; nr++) {
+			for (i = 0; i < nr; i++) {
+				ctx[i] = (struct fio_md5_ctx) { .hash = mb[i], };
+				fio_md5_init(&ctx[i]);
+				ctxp[i] = &ctx[i];
+				data[i] = bufs[i];
+			}
+			fio_md5_update_mb(ctxp, data, lens[l], nr);
+
+			for (i = 0; i < nr; i++) {
+				fio_md5_final(ctxp[i]);
+
+				sctx = (struct fio_md5_ctx) { .hash = single, };
+				fio_md5_init(&sctx);
+				fio_md5_update(&sctx, bufs[i], lens[l]);
+				fio_md5_final(&sctx);
+
+				CU_ASSERT_EQUAL(memcmp(mb[i], single,
+						       sizeof(single)), 0);
+			}
+		}
+	}
+}
+
+static void test_sha256_mb(void)
+{
+	uint8_t mb[FIO_HASH_MB_MAX_LANES][64];
+	uint8_t single[64];
+	struct fio_sha256_ctx ctx[FIO_HASH_MB_MAX_LANES];
+	struct fio_sha256_ctx *ctxp[FIO_HASH_MB_MAX_LANES];
+	const uint8_t *data[FIO_HASH_MB_MAX_LANES];
+	struct fio_sha256_ctx sctx;
+	unsigned int nr, i, l;
+
+	fill_bufs();
+
+	for (l = 0; l < FIO_ARRAY_SIZE(lens); l++) {
+		for (nr = 1; nr <= FIO_HASH_MB_MAX_LANES; nr++) {
+			for (i = 0; i < nr; i++) {
+				ctx[i] = (struct fio_sha256_ctx) { .buf = mb[i], };
+				fio_sha256_init(&ctx[i]);
+				ctxp[i] = &ctx[i];
+				data[i] = bufs[i];
+			}
+			fio_sha256_update_mb(ctxp, data, lens[l], nr);
+
+			for (i = 0; i < nr; i++) {
+				fio_sha256_final(ctxp[i]);
+
+				sctx = (struct fio_sha256_ctx) { .buf = single, };
+				fio_sha256_init(&sctx);
+				fio_sha256_update(&sctx, bufs[i], lens[l]);
+				fio_sha256_final(&sctx);
+
+				CU_ASSERT_EQUAL(memcmp(mb[i], single,
+						       SHA256_DIGEST_SIZE), 0);
+			}
+		}
+	}
+}
+
+static struct fio_unittest_entry tests[] = {
+	{
+		.name	= "hash_mb/md5",
+		.fn	= test_md5_mb,
+	},
+	{
+		.name	= "hash_mb/sha256",
+		.fn	= test_sha256_mb,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+CU_ErrorCode fio_unittest_crc_hash_mb(void)
+{
+	return fio_unittest_add_suite("crc/hash-mb.c", NULL, NULL, tests);
+}
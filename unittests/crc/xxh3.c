@@ -0,0 +1,65 @@
+#include "../../compiler/compiler.h"
+#include "../../crc/xxh3.h"
+#include "../unittest.h"
+
+#define BUF_LEN		65549
+
+/*
+ * XXH3_64bits() of the first 'len' bytes of the buffer filled by
+ * fill_buf(), from the reference xxHash implementation. The lengths
+ * cover each input size class and the vectorized long input path.
+ */
+static const struct {
+	size_t len;
+	uint64_t hash;
+} vectors[] = {
+	{ 0,		0x2d06800538d394c2ULL },
+	{ 3,		0x6e3e2670e61106acULL },
+	{ 8,		0xf9fd4dd0b04d78f5ULL },
+	{ 16,		0x86abf6baccea0858ULL },
+	{ 17,		0xb58bf5dc5022d071ULL },
+	{ 128,		0x10d17f72c0ccba41ULL },
+	{ 129,		0x1648bdc3db49d1a2ULL },
+	{ 240,		0xb6cfaf343fab81e6ULL },
+	{ 241,		0x956cae592c67279eULL },
+	{ 1024,		0x70bd377d9574f4bbULL },
+	{ 4096,		0x9ddd66c14af0daffULL },
+	{ BUF_LEN,	0xae416f79588dd414ULL },
+};
+
+static uint8_t buf[BUF_LEN];
+
+static void fill_buf(void)
+{
+	size_t i;
+
+	for (i = 0; i < BUF_LEN; i++)
+		buf[i] = i * 131 + 7;
+}
+
+static void test_xxh3_vectors(void)
+{
+	int i;
+
+	fill_buf();
+	xxh3_probe();
+
+	for (i = 0; i < FIO_ARRAY_SIZE(vectors); i++)
+		CU_ASSERT_EQUAL(fio_xxh3_64(buf, vectors[i].len),
+				vectors[i].hash);
+}
+
+static struct fio_unittest_entry tests[] = {
+	{
+		.name	= "xxh3/vectors",
+		.fn	= test_xxh3_vectors,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+CU_ErrorCode fio_unittest_crc_xxh3(void)
+{
+	return fio_unittest_add_suite("crc/xxh3.c", NULL, NULL, tests);
+}
@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include "../../compiler/compiler.h"
+#include "../../lib/feistel.h"
+#include "../unittest.h"
+
+/*
+ * Sizes that are and aren't a power of two, so some need cycle walking
+ * to stay below nr
+ */
+static const uint64_t sizes[] = { 1, 2, 3, 5, 16, 17, 1000, 4096, 65537 };
+static const uint64_t seeds[] = { 0, 1, 0x9e3779b97f4a7c15ULL };
+
+static void test_feistel_permutation(void)
+{
+	struct fio_feistel fp;
+	uint8_t *seen;
+	uint64_t off, n;
+	int i, j, dups;
+
+	for (i = 0; i < FIO_ARRAY_SIZE(sizes); i++) {
+		for (j = 0; j < FIO_ARRAY_SIZE(seeds); j++) {
+			CU_ASSERT_EQUAL(feistel_init(&fp, sizes[i], seeds[j]), 0);
+			seen = calloc(sizes[i], 1);
+			dups = 0;
+			for (n = 0; !feistel_next(&fp, &off); n++) {
+				CU_ASSERT_FATAL(off < sizes[i]);
+				dups += seen[off];
+				seen[off] = 1;
+			}
+			CU_ASSERT_EQUAL(n, sizes[i]);
+			CU_ASSERT_EQUAL(dups, 0);
+			free(seen);
+		}
+	}
+}
+
+static void test_feistel_cycle_walk(void)
+{
+	struct fio_feistel fp;
+	uint64_t idx, val;
+
+	/* 1000 blocks use a 1024 entry domain, values past nr get walked */
+	feistel_init(&fp, 1000, 1);
+	for (idx = 0; idx < 1000; idx++) {
+		val = feistel_map(&fp, idx);
+		CU_ASSERT(val < 1000);
+	}
+}
+
+static void test_feistel_map_next(void)
+{
+	struct fio_feistel fp;
+	uint64_t off, idx;
+
+	feistel_init(&fp, 4097, 7);
+	for (idx = 0; !feistel_next(&fp, &off); idx++)
+		CU_ASSERT_EQUAL(off, feistel_map(&fp, idx));
+}
+
+static void test_feistel_reset(void)
+{
+	struct fio_feistel fp;
+	uint64_t first[64], off;
+	int i;
+
+	feistel_init(&fp, 1000, 42);
+	for (i = 0; i < FIO_ARRAY_SIZE(first); i++)
+		feistel_next(&fp, &first[i]);
+
+	feistel_reset(&fp, 42);
+	for (i = 0; i < FIO_ARRAY_SIZE(first); i++) {
+		feistel_next(&fp, &off);
+		CU_ASSERT_EQUAL(off, first[i]);
+	}
+}
+
+static void test_feistel_empty(void)
+{
+	struct fio_feistel fp;
+
+	CU_ASSERT_NOT_EQUAL(feistel_init(&fp, 0, 0), 0);
+}
+
+static struct fio_unittest_entry tests[] = {
+	{
+		.name	= "feistel/permutation",
+		.fn	= test_feistel_permutation,
+	},
+	{
+		.name	= "feistel/cycle_walk",
+		.fn	= test_feistel_cycle_walk,
+	},
+	{
+		.name	= "feistel/map_next",
+		.fn	= test_feistel_map_next,
+	},
+	{
+		.name	= "feistel/reset",
+		.fn	= test_feistel_reset,
+	},
+	{
+		.name	= "feistel/empty",
+		.fn	= test_feistel_empty,
+	},
+	{
+		.name	= NULL,
+	},
+};
+
+CU_ErrorCode fio_unittest_lib_feistel(void)
+{
+	return fio_unittest_add_suite("lib/feistel.c", NULL, NULL, tests);
+}
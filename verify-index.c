@@ -0,0 +1,453 @@
+/*
+ * Compact index of written blocks, for verify
+ *
+ * For jobs that write fixed size, block aligned units, the verify list
+ * doesn't need an io_piece per written block. Instead, each file gets a
+ * bitmap with one bit per block, set when a write to that block is
+ * logged. Overwriting a block just sets its bit again, which gives the
+ * same result as the rbtree dropping the overlapped io_piece. The verify
+ * phase then walks the bitmaps in offset order.
+ *
+ * The expected numberio of a block is kept as runs of sequential writes,
+ * where each block in a run got the numberio of the one before it plus
+ * one. Newer runs take precedence over older ones. Sequential writers
+ * only need a run per pass over the file. If the writes don't compress
+ * to VINDEX_MAX_RUNS runs, like with random writes, the runs are
+ * expanded into a numberio per block, and each write stores its own.
+ *
+ * Jobs that need the write order or the exact size of each write, like
+ * verify_backlog, trims, read/write mixes or verify_state_load, keep
+ * using io_pieces. So does any write that doesn't fit the index, in
+ * which case the index drops the blocks it overlaps.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "fio.h"
+#include "verify.h"
+#include "lib/ffz.h"
+#include "lib/hweight.h"
+
+#define VINDEX_BITS		64
+
+struct vindex_file {
+	uint64_t *map;
+	uint64_t nr_blocks;
+
+	/* numberio of each block, once the runs overflowed */
+	unsigned short *numberio;
+};
+
+struct vindex_run {
+	uint64_t block;
+	uint64_t nr;
+	unsigned int fileno;
+	unsigned short numberio;
+};
+
+struct verify_index {
+	unsigned long long bs;
+
+	struct vindex_file *files;
+	unsigned int nr_files;
+
+	struct vindex_run runs[VINDEX_MAX_RUNS];
+	unsigned int nr_runs;
+	bool per_block;
+	bool numberio_lost;
+
+	/*
+	 * Verify phase position
+	 */
+	unsigned int cur_file;
+	uint64_t cur_word;
+};
+
+static uint64_t map_words(struct vindex_file *vf)
+{
+	return (vf->nr_blocks + VINDEX_BITS - 1) / VINDEX_BITS;
+}
+
+static bool alloc_numberio(struct verify_index *vi, struct vindex_file *vf)
+{
+	vf->numberio = calloc(vf->nr_blocks, sizeof(unsigned short));
+	if (vf->numberio)
+		return true;
+
+	log_info("fio: verify index out of memory, not checking numberio\n");
+	vi->numberio_lost = true;
+	return false;
+}
+
+static struct vindex_file *get_vindex_file(struct verify_index *vi,
+					   struct fio_file *f)
+{
+	struct vindex_file *vf;
+
+	if (f->fileno >= vi->nr_files) {
+		unsigned int nr = f->fileno + 1;
+
+		vf = realloc(vi->files, nr * sizeof(*vf));
+		if (!vf)
+			return NULL;
+
+		memset(&vf[vi->nr_files], 0,
+			(nr - vi->nr_files) * sizeof(*vf));
+		vi->files = vf;
+		vi->nr_files = nr;
+	}
+
+	vf = &vi->files[f->fileno];
+	if (!vf->map) {
+		vf->nr_blocks = f->io_size / vi->bs;
+		if (!vf->nr_blocks)
+			return NULL;
+
+		vf->map = calloc(map_words(vf), sizeof(uint64_t));
+		if (!vf->map) {
+			dprint(FD_VERIFY, "vindex: no memory for %s map\n",
+						f->file_name);
+			return NULL;
+		}
+		if (vi->per_block && !vi->numberio_lost)
+			alloc_numberio(vi, vf);
+	}
+
+	return vf;
+}
+
+/*
+ * Return the block index of a write, or -1ULL if it doesn't fit the index
+ */
+static uint64_t io_u_block(struct verify_index *vi, struct io_u *io_u)
+{
+	struct fio_file *f = io_u->file;
+	uint64_t off;
+
+	if (io_u->buflen != vi->bs || io_u->verify_offset < f->file_offset)
+		return -1ULL;
+
+	off = io_u->verify_offset - f->file_offset;
+	if (off % vi->bs)
+		return -1ULL;
+
+	return off / vi->bs;
+}
+
+/*
+ * Out of runs, switch to a numberio per block. The runs cover every block
+ * logged so far, replay them oldest first so newer ones win.
+ */
+static void expand_runs(struct verify_index *vi)
+{
+	unsigned int i;
+	uint64_t j;
+
+	dprint(FD_VERIFY, "vindex: out of runs, tracking numberio per block\n");
+	vi->per_block = true;
+
+	for (i = 0; i < vi->nr_files; i++) {
+		if (vi->files[i].map && !alloc_numberio(vi, &vi->files[i]))
+			return;
+	}
+
+	for (i = 0; i < vi->nr_runs; i++) {
+		struct vindex_run *r = &vi->runs[i];
+		struct vindex_file *vf = &vi->files[r->fileno];
+
+		for (j = 0; j < r->nr; j++)
+			vf->numberio[r->block + j] = r->numberio + j;
+	}
+
+	vi->nr_runs = 0;
+}
+
+static void log_run(struct verify_index *vi, unsigned int fileno,
+		    uint64_t block, unsigned short numberio)
+{
+	struct vindex_run *r;
+
+	if (vi->numberio_lost)
+		return;
+	if (vi->per_block) {
+		vi->files[fileno].numberio[block] = numberio;
+		return;
+	}
+
+	if (vi->nr_runs) {
+		r = &vi->runs[vi->nr_runs - 1];
+		if (r->fileno == fileno && r->block + r->nr == block &&
+		    (unsigned short) (r->numberio + r->nr) == numberio) {
+			r->nr++;
+			return;
+		}
+	}
+
+	if (vi->nr_runs == VINDEX_MAX_RUNS) {
+		expand_runs(vi);
+		log_run(vi, fileno, block, numberio);
+		return;
+	}
+
+	r = &vi->runs[vi->nr_runs++];
+	r->block = block;
+	r->nr = 1;
+	r->fileno = fileno;
+	r->numberio = numberio;
+}
+
+static bool lookup_numberio(struct verify_index *vi, unsigned int fileno,
+			    uint64_t block, unsigned short *numberio)
+{
+	int i;
+
+	if (vi->numberio_lost)
+		return false;
+	if (vi->per_block) {
+		*numberio = vi->files[fileno].numberio[block];
+		return true;
+	}
+
+	for (i = vi->nr_runs - 1; i >= 0; i--) {
+		struct vindex_run *r = &vi->runs[i];
+
+		if (r->fileno != fileno || block < r->block ||
+		    block >= r->block + r->nr)
+			continue;
+
+		*numberio = r->numberio + (block - r->block);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Log a write in the index. Returns false if the write doesn't fit, and
+ * the caller should log it as an io_piece instead.
+ */
+bool verify_index_log(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_index *vi = td->vindex;
+	struct vindex_file *vf;
+	uint64_t block, mask;
+
+	if (!vi)
+		return false;
+
+	block = io_u_block(vi, io_u);
+	if (block == -1ULL)
+		return false;
+
+	vf = get_vindex_file(vi, io_u->file);
+	if (!vf || block >= vf->nr_blocks)
+		return false;
+
+	mask = 1ULL << (block % VINDEX_BITS);
+	if (!(vf->map[block / VINDEX_BITS] & mask)) {
+		vf->map[block / VINDEX_BITS] |= mask;
+		td->io_hist_len++;
+	}
+
+	log_run(vi, io_u->file->fileno, block, io_u->numberio);
+	io_u_set(td, io_u, IO_U_F_VER_INDEX);
+	return true;
+}
+
+/*
+ * Drop a failed write from the index
+ */
+void verify_index_unlog(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_index *vi = td->vindex;
+	struct vindex_file *vf;
+	uint64_t block, mask;
+
+	if (!(io_u->flags & IO_U_F_VER_INDEX))
+		return;
+
+	io_u_clear(td, io_u, IO_U_F_VER_INDEX);
+	if (!vi)
+		return;
+
+	block = io_u_block(vi, io_u);
+	if (block == -1ULL || io_u->file->fileno >= vi->nr_files)
+		return;
+
+	vf = &vi->files[io_u->file->fileno];
+	if (!vf->map || block >= vf->nr_blocks)
+		return;
+
+	mask = 1ULL << (block % VINDEX_BITS);
+	if (vf->map[block / VINDEX_BITS] & mask) {
+		vf->map[block / VINDEX_BITS] &= ~mask;
+		td->io_hist_len--;
+	}
+}
+
+/*
+ * Drop indexed blocks overlapping a write that didn't fit the index
+ */
+void verify_index_drop(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_index *vi = td->vindex;
+	struct fio_file *f = io_u->file;
+	struct vindex_file *vf;
+	uint64_t start, end, block;
+
+	if (f->fileno >= vi->nr_files || !vi->files[f->fileno].map)
+		return;
+
+	vf = &vi->files[f->fileno];
+	if (io_u->offset + io_u->buflen <= f->file_offset)
+		return;
+
+	if (io_u->offset > f->file_offset)
+		start = (io_u->offset - f->file_offset) / vi->bs;
+	else
+		start = 0;
+	end = (io_u->offset + io_u->buflen - f->file_offset + vi->bs - 1) / vi->bs;
+	if (end > vf->nr_blocks)
+		end = vf->nr_blocks;
+
+	for (block = start; block < end; block++) {
+		uint64_t mask = 1ULL << (block % VINDEX_BITS);
+
+		if (vf->map[block / VINDEX_BITS] & mask) {
+			vf->map[block / VINDEX_BITS] &= ~mask;
+			td->io_hist_len--;
+		}
+	}
+}
+
+/*
+ * Fill in the next indexed block to verify. Returns false when all
+ * blocks have been handed out.
+ */
+bool verify_index_next(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_index *vi = td->vindex;
+
+	if (!vi)
+		return false;
+
+	for (; vi->cur_file < vi->nr_files; vi->cur_file++, vi->cur_word = 0) {
+		struct vindex_file *vf = &vi->files[vi->cur_file];
+		uint64_t nr_words = map_words(vf);
+
+		if (!vf->map)
+			continue;
+
+		for (; vi->cur_word < nr_words; vi->cur_word++) {
+			uint64_t *word = &vf->map[vi->cur_word];
+			struct fio_file *f;
+			uint64_t block;
+			int bit;
+
+			if (!*word)
+				continue;
+
+			bit = ffs64(*word);
+			*word &= ~(1ULL << bit);
+			td->io_hist_len--;
+
+			block = vi->cur_word * VINDEX_BITS + bit;
+			f = td->files[vi->cur_file];
+
+			io_u->file = f;
+			io_u->offset = f->file_offset + block * vi->bs;
+			io_u->verify_offset = io_u->offset;
+			io_u->buflen = vi->bs;
+			if (!lookup_numberio(vi, vi->cur_file, block,
+					     &io_u->numberio))
+				io_u_set(td, io_u, IO_U_F_VER_NONUM);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Clear the index, for a new pass of the job
+ */
+void verify_index_prune(struct thread_data *td)
+{
+	struct verify_index *vi = td->vindex;
+	unsigned int i;
+
+	if (!vi)
+		return;
+
+	for (i = 0; i < vi->nr_files; i++) {
+		struct vindex_file *vf = &vi->files[i];
+		uint64_t j;
+
+		free(vf->numberio);
+		vf->numberio = NULL;
+		if (!vf->map)
+			continue;
+
+		for (j = 0; j < map_words(vf); j++) {
+			if (!vf->map[j])
+				continue;
+
+			td->io_hist_len -= hweight64(vf->map[j]);
+			vf->map[j] = 0;
+		}
+	}
+
+	vi->nr_runs = 0;
+	vi->per_block = false;
+	vi->numberio_lost = false;
+	vi->cur_file = 0;
+	vi->cur_word = 0;
+}
+
+/*
+ * Use the index if the job's verify list can do without io_pieces
+ */
+void verify_index_init(struct thread_data *td)
+{
+	struct thread_options *o = &td->o;
+	struct verify_index *vi;
+
+	if (!td_write(td) || !o->do_verify || o->verify == VERIFY_NONE ||
+	    o->experimental_verify)
+		return;
+	if (td_rw(td) || o->verify_backlog || o->trim_percentage ||
+	    o->trim_backlog || o->verify_state || o->read_iolog_file ||
+	    o->zone_mode == ZONE_MODE_ZBD ||
+	    o->io_submit_mode == IO_MODE_OFFLOAD)
+		return;
+	if (o->min_bs[DDIR_WRITE] != o->max_bs[DDIR_WRITE] ||
+	    o->bssplit_nr[DDIR_WRITE] ||
+	    o->ba[DDIR_WRITE] % o->min_bs[DDIR_WRITE])
+		return;
+
+	vi = calloc(1, sizeof(*vi));
+	if (!vi)
+		return;
+
+	vi->bs = o->min_bs[DDIR_WRITE];
+	td->vindex = vi;
+	dprint(FD_VERIFY, "vindex: using block index, bs=%llu\n", vi->bs);
+}
+
+void verify_index_exit(struct thread_data *td)
+{
+	struct verify_index *vi = td->vindex;
+	unsigned int i;
+
+	if (!vi)
+		return;
+
+	for (i = 0; i < vi->nr_files; i++) {
+		free(vi->files[i].map);
+		free(vi->files[i].numberio);
+	}
+
+	free(vi->files);
+	free(vi);
+	td->vindex = NULL;
+}
@@ -0,0 +1,23 @@
+#ifndef FIO_VERIFY_INDEX_H
+#define FIO_VERIFY_INDEX_H
+
+#include <stdbool.h>
+
+struct thread_data;
+struct io_u;
+
+/*
+ * Max number of sequential numberio runs tracked, before switching to a
+ * numberio per indexed block
+ */
+#define VINDEX_MAX_RUNS		64
+
+extern void verify_index_init(struct thread_data *);
+extern void verify_index_exit(struct thread_data *);
+extern void verify_index_prune(struct thread_data *);
+extern bool verify_index_log(struct thread_data *, struct io_u *);
+extern void verify_index_unlog(struct thread_data *, struct io_u *);
+extern void verify_index_drop(struct thread_data *, struct io_u *);
+extern bool verify_index_next(struct thread_data *, struct io_u *);
+
+#endif
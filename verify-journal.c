@@ -0,0 +1,367 @@
+/*
+ * Journal of completed writes, for verify_state_journal
+ *
+ * A writing job appends a record for each completed write to
+ * <prefix>-<jobname>-<index>-verify.journal. Records are collected in
+ * batches, and each batch goes to a new page of the journal, written
+ * with O_DIRECT and O_DSYNC by a helper worker, so the job doesn't wait
+ * for it on the completion path. A write found in the journal is thus
+ * known to have completed before a crash, without syncing every write. Pages
+ * carry a sequence number and a crc32c, and loading stops at the first
+ * page that doesn't check out, such as one torn by the crash.
+ *
+ * With verify_state_load, the verify phase then only checks blocks that
+ * are in the journal.
+ */
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "fio.h"
+#include "verify.h"
+#include "workqueue.h"
+#include "crc/crc32c.h"
+
+/*
+ * Pages in flight to the helper, the job fills the next one meanwhile
+ */
+#define VJOURNAL_NR_PAGES	4
+
+struct vjournal_page {
+	struct workqueue_work work;
+	struct vjournal_page_hdr *hdr;
+	uint64_t seq;
+	bool busy;
+};
+
+struct verify_journal {
+	int fd;
+	unsigned int batch;
+	uint64_t seq;
+	struct vjournal_page_hdr *page;
+
+	struct workqueue wq;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool waiting;
+	int error;
+	unsigned int cur;
+	void *mem;
+	struct vjournal_page pages[VJOURNAL_NR_PAGES];
+
+	/*
+	 * Loaded journal, sorted by file and offset
+	 */
+	struct vjournal_rec *recs;
+	size_t nr_recs;
+};
+
+static struct vjournal_rec *page_recs(struct vjournal_page_hdr *page)
+{
+	return (struct vjournal_rec *) (page + 1);
+}
+
+static void journal_name(struct thread_data *td, const char *prefix,
+			 char *out, size_t size)
+{
+	__verify_state_gen_name(out, size, td->o.name, prefix,
+				td->thread_number - 1, "journal");
+}
+
+static void local_prefix(char *prefix)
+{
+	if (aux_path)
+		sprintf(prefix, "%s%clocal", aux_path, FIO_OS_PATH_SEPARATOR);
+	else
+		strcpy(prefix, "local");
+}
+
+static int journal_work_fn(struct submit_worker *sw,
+			   struct workqueue_work *work)
+{
+	struct verify_journal *j = sw->wq->td->vjournal;
+	struct vjournal_page *jp;
+	ssize_t ret;
+
+	jp = container_of(work, struct vjournal_page, work);
+	ret = pwrite(j->fd, jp->hdr, VJOURNAL_PAGE_SIZE,
+			jp->seq * VJOURNAL_PAGE_SIZE);
+	memset(jp->hdr, 0, VJOURNAL_PAGE_SIZE);
+
+	pthread_mutex_lock(&j->lock);
+	if (ret != VJOURNAL_PAGE_SIZE && !j->error)
+		j->error = ret < 0 ? errno : EIO;
+	jp->busy = false;
+	if (j->waiting)
+		pthread_cond_signal(&j->cond);
+	pthread_mutex_unlock(&j->lock);
+	return 0;
+}
+
+static struct workqueue_ops journal_wq_ops = {
+	.fn	= journal_work_fn,
+};
+
+static int journal_error(struct thread_data *td, struct verify_journal *j)
+{
+	int error;
+
+	pthread_mutex_lock(&j->lock);
+	error = j->error;
+	j->error = 0;
+	pthread_mutex_unlock(&j->lock);
+
+	if (error)
+		td_verror(td, error, "write verify journal");
+	return error != 0;
+}
+
+/*
+ * Hand the current page to the helper, and wait for the next one in the
+ * ring to be written out if it hasn't been yet.
+ */
+static int journal_flush(struct thread_data *td, struct verify_journal *j)
+{
+	struct vjournal_page *jp = &j->pages[j->cur];
+	struct vjournal_page_hdr *page = j->page;
+
+	if (!page->nr)
+		return 0;
+
+	page->magic = cpu_to_le32(VJOURNAL_MAGIC);
+	page->version = cpu_to_le16((uint16_t) VJOURNAL_VERSION);
+	page->nr = cpu_to_le16(page->nr);
+	page->seq = cpu_to_le64(j->seq);
+	page->crc = 0;
+	page->crc = cpu_to_le32(fio_crc32c((void *) page, VJOURNAL_PAGE_SIZE));
+
+	jp->seq = j->seq++;
+	jp->busy = true;
+	workqueue_enqueue(&j->wq, &jp->work);
+
+	if (++j->cur == VJOURNAL_NR_PAGES)
+		j->cur = 0;
+	jp = &j->pages[j->cur];
+
+	pthread_mutex_lock(&j->lock);
+	while (jp->busy) {
+		j->waiting = true;
+		pthread_cond_wait(&j->cond, &j->lock);
+	}
+	j->waiting = false;
+	pthread_mutex_unlock(&j->lock);
+
+	j->page = jp->hdr;
+	return journal_error(td, j);
+}
+
+/*
+ * Record a completed write, flushing the batch once it is full
+ */
+void verify_journal_add(struct thread_data *td, struct fio_file *f,
+			uint64_t offset, unsigned long long len)
+{
+	struct verify_journal *j = td->vjournal;
+	struct vjournal_rec *rec;
+
+	if (!j || j->fd == -1 || !f)
+		return;
+
+	rec = &page_recs(j->page)[j->page->nr++];
+	rec->offset = cpu_to_le64(offset);
+	rec->len = cpu_to_le32((uint32_t) len);
+	rec->fileno = cpu_to_le32((uint32_t) f->fileno);
+
+	if (j->page->nr == j->batch)
+		journal_flush(td, j);
+}
+
+static void journal_free(struct verify_journal *j)
+{
+	if (j->mem)
+		fio_memfree(j->mem, VJOURNAL_NR_PAGES * VJOURNAL_PAGE_SIZE,
+				false);
+	free(j->recs);
+	free(j);
+}
+
+int verify_journal_init(struct thread_data *td, struct sk_out *sk_out)
+{
+	struct thread_options *o = &td->o;
+	struct verify_journal *j;
+	char prefix[PATH_MAX];
+	char name[PATH_MAX];
+	int flags, i;
+
+	if (!o->verify_state_journal || o->verify == VERIFY_NONE ||
+	    !td_write(td) || o->verify_only || o->verify_state || td->vjournal)
+		return 0;
+
+	j = calloc(1, sizeof(*j));
+	j->batch = o->verify_state_journal;
+	j->mem = fio_memalign(page_size, VJOURNAL_NR_PAGES * VJOURNAL_PAGE_SIZE,
+				false);
+	if (!j->mem) {
+		free(j);
+		log_err("fio: failed to allocate verify journal\n");
+		return 1;
+	}
+	memset(j->mem, 0, VJOURNAL_NR_PAGES * VJOURNAL_PAGE_SIZE);
+	for (i = 0; i < VJOURNAL_NR_PAGES; i++)
+		j->pages[i].hdr = j->mem + i * VJOURNAL_PAGE_SIZE;
+	j->page = j->pages[0].hdr;
+
+	local_prefix(prefix);
+	journal_name(td, prefix, name, sizeof(name));
+
+	flags = O_CREAT | O_TRUNC | O_WRONLY | O_DSYNC;
+	j->fd = open(name, flags | OS_O_DIRECT, 0644);
+	if (j->fd == -1 && errno == EINVAL) {
+		dprint(FD_VERIFY, "journal %s: no O_DIRECT\n", name);
+		j->fd = open(name, flags, 0644);
+	}
+	if (j->fd == -1) {
+		td_verror(td, errno, "open verify journal");
+		log_err("fio: verify journal: %s\n", name);
+		journal_free(j);
+		return 1;
+	}
+
+	pthread_mutex_init(&j->lock, NULL);
+	pthread_cond_init(&j->cond, NULL);
+
+	/* the worker finds the journal through the td */
+	td->vjournal = j;
+	if (workqueue_init(td, &j->wq, &journal_wq_ops, 1, sk_out)) {
+		td->vjournal = NULL;
+		pthread_cond_destroy(&j->cond);
+		pthread_mutex_destroy(&j->lock);
+		close(j->fd);
+		journal_free(j);
+		log_err("fio: failed to start verify journal worker\n");
+		return 1;
+	}
+
+	dprint(FD_VERIFY, "journal %s: batches of %u\n", name, j->batch);
+	return 0;
+}
+
+void verify_journal_exit(struct thread_data *td)
+{
+	struct verify_journal *j = td->vjournal;
+
+	if (!j)
+		return;
+
+	if (j->fd != -1) {
+		/* a clean exit writes out the last, partial batch too */
+		journal_flush(td, j);
+		workqueue_exit(&j->wq);
+		journal_error(td, j);
+		pthread_cond_destroy(&j->cond);
+		pthread_mutex_destroy(&j->lock);
+		close(j->fd);
+	}
+	journal_free(j);
+	td->vjournal = NULL;
+}
+
+static int rec_cmp(const void *p1, const void *p2)
+{
+	const struct vjournal_rec *r1 = p1, *r2 = p2;
+
+	if (r1->fileno != r2->fileno)
+		return r1->fileno < r2->fileno ? -1 : 1;
+	if (r1->offset != r2->offset)
+		return r1->offset < r2->offset ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Read the journal of a previous run of this job, if there is one. Pages
+ * are read until the first one that is missing or doesn't validate.
+ */
+int verify_journal_load(struct thread_data *td, const char *prefix)
+{
+	struct vjournal_page_hdr *page;
+	struct verify_journal *j;
+	char name[PATH_MAX];
+	size_t alloced = 0;
+	uint32_t crc;
+	int fd, i;
+
+	if (!td->o.verify_state_journal)
+		return 0;
+
+	journal_name(td, prefix, name, sizeof(name));
+	fd = open(name, O_RDONLY);
+	if (fd == -1) {
+		td_verror(td, errno, "open verify journal");
+		log_err("fio: verify journal: %s\n", name);
+		return 1;
+	}
+
+	page = malloc(VJOURNAL_PAGE_SIZE);
+	j = calloc(1, sizeof(*j));
+	j->fd = -1;
+
+	while (pread(fd, page, VJOURNAL_PAGE_SIZE, j->seq * VJOURNAL_PAGE_SIZE) ==
+			VJOURNAL_PAGE_SIZE) {
+		struct vjournal_rec *rec = page_recs(page);
+		unsigned int nr = le16_to_cpu(page->nr);
+
+		if (le32_to_cpu(page->magic) != VJOURNAL_MAGIC ||
+		    le16_to_cpu(page->version) != VJOURNAL_VERSION ||
+		    le64_to_cpu(page->seq) != j->seq || nr > VJOURNAL_MAX_RECS)
+			break;
+
+		crc = le32_to_cpu(page->crc);
+		page->crc = 0;
+		if (fio_crc32c((void *) page, VJOURNAL_PAGE_SIZE) != crc) {
+			log_info("fio: verify journal page %llu is corrupt\n",
+					(unsigned long long) j->seq);
+			break;
+		}
+
+		if (j->nr_recs + nr > alloced) {
+			alloced = max(2 * alloced, j->nr_recs + nr);
+			j->recs = realloc(j->recs, alloced * sizeof(*rec));
+		}
+
+		for (i = 0; i < nr; i++) {
+			struct vjournal_rec *r = &j->recs[j->nr_recs++];
+
+			r->offset = le64_to_cpu(rec[i].offset);
+			r->len = le32_to_cpu(rec[i].len);
+			r->fileno = le32_to_cpu(rec[i].fileno);
+		}
+		j->seq++;
+	}
+
+	free(page);
+	close(fd);
+
+	if (j->nr_recs)
+		qsort(j->recs, j->nr_recs, sizeof(*j->recs), rec_cmp);
+
+	dprint(FD_VERIFY, "journal %s: %llu pages, %zu writes\n", name,
+			(unsigned long long) j->seq, j->nr_recs);
+	td->vjournal = j;
+	return 0;
+}
+
+/*
+ * With a loaded journal, only blocks whose write made it to the journal
+ * are verified.
+ */
+bool verify_journal_skip(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_journal *j = td->vjournal;
+	struct vjournal_rec key;
+
+	if (!j || j->fd != -1 || !io_u->file)
+		return false;
+
+	key.fileno = io_u->file->fileno;
+	key.offset = io_u->verify_offset;
+	return !bsearch(&key, j->recs, j->nr_recs, sizeof(key), rec_cmp);
+}
@@ -1,6 +1,7 @@
 #ifndef FIO_VERIFY_STATE_H
 #define FIO_VERIFY_STATE_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include <limits.h>
@@ -56,7 +57,37 @@ struct verify_state_hdr {
 
 #define IO_LIST_ALL		0xffffffff
 
+/*
+ * Journal of completed writes. Each page holds a header and up to
+ * VJOURNAL_MAX_RECS records, and is only ever written once.
+ */
+#define VJOURNAL_MAGIC		0x6e726a76U
+#define VJOURNAL_VERSION	1
+#define VJOURNAL_PAGE_SIZE	4096
+
+struct vjournal_rec {
+	uint64_t offset;
+	uint32_t len;
+	uint32_t fileno;
+};
+
+struct vjournal_page_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t nr;
+	uint64_t seq;
+	uint32_t crc;
+	uint32_t pad;
+	uint64_t pad2;
+};
+
+#define VJOURNAL_MAX_RECS	\
+	((VJOURNAL_PAGE_SIZE - sizeof(struct vjournal_page_hdr)) / \
+		sizeof(struct vjournal_rec))
+
 struct io_u;
+struct fio_file;
+struct sk_out;
 extern struct all_io_list *get_all_io_list(int, size_t *);
 extern void __verify_save_state(struct all_io_list *, const char *);
 extern void verify_save_state(int mask);
@@ -66,6 +97,13 @@ extern int verify_state_should_stop(struct thread_data *, struct io_u *);
 extern void verify_assign_state(struct thread_data *, void *);
 extern int verify_state_hdr(struct verify_state_hdr *, struct thread_io_list *);
 
+extern int verify_journal_init(struct thread_data *, struct sk_out *);
+extern void verify_journal_add(struct thread_data *, struct fio_file *,
+			       uint64_t, unsigned long long);
+extern void verify_journal_exit(struct thread_data *);
+extern int verify_journal_load(struct thread_data *, const char *);
+extern bool verify_journal_skip(struct thread_data *, struct io_u *);
+
 static inline size_t __thread_io_list_sz(uint32_t depth, uint32_t nofiles)
 {
 	return sizeof(struct thread_io_list) + depth * nofiles * sizeof(struct file_comp);
@@ -81,9 +119,9 @@ static inline struct thread_io_list *io_list_next(struct thread_io_list *s)
 	return (struct thread_io_list *)((char *) s + thread_io_list_sz(s));
 }
 
-static inline void verify_state_gen_name(char *out, size_t size,
-					 const char *name, const char *prefix,
-					 int num)
+static inline void __verify_state_gen_name(char *out, size_t size,
+					   const char *name, const char *prefix,
+					   int num, const char *suffix)
 {
 	char ename[PATH_MAX];
 	char *ptr;
@@ -102,8 +140,16 @@ static inline void verify_state_gen_name(char *out, size_t size,
 		name++;
 	} while (1);
 
-	nowarn_snprintf(out, size, "%s-%s-%d-verify.state", prefix, ename, num);
+	nowarn_snprintf(out, size, "%s-%s-%d-verify.%s", prefix, ename, num,
+			suffix);
 	out[size - 1] = '\0';
 }
 
+static inline void verify_state_gen_name(char *out, size_t size,
+					 const char *name, const char *prefix,
+					 int num)
+{
+	__verify_state_gen_name(out, size, name, prefix, num, "state");
+}
+
 #endif
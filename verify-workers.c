@@ -0,0 +1,364 @@
+/*
+ * Verify phase spread over several threads, for verify_workers
+ *
+ * The job thread pulls the written blocks off its verify list, which is
+ * sorted by offset, and hands them out in batches of adjacent blocks.
+ * Each worker has its own copy of the job's files, its own ioengine
+ * instance and its own io_us, and runs the normal verify loop over a
+ * batch. Worker stats and error counts are summed into the job when the
+ * workers exit. The workers have no lat, bw or iops logs, so the verify
+ * reads they issue aren't logged.
+ */
+#include <assert.h>
+#include <pthread.h>
+
+#include "fio.h"
+#include "ioengines.h"
+#include "verify.h"
+#include "verify-workers.h"
+#include "lib/getrusage.h"
+
+#define VERIFY_BATCH_RANGES	256
+
+/*
+ * Batches queued per worker, before the job thread waits
+ */
+#define VERIFY_BATCH_DEPTH	2
+
+struct verify_range {
+	uint64_t offset;
+	uint64_t verify_offset;
+	unsigned long long len;
+	uint64_t rand_seed;
+	unsigned int fileno;
+	unsigned int flags;
+	unsigned short numberio;
+};
+
+struct verify_batch {
+	struct workqueue_work work;
+	struct thread_data *parent;
+	unsigned int nr;
+	unsigned int next;
+	struct verify_range ranges[VERIFY_BATCH_RANGES];
+};
+
+struct verify_pool {
+	struct workqueue wq;
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned int queued;
+	bool error;
+};
+
+/*
+ * get_next_verify() for a worker, hand out the next block of its batch
+ */
+int verify_batch_next(struct thread_data *td, struct io_u *io_u)
+{
+	struct verify_batch *batch = td->vbatch;
+	struct verify_range *r;
+	struct fio_file *f;
+
+	if (batch->next == batch->nr || td->error || batch->parent->terminate)
+		return 1;
+
+	r = &batch->ranges[batch->next++];
+	f = td->files[r->fileno];
+
+	if (!fio_file_open(f)) {
+		int ret = td_io_open_file(td, f);
+
+		if (ret) {
+			dprint(FD_VERIFY, "failed file %s open\n",
+					f->file_name);
+			return 1;
+		}
+	}
+
+	get_file(f);
+	io_u->file = f;
+	io_u->offset = r->offset;
+	io_u->verify_offset = r->verify_offset;
+	io_u->buflen = r->len;
+	io_u->numberio = r->numberio;
+	io_u->rand_seed = r->rand_seed;
+	io_u_set(td, io_u, IO_U_F_VER_LIST | r->flags);
+
+	io_u->ddir = DDIR_READ;
+	io_u->xfer_buf = io_u->buf;
+	io_u->xfer_buflen = io_u->buflen;
+	return 0;
+}
+
+/*
+ * Fill a batch from the job's verify list. Returns true if the list ran
+ * out.
+ */
+static bool fill_batch(struct thread_data *td, struct verify_batch *batch)
+{
+	struct io_u *io_u;
+
+	while (batch->nr < VERIFY_BATCH_RANGES) {
+		struct verify_range *r;
+
+		io_u = __get_io_u(td);
+		if (!io_u)
+			return true;
+
+		if (get_next_verify(td, io_u)) {
+			put_io_u(td, io_u);
+			return true;
+		}
+
+		if (!verify_journal_skip(td, io_u)) {
+			r = &batch->ranges[batch->nr++];
+			r->offset = io_u->offset;
+			r->verify_offset = io_u->verify_offset;
+			r->len = io_u->buflen;
+			r->rand_seed = io_u->rand_seed;
+			r->fileno = io_u->file->fileno;
+			r->numberio = io_u->numberio;
+			r->flags = io_u->flags &
+					(IO_U_F_TRIMMED | IO_U_F_VER_NONUM);
+		}
+
+		put_io_u(td, io_u);
+	}
+
+	return false;
+}
+
+void verify_pool_run(struct thread_data *td)
+{
+	struct verify_pool *vp = td->vpool;
+	struct verify_batch *batch;
+	bool done = false;
+	int i;
+
+	while (!done && !td->terminate) {
+		batch = malloc(sizeof(*batch));
+		if (!batch) {
+			td_verror(td, ENOMEM, "malloc verify batch");
+			break;
+		}
+		batch->parent = td;
+		batch->nr = batch->next = 0;
+
+		done = fill_batch(td, batch);
+		if (!batch->nr) {
+			free(batch);
+			break;
+		}
+
+		pthread_mutex_lock(&vp->lock);
+		while (vp->queued >= VERIFY_BATCH_DEPTH * vp->wq.max_workers &&
+		       !vp->error)
+			pthread_cond_wait(&vp->cond, &vp->lock);
+		if (vp->error) {
+			pthread_mutex_unlock(&vp->lock);
+			free(batch);
+			break;
+		}
+		vp->queued++;
+		pthread_mutex_unlock(&vp->lock);
+
+		workqueue_enqueue(&vp->wq, &batch->work);
+	}
+
+	workqueue_flush(&vp->wq);
+
+	/*
+	 * Pass the first worker error on to the job
+	 */
+	for (i = 0; i < vp->wq.max_workers; i++) {
+		struct thread_data *w = vp->wq.workers[i].priv;
+
+		if (!w->error || td->error)
+			continue;
+
+		td->error = w->error;
+		memcpy(td->verror, w->verror, sizeof(td->verror));
+	}
+}
+
+static int verify_pool_fn(struct submit_worker *sw,
+			  struct workqueue_work *work)
+{
+	struct verify_batch *batch = container_of(work, struct verify_batch, work);
+	struct verify_pool *vp = batch->parent->vpool;
+	struct thread_data *td = sw->priv;
+
+	dprint(FD_VERIFY, "batch of %u queued by %u\n", batch->nr, gettid());
+
+	td->vbatch = batch;
+	do_verify_io(td, 0);
+	td->vbatch = NULL;
+	free(batch);
+
+	pthread_mutex_lock(&vp->lock);
+	vp->queued--;
+	if (td->error)
+		vp->error = true;
+	pthread_cond_signal(&vp->cond);
+	pthread_mutex_unlock(&vp->lock);
+	return 0;
+}
+
+static int verify_pool_alloc_fn(struct submit_worker *sw)
+{
+	sw->priv = calloc(1, sizeof(struct thread_data));
+	return sw->priv == NULL;
+}
+
+static void verify_pool_free_fn(struct submit_worker *sw)
+{
+	free(sw->priv);
+	sw->priv = NULL;
+}
+
+static int verify_pool_init_worker_fn(struct submit_worker *sw)
+{
+	struct thread_data *parent = sw->wq->td;
+	struct thread_data *td = sw->priv;
+
+	memcpy(&td->o, &parent->o, sizeof(td->o));
+	memcpy(&td->ts, &parent->ts, sizeof(td->ts));
+	memcpy(td->rand_seeds, parent->rand_seeds, sizeof(td->rand_seeds));
+	td->o.uid = td->o.gid = -1U;
+	td->o.verify_async = 0;
+	td->o.verify_workers = 0;
+	td->o.verify_state_journal = 0;
+	dup_files(td, parent);
+	td->eo = parent->eo;
+	fio_options_mem_dupe(td);
+
+	if (ioengine_load(td))
+		goto err;
+
+	td->pid = gettid();
+	td->thread_number = parent->thread_number;
+
+	INIT_FLIST_HEAD(&td->io_log_list);
+	INIT_FLIST_HEAD(&td->io_hist_list);
+	INIT_FLIST_HEAD(&td->trim_list);
+	td->io_hist_tree = RB_ROOT;
+
+	if (td_io_init(td))
+		goto err_io_init;
+
+	td_fill_rand_seeds(td);
+	if (init_io_u(td))
+		goto err_io_u;
+
+	if (td->io_ops->post_init && td->io_ops->post_init(td))
+		goto err_io_u;
+
+	set_epoch_time(td, td->o.log_unix_epoch);
+	fio_getrusage(&td->ru_start);
+	clear_io_state(td, 1);
+
+	td_set_runstate(td, TD_RUNNING);
+	return 0;
+
+err_io_u:
+	cleanup_io_u(td);
+err_io_init:
+	close_ioengine(td);
+err:
+	return 1;
+}
+
+static void verify_pool_exit_worker_fn(struct submit_worker *sw,
+				       unsigned int *sum_cnt)
+{
+	struct thread_data *parent = sw->wq->td;
+	struct thread_data *td = sw->priv;
+
+	(*sum_cnt)++;
+	sum_thread_stats(&parent->ts, &td->ts, false);
+
+	/*
+	 * Errors ignored with continue_on_error are counted per thread, and
+	 * only added to the job stats when the job ends
+	 */
+	if (td->total_err_count && !parent->total_err_count)
+		parent->first_error = td->first_error;
+	parent->total_err_count += td->total_err_count;
+
+	if (td->io_ops)
+		cleanup_io_u(td);
+	fio_options_free(td);
+	close_and_free_files(td);
+	if (td->io_ops)
+		close_ioengine(td);
+	td_set_runstate(td, TD_EXITED);
+}
+
+static void verify_pool_update_acct_fn(struct submit_worker *sw)
+{
+	struct thread_data *src = sw->priv;
+	struct thread_data *dst = sw->wq->td;
+	uint64_t *s[] = { src->io_bytes, src->io_blocks, src->this_io_blocks,
+			  src->this_io_bytes, src->bytes_done };
+	uint64_t *d[] = { dst->io_bytes, dst->io_blocks, dst->this_io_blocks,
+			  dst->this_io_bytes, dst->bytes_done };
+	int i;
+
+	pthread_mutex_lock(&sw->wq->stat_lock);
+	for (i = 0; i < FIO_ARRAY_SIZE(s); i++) {
+		d[i][DDIR_READ] += s[i][DDIR_READ];
+		s[i][DDIR_READ] = 0;
+	}
+	pthread_mutex_unlock(&sw->wq->stat_lock);
+}
+
+static struct workqueue_ops verify_pool_ops = {
+	.fn			= verify_pool_fn,
+	.update_acct_fn		= verify_pool_update_acct_fn,
+	.alloc_worker_fn	= verify_pool_alloc_fn,
+	.free_worker_fn		= verify_pool_free_fn,
+	.init_worker_fn		= verify_pool_init_worker_fn,
+	.exit_worker_fn		= verify_pool_exit_worker_fn,
+};
+
+int verify_pool_init(struct thread_data *td, struct sk_out *sk_out)
+{
+	struct verify_pool *vp;
+
+	if (!td->o.verify_workers || !td->o.do_verify ||
+	    td->o.verify == VERIFY_NONE || !td_write(td))
+		return 0;
+
+	vp = calloc(1, sizeof(*vp));
+	if (!vp)
+		return 1;
+
+	pthread_mutex_init(&vp->lock, NULL);
+	pthread_cond_init(&vp->cond, NULL);
+
+	if (workqueue_init(td, &vp->wq, &verify_pool_ops, td->o.verify_workers,
+			   sk_out)) {
+		log_err("fio: failed to start verify workers\n");
+		free(vp);
+		return 1;
+	}
+
+	td->vpool = vp;
+	return 0;
+}
+
+void verify_pool_exit(struct thread_data *td)
+{
+	struct verify_pool *vp = td->vpool;
+
+	if (!vp)
+		return;
+
+	workqueue_exit(&vp->wq);
+	pthread_cond_destroy(&vp->cond);
+	pthread_mutex_destroy(&vp->lock);
+	free(vp);
+	td->vpool = NULL;
+}
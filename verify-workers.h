@@ -0,0 +1,13 @@
+#ifndef FIO_VERIFY_WORKERS_H
+#define FIO_VERIFY_WORKERS_H
+
+struct sk_out;
+struct thread_data;
+struct io_u;
+
+int verify_pool_init(struct thread_data *, struct sk_out *);
+void verify_pool_exit(struct thread_data *);
+void verify_pool_run(struct thread_data *);
+int verify_batch_next(struct thread_data *, struct io_u *);
+
+#endif
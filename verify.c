@@ -11,7 +11,9 @@
 #include "arch/arch.h"
 #include "fio.h"
 #include "verify.h"
+#include "verify-workers.h"
 #include "trim.h"
+#include "zbd.h"
 #include "lib/rand.h"
 #include "lib/hweight.h"
 #include "lib/pattern.h"
@@ -27,11 +29,18 @@
 #include "crc/sha512.h"
 #include "crc/sha1.h"
 #include "crc/xxhash.h"
+#include "crc/xxh3.h"
+#include "crc/sha-hw.h"
 #include "crc/sha3.h"
+#include "crc/hash-mb.h"
 
 static void populate_hdr(struct thread_data *td, struct io_u *io_u,
 			 struct verify_header *hdr, unsigned int header_num,
 			 unsigned int header_len);
+static bool verify_hash_mb(struct thread_data *td, struct io_u *io_u,
+			   unsigned int hdr_inc);
+static void populate_hdrs_mb(struct thread_data *td, struct io_u *io_u,
+			     unsigned int hdr_inc);
 static void __fill_hdr(struct thread_data *td, struct io_u *io_u,
 		       struct verify_header *hdr, unsigned int header_num,
 		       unsigned int header_len, uint64_t rand_seed);
@@ -105,6 +114,11 @@ static void fill_pattern_headers(struct thread_data *td, struct io_u *io_u,
 	fill_verify_pattern(td, p, io_u->buflen, io_u, seed, use_seed);
 
 	hdr_inc = get_hdr_inc(td, io_u);
+	if (verify_hash_mb(td, io_u, hdr_inc)) {
+		populate_hdrs_mb(td, io_u, hdr_inc);
+		return;
+	}
+
 	header_num = 0;
 	for (; p < io_u->buf + io_u->buflen; p += hdr_inc) {
 		hdr = p;
@@ -189,6 +203,9 @@ static inline unsigned int __hdr_size(int verify_type)
 	case VERIFY_SHA1:
 		len = sizeof(struct vhdr_sha1);
 		break;
+	case VERIFY_XXH3:
+		len = sizeof(struct vhdr_xxh3);
+		break;
 	case VERIFY_PATTERN_NO_HDR:
 		return 0;
 	default:
@@ -215,6 +232,91 @@ static void *hdr_priv(struct verify_header *hdr)
 	return priv + sizeof(struct verify_header);
 }
 
+/*
+ * md5 and sha256 blocks of an io_u are hashed together on the
+ * multi-buffer path, FIO_HASH_MB_MAX_LANES at a time. That needs all
+ * blocks to be full and verify_offset not to move headers into the data
+ * of the next block before it is hashed.
+ */
+static bool verify_hash_mb(struct thread_data *td, struct io_u *io_u,
+			   unsigned int hdr_inc)
+{
+	if (td->o.verify != VERIFY_MD5 && td->o.verify != VERIFY_SHA256)
+		return false;
+	if (td->o.verify_offset || hdr_inc <= __hdr_size(td->o.verify))
+		return false;
+	if (io_u->buflen % hdr_inc || io_u->buflen / hdr_inc < 2)
+		return false;
+
+	return fio_hash_mb_lanes() > 1;
+}
+
+/*
+ * Hash 'len' bytes of each of the 'nr' buffers in 'data', storing the
+ * md5 hash or sha256 buffer of each in the matching 'digest'.
+ */
+static void hash_mb(struct thread_data *td, void **data, void **digest,
+		    unsigned int len, unsigned int nr)
+{
+	unsigned int i;
+
+	switch (td->o.verify) {
+	case VERIFY_MD5: {
+		struct fio_md5_ctx ctx[FIO_HASH_MB_MAX_LANES];
+		struct fio_md5_ctx *ctxp[FIO_HASH_MB_MAX_LANES];
+
+		for (i = 0; i < nr; i++) {
+			ctx[i] = (struct fio_md5_ctx) { .hash = digest[i], };
+			fio_md5_init(&ctx[i]);
+			ctxp[i] = &ctx[i];
+		}
+		fio_md5_update_mb(ctxp, (const uint8_t **) data, len, nr);
+		for (i = 0; i < nr; i++)
+			fio_md5_final(ctxp[i]);
+		break;
+		}
+	case VERIFY_SHA256: {
+		struct fio_sha256_ctx ctx[FIO_HASH_MB_MAX_LANES];
+		struct fio_sha256_ctx *ctxp[FIO_HASH_MB_MAX_LANES];
+
+		for (i = 0; i < nr; i++) {
+			ctx[i] = (struct fio_sha256_ctx) { .buf = digest[i], };
+			fio_sha256_init(&ctx[i]);
+			ctxp[i] = &ctx[i];
+		}
+		fio_sha256_update_mb(ctxp, (const uint8_t **) data, len, nr);
+		for (i = 0; i < nr; i++)
+			fio_sha256_final(ctxp[i]);
+		break;
+		}
+	default:
+		assert(0);
+	}
+}
+
+/*
+ * Hash the data of up to FIO_HASH_MB_MAX_LANES blocks from 'p' on, for
+ * verify_io_u() to check against their headers. Returns the number of
+ * blocks hashed.
+ */
+static unsigned int verify_hash_blocks_mb(struct thread_data *td, void *p,
+					  void *end, unsigned int hdr_inc,
+					  uint32_t (*out)[16])
+{
+	unsigned int header_size = __hdr_size(td->o.verify);
+	void *data[FIO_HASH_MB_MAX_LANES], *digest[FIO_HASH_MB_MAX_LANES];
+	unsigned int nr;
+
+	for (nr = 0; nr < FIO_HASH_MB_MAX_LANES && p < end;
+	     nr++, p += hdr_inc) {
+		data[nr] = p + header_size;
+		digest[nr] = out[nr];
+	}
+
+	hash_mb(td, data, digest, hdr_inc - header_size, nr);
+	return nr;
+}
+
 /*
  * Verify container, pass info to verify handlers and allow them to
  * pass info back in case of error
@@ -226,6 +328,8 @@ struct vcont {
 	struct io_u *io_u;
 	unsigned int hdr_num;
 	struct thread_data *td;
+	/* checksum of the block from the multi-buffer path, if any */
+	void *digest;
 
 	/*
 	 * Output, only valid in case of error
@@ -437,6 +541,27 @@ static int verify_io_u_xxhash(struct verify_header *hdr, struct vcont *vc)
 	return EILSEQ;
 }
 
+static int verify_io_u_xxh3(struct verify_header *hdr, struct vcont *vc)
+{
+	void *p = io_u_verify_off(hdr, vc);
+	struct vhdr_xxh3 *vh = hdr_priv(hdr);
+	uint64_t hash;
+
+	dprint(FD_VERIFY, "xxh3 verify io_u %p, len %u\n", vc->io_u, hdr->len);
+
+	hash = fio_xxh3_64(p, hdr->len - hdr_size(vc->td, hdr));
+
+	if (vh->hash == hash)
+		return 0;
+
+	vc->name = "xxh3";
+	vc->good_crc = &vh->hash;
+	vc->bad_crc = &hash;
+	vc->crc_len = sizeof(hash);
+	log_verify_failure(hdr, vc);
+	return EILSEQ;
+}
+
 static int verify_io_u_sha3(struct verify_header *hdr, struct vcont *vc,
 			    struct fio_sha3_ctx *sha3_ctx, uint8_t *sha,
 			    unsigned int sha_size, const char *name)
@@ -551,9 +676,14 @@ static int verify_io_u_sha256(struct verify_header *hdr, struct vcont *vc)
 
 	dprint(FD_VERIFY, "sha256 verify io_u %p, len %u\n", vc->io_u, hdr->len);
 
-	fio_sha256_init(&sha256_ctx);
-	fio_sha256_update(&sha256_ctx, p, hdr->len - hdr_size(vc->td, hdr));
-	fio_sha256_final(&sha256_ctx);
+	if (vc->digest) {
+		memcpy(sha256, vc->digest, sizeof(sha256));
+	} else {
+		fio_sha256_init(&sha256_ctx);
+		fio_sha256_update(&sha256_ctx, p,
+				  hdr->len - hdr_size(vc->td, hdr));
+		fio_sha256_final(&sha256_ctx);
+	}
 
 	if (!memcmp(vh->sha256, sha256_ctx.buf, sizeof(sha256)))
 		return 0;
@@ -708,9 +838,13 @@ static int verify_io_u_md5(struct verify_header *hdr, struct vcont *vc)
 
 	dprint(FD_VERIFY, "md5 verify io_u %p, len %u\n", vc->io_u, hdr->len);
 
-	fio_md5_init(&md5_ctx);
-	fio_md5_update(&md5_ctx, p, hdr->len - hdr_size(vc->td, hdr));
-	fio_md5_final(&md5_ctx);
+	if (vc->digest) {
+		memcpy(hash, vc->digest, sizeof(hash));
+	} else {
+		fio_md5_init(&md5_ctx);
+		fio_md5_update(&md5_ctx, p, hdr->len - hdr_size(vc->td, hdr));
+		fio_md5_final(&md5_ctx);
+	}
 
 	if (!memcmp(vh->md5_digest, md5_ctx.hash, sizeof(hash)))
 		return 0;
@@ -723,27 +857,87 @@ static int verify_io_u_md5(struct verify_header *hdr, struct vcont *vc)
 	return EILSEQ;
 }
 
+struct verify_worker {
+	struct thread_data *td;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct flist_head list;
+	bool waiting;
+	/* the thread is gone, and doesn't take more io_us */
+	bool dead;
+};
+
+/*
+ * Hand the batched up io_us to the next verify thread. Called at the end
+ * of each round of completions, so io_us never sit in the batch while the
+ * job waits for free ones. Threads that exited on an error are skipped,
+ * if all of them did the io_us are returned unverified.
+ */
+void verify_async_flush(struct thread_data *td)
+{
+	struct thread_data *vtd = td->parent ? td->parent : td;
+	struct verify_worker *vw;
+	unsigned int i, tries;
+
+	if (!td->verify_async_nr)
+		return;
+
+	for (tries = 0; tries < vtd->o.verify_async; tries++) {
+		vw = &vtd->verify_workers[td->verify_next++ % vtd->o.verify_async];
+
+		pthread_mutex_lock(&vw->lock);
+		if (!vw->dead)
+			break;
+		pthread_mutex_unlock(&vw->lock);
+	}
+
+	if (tries == vtd->o.verify_async) {
+		put_io_u_batch(td, td->verify_async_batch, td->verify_async_nr);
+		td->verify_async_nr = 0;
+		return;
+	}
+
+	for (i = 0; i < td->verify_async_nr; i++) {
+		struct io_u *io_u = td->verify_async_batch[i];
+
+		flist_add_tail(&io_u->verify_list, &vw->list);
+	}
+	if (vw->waiting)
+		pthread_cond_signal(&vw->cond);
+	pthread_mutex_unlock(&vw->lock);
+
+	td->verify_async_nr = 0;
+}
+
 /*
- * Push IO verification to a separate thread
+ * Push IO verification to a separate thread. The io_u is out of the
+ * queue depth and has dropped its file reference before a verify thread
+ * sees it, so only the completing thread touches those.
  */
 int verify_io_u_async(struct thread_data *td, struct io_u **io_u_ptr)
 {
 	struct io_u *io_u = *io_u_ptr;
 
-	pthread_mutex_lock(&td->io_u_lock);
-
+	/*
+	 * The verify keeps using the file, but the reference is dropped
+	 * here, whoever returns the io_u to the freelist must not drop it
+	 * again.
+	 */
 	if (io_u->file)
 		put_file_log(td, io_u->file);
+	io_u_set(td, io_u, IO_U_F_NO_FILE_PUT);
 
 	if (io_u->flags & IO_U_F_IN_CUR_DEPTH) {
 		td->cur_depth--;
 		io_u_clear(td, io_u, IO_U_F_IN_CUR_DEPTH);
 	}
-	flist_add_tail(&io_u->verify_list, &td->verify_list);
+
+	td->verify_async_batch[td->verify_async_nr++] = io_u;
 	*io_u_ptr = NULL;
 
-	pthread_cond_signal(&td->verify_cond);
-	pthread_mutex_unlock(&td->io_u_lock);
+	if (td->verify_async_nr == VERIFY_ASYNC_BATCH)
+		verify_async_flush(td);
 	return 0;
 }
 
@@ -840,10 +1034,11 @@ static int verify_header(struct io_u *io_u, struct thread_data *td,
 	 * For read-only workloads, the program cannot be certain of the
 	 * last numberio written to a block. Checking of numberio will be
 	 * done only for workloads that write data.  For verify_only,
-	 * numberio check is skipped.
+	 * numberio check is skipped, as it is for blocks from the verify
+	 * index once it stopped tracking numberio.
 	 */
 	if (td_write(td) && (td_min_bs(td) == td_max_bs(td)) &&
-	    !td->o.time_based)
+	    !td->o.time_based && !(io_u->flags & IO_U_F_VER_NONUM))
 		if (!td->o.verify_only)
 			if (hdr->numberio != io_u->numberio) {
 				log_err("verify: bad header numberio %"PRIu16
@@ -879,6 +1074,9 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 	struct verify_header *hdr;
 	struct io_u *io_u = *io_u_ptr;
 	unsigned int header_size, hdr_inc, hdr_num = 0;
+	uint32_t mb_digest[FIO_HASH_MB_MAX_LANES][16];
+	unsigned int mb_first = 0, mb_nr = 0;
+	bool mb;
 	void *p;
 	int ret;
 
@@ -897,6 +1095,7 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 	}
 
 	hdr_inc = get_hdr_inc(td, io_u);
+	mb = verify_hash_mb(td, io_u, hdr_inc);
 
 	ret = 0;
 	for (p = io_u->buf; p < io_u->buf + io_u->buflen;
@@ -933,6 +1132,21 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 		else
 			verify_type = hdr->verify_type;
 
+		/*
+		 * mb_digest holds the hashes of blocks mb_first and up. If
+		 * this block isn't one of them, because an earlier one was
+		 * of another type, hash a new set starting here.
+		 */
+		if (mb && verify_type == hdr->verify_type) {
+			if (hdr_num < mb_first || hdr_num >= mb_first + mb_nr) {
+				mb_first = hdr_num;
+				mb_nr = verify_hash_blocks_mb(td, p,
+						io_u->buf + io_u->buflen,
+						hdr_inc, mb_digest);
+			}
+			vc.digest = mb_digest[hdr_num - mb_first];
+		}
+
 		switch (verify_type) {
 		case VERIFY_HDR_ONLY:
 			/* Header is always verified, check if pattern is left
@@ -983,6 +1197,9 @@ int verify_io_u(struct thread_data *td, struct io_u **io_u_ptr)
 		case VERIFY_SHA1:
 			ret = verify_io_u_sha1(hdr, &vc);
 			break;
+		case VERIFY_XXH3:
+			ret = verify_io_u_xxh3(hdr, &vc);
+			break;
 		case VERIFY_PATTERN:
 		case VERIFY_PATTERN_NO_HDR:
 			ret = verify_io_u_pattern(hdr, &vc);
@@ -1014,6 +1231,13 @@ static void fill_xxhash(struct verify_header *hdr, void *p, unsigned int len)
 	vh->hash = XXH32_digest(state);
 }
 
+static void fill_xxh3(struct verify_header *hdr, void *p, unsigned int len)
+{
+	struct vhdr_xxh3 *vh = hdr_priv(hdr);
+
+	vh->hash = fio_xxh3_64(p, len);
+}
+
 static void fill_sha3(struct fio_sha3_ctx *sha3_ctx, void *p, unsigned int len)
 {
 	fio_sha3_update(sha3_ctx, p, len);
@@ -1264,6 +1488,11 @@ static void populate_hdr(struct thread_data *td, struct io_u *io_u,
 						io_u, hdr->len);
 		fill_sha1(hdr, data, data_len);
 		break;
+	case VERIFY_XXH3:
+		dprint(FD_VERIFY, "fill xxh3 io_u %p, len %u\n",
+						io_u, hdr->len);
+		fill_xxh3(hdr, data, data_len);
+		break;
 	case VERIFY_HDR_ONLY:
 	case VERIFY_PATTERN:
 	case VERIFY_PATTERN_NO_HDR:
@@ -1278,6 +1507,35 @@ static void populate_hdr(struct thread_data *td, struct io_u *io_u,
 		memswp(p, p + td->o.verify_offset, hdr_size(td, hdr));
 }
 
+/*
+ * populate_hdr() for all blocks of the io_u, hashing the data of the
+ * blocks together on the multi-buffer path.
+ */
+static void populate_hdrs_mb(struct thread_data *td, struct io_u *io_u,
+			     unsigned int hdr_inc)
+{
+	unsigned int header_size = __hdr_size(td->o.verify);
+	void *data[FIO_HASH_MB_MAX_LANES], *digest[FIO_HASH_MB_MAX_LANES];
+	unsigned int nr, header_num = 0;
+	void *p = io_u->buf;
+
+	dprint(FD_VERIFY, "fill %llu blocks io_u %p, len %u\n",
+			io_u->buflen / hdr_inc, io_u, hdr_inc);
+
+	while (p < io_u->buf + io_u->buflen) {
+		for (nr = 0; nr < FIO_HASH_MB_MAX_LANES &&
+		     p < io_u->buf + io_u->buflen; nr++, p += hdr_inc) {
+			struct verify_header *hdr = p;
+
+			fill_hdr(td, io_u, hdr, header_num++, hdr_inc,
+					io_u->rand_seed);
+			data[nr] = p + header_size;
+			digest[nr] = hdr_priv(hdr);
+		}
+		hash_mb(td, data, digest, hdr_inc - header_size, nr);
+	}
+}
+
 /*
  * fill body of io_u->buf with random data and add a header with the
  * checksum of choice
@@ -1302,6 +1560,9 @@ int get_next_verify(struct thread_data *td, struct io_u *io_u)
 	if (io_u->file)
 		return 0;
 
+	if (td->vbatch)
+		return verify_batch_next(td, io_u);
+
 	if (!RB_EMPTY_ROOT(&td->io_hist_tree)) {
 		struct fio_rb_node *n = rb_first(&td->io_hist_tree);
 
@@ -1334,14 +1595,21 @@ int get_next_verify(struct thread_data *td, struct io_u *io_u)
 		td->io_hist_len--;
 
 		io_u->offset = ipo->offset;
-		io_u->verify_offset = ipo->offset;
+		if (ipo->flags & IP_F_ZONE_APPEND)
+			io_u->verify_offset = zbd_zone_start(ipo->file,
+							     ipo->offset);
+		else
+			io_u->verify_offset = ipo->offset;
 		io_u->buflen = ipo->len;
 		io_u->numberio = ipo->numberio;
 		io_u->file = ipo->file;
-		io_u_set(td, io_u, IO_U_F_VER_LIST);
 
 		if (ipo->flags & IP_F_TRIMMED)
 			io_u_set(td, io_u, IO_U_F_TRIMMED);
+	}
+
+	if (ipo || verify_index_next(td, io_u)) {
+		io_u_set(td, io_u, IO_U_F_VER_LIST);
 
 		if (!fio_file_open(io_u->file)) {
 			int r = td_io_open_file(td, io_u->file);
@@ -1353,14 +1621,16 @@ int get_next_verify(struct thread_data *td, struct io_u *io_u)
 			}
 		}
 
-		get_file(ipo->file);
+		get_file(io_u->file);
 		assert(fio_file_open(io_u->file));
 		io_u->ddir = DDIR_READ;
 		io_u->xfer_buf = io_u->buf;
 		io_u->xfer_buflen = io_u->buflen;
 
-		remove_trim_entry(td, ipo);
-		free(ipo);
+		if (ipo) {
+			remove_trim_entry(td, ipo);
+			free(ipo);
+		}
 		dprint(FD_VERIFY, "get_next_verify: ret io_u %p\n", io_u);
 
 		if (!td->o.verify_pattern_bytes) {
@@ -1382,13 +1652,22 @@ void fio_verify_init(struct thread_data *td)
 	    td->o.verify == VERIFY_CRC32C) {
 		crc32c_arm64_probe();
 		crc32c_intel_probe();
-	}
+	} else if (td->o.verify == VERIFY_SHA1 ||
+		   td->o.verify == VERIFY_SHA256) {
+		sha_arm64_probe();
+		sha_ni_probe();
+	} else if (td->o.verify == VERIFY_XXH3)
+		xxh3_probe();
 }
 
 static void *verify_async_thread(void *data)
 {
-	struct thread_data *td = data;
+	struct verify_worker *vw = data;
+	struct thread_data *td = vw->td;
+	struct io_u *done[VERIFY_ASYNC_BATCH];
+	unsigned int nr_done;
 	struct io_u *io_u;
+	FLIST_HEAD(left);
 	int ret = 0;
 
 	if (fio_option_is_set(&td->o, verify_cpumask) &&
@@ -1404,31 +1683,35 @@ static void *verify_async_thread(void *data)
 		if (td->verify_thread_exit)
 			break;
 
-		pthread_mutex_lock(&td->io_u_lock);
+		pthread_mutex_lock(&vw->lock);
 
-		while (flist_empty(&td->verify_list) &&
-		       !td->verify_thread_exit) {
-			ret = pthread_cond_wait(&td->verify_cond,
-							&td->io_u_lock);
+		while (flist_empty(&vw->list) && !td->verify_thread_exit) {
+			vw->waiting = true;
+			ret = pthread_cond_wait(&vw->cond, &vw->lock);
 			if (ret) {
 				break;
 			}
 		}
+		vw->waiting = false;
 
-		flist_splice_init(&td->verify_list, &list);
-		pthread_mutex_unlock(&td->io_u_lock);
+		flist_splice_init(&vw->list, &list);
+		pthread_mutex_unlock(&vw->lock);
 
 		if (flist_empty(&list))
 			continue;
 
+		nr_done = 0;
 		while (!flist_empty(&list)) {
 			io_u = flist_first_entry(&list, struct io_u, verify_list);
 			flist_del_init(&io_u->verify_list);
 
-			io_u_set(td, io_u, IO_U_F_NO_FILE_PUT);
 			ret = verify_io_u(td, &io_u);
 
-			put_io_u(td, io_u);
+			done[nr_done++] = io_u;
+			if (nr_done == VERIFY_ASYNC_BATCH) {
+				put_io_u_batch(td, done, nr_done);
+				nr_done = 0;
+			}
 			if (!ret)
 				continue;
 			if (td_non_fatal_error(td, ERROR_TYPE_VERIFY_BIT, ret)) {
@@ -1437,6 +1720,9 @@ static void *verify_async_thread(void *data)
 				ret = 0;
 			}
 		}
+
+		if (nr_done)
+			put_io_u_batch(td, done, nr_done);
 	} while (!ret);
 
 	if (ret) {
@@ -1446,6 +1732,29 @@ static void *verify_async_thread(void *data)
 	}
 
 done:
+	/*
+	 * Nothing gets queued to us from here on. Return what is left
+	 * unverified, the job is exiting or has failed already.
+	 */
+	pthread_mutex_lock(&vw->lock);
+	vw->dead = true;
+	flist_splice_init(&vw->list, &left);
+	pthread_mutex_unlock(&vw->lock);
+
+	nr_done = 0;
+	while (!flist_empty(&left)) {
+		io_u = flist_first_entry(&left, struct io_u, verify_list);
+		flist_del_init(&io_u->verify_list);
+
+		done[nr_done++] = io_u;
+		if (nr_done == VERIFY_ASYNC_BATCH) {
+			put_io_u_batch(td, done, nr_done);
+			nr_done = 0;
+		}
+	}
+	if (nr_done)
+		put_io_u_batch(td, done, nr_done);
+
 	pthread_mutex_lock(&td->io_u_lock);
 	td->nr_verify_threads--;
 	pthread_cond_signal(&td->free_cond);
@@ -1454,6 +1763,32 @@ done:
 	return NULL;
 }
 
+static void verify_async_wake_all(struct thread_data *td)
+{
+	int i;
+
+	for (i = 0; i < td->o.verify_async; i++) {
+		struct verify_worker *vw = &td->verify_workers[i];
+
+		pthread_mutex_lock(&vw->lock);
+		pthread_cond_signal(&vw->cond);
+		pthread_mutex_unlock(&vw->lock);
+	}
+}
+
+static void verify_async_free(struct thread_data *td)
+{
+	int i;
+
+	for (i = 0; i < td->o.verify_async; i++) {
+		pthread_cond_destroy(&td->verify_workers[i].cond);
+		pthread_mutex_destroy(&td->verify_workers[i].lock);
+	}
+
+	free(td->verify_workers);
+	td->verify_workers = NULL;
+}
+
 int verify_async_init(struct thread_data *td)
 {
 	int i, ret;
@@ -1463,23 +1798,39 @@ int verify_async_init(struct thread_data *td)
 	pthread_attr_setstacksize(&attr, 2 * PTHREAD_STACK_MIN);
 
 	td->verify_thread_exit = 0;
+	td->verify_next = 0;
+	td->verify_async_nr = 0;
+
+	td->verify_workers = calloc(td->o.verify_async,
+					sizeof(struct verify_worker));
+	for (i = 0; i < td->o.verify_async; i++) {
+		struct verify_worker *vw = &td->verify_workers[i];
+
+		vw->td = td;
+		INIT_FLIST_HEAD(&vw->list);
+		pthread_mutex_init(&vw->lock, NULL);
+		pthread_cond_init(&vw->cond, NULL);
+	}
 
-	td->verify_threads = malloc(sizeof(pthread_t) * td->o.verify_async);
 	for (i = 0; i < td->o.verify_async; i++) {
-		ret = pthread_create(&td->verify_threads[i], &attr,
-					verify_async_thread, td);
+		struct verify_worker *vw = &td->verify_workers[i];
+
+		ret = pthread_create(&vw->thread, &attr, verify_async_thread,
+					vw);
 		if (ret) {
 			log_err("fio: async verify creation failed: %s\n",
 					strerror(ret));
 			break;
 		}
-		ret = pthread_detach(td->verify_threads[i]);
+		ret = pthread_detach(vw->thread);
 		if (ret) {
 			log_err("fio: async verify thread detach failed: %s\n",
 					strerror(ret));
 			break;
 		}
+		pthread_mutex_lock(&td->io_u_lock);
 		td->nr_verify_threads++;
+		pthread_mutex_unlock(&td->io_u_lock);
 	}
 
 	pthread_attr_destroy(&attr);
@@ -1487,11 +1838,7 @@ int verify_async_init(struct thread_data *td)
 	if (i != td->o.verify_async) {
 		log_err("fio: only %d verify threads started, exiting\n", i);
 
-		pthread_mutex_lock(&td->io_u_lock);
-		td->verify_thread_exit = 1;
-		pthread_cond_broadcast(&td->verify_cond);
-		pthread_mutex_unlock(&td->io_u_lock);
-
+		verify_async_exit(td);
 		return 1;
 	}
 
@@ -1500,16 +1847,19 @@ int verify_async_init(struct thread_data *td)
 
 void verify_async_exit(struct thread_data *td)
 {
-	pthread_mutex_lock(&td->io_u_lock);
+	if (!td->verify_workers)
+		return;
+
 	td->verify_thread_exit = 1;
-	pthread_cond_broadcast(&td->verify_cond);
+	write_barrier();
+	verify_async_wake_all(td);
 
+	pthread_mutex_lock(&td->io_u_lock);
 	while (td->nr_verify_threads)
 		pthread_cond_wait(&td->free_cond, &td->io_u_lock);
-
 	pthread_mutex_unlock(&td->io_u_lock);
-	free(td->verify_threads);
-	td->verify_threads = NULL;
+
+	verify_async_free(td);
 }
 
 int paste_blockoff(char *buf, unsigned int len, void *priv)
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "compiler/compiler.h"
 #include "verify-state.h"
+#include "verify-index.h"
 
 #define FIO_HDR_MAGIC	0xacca
 
@@ -30,6 +31,7 @@ enum {
 	VERIFY_PATTERN,			/* verify specific patterns */
 	VERIFY_PATTERN_NO_HDR,		/* verify specific patterns, no hdr */
 	VERIFY_NULL,			/* pretend to verify */
+	VERIFY_XXH3,			/* xxh3 sum data blocks */
 };
 
 /*
@@ -89,6 +91,9 @@ struct vhdr_crc7 {
 struct vhdr_xxhash {
 	uint32_t hash;
 };
+struct vhdr_xxh3 {
+	uint64_t hash;
+};
 
 /*
  * Verify helpers
@@ -97,6 +102,7 @@ extern void populate_verify_io_u(struct thread_data *, struct io_u *);
 extern int __must_check get_next_verify(struct thread_data *td, struct io_u *);
 extern int __must_check verify_io_u(struct thread_data *, struct io_u **);
 extern int verify_io_u_async(struct thread_data *, struct io_u **);
+extern void verify_async_flush(struct thread_data *);
 extern void fill_verify_pattern(struct thread_data *td, void *p, unsigned int len, struct io_u *io_u, uint64_t seed, int use_seed);
 extern void fill_buffer_pattern(struct thread_data *td, void *p, unsigned int len);
 extern void fio_verify_init(struct thread_data *td);
@@ -294,7 +294,7 @@ static int start_worker(struct workqueue *wq, unsigned int index,
 	ret = pthread_create(&sw->thread, NULL, worker_thread, sw);
 	if (!ret) {
 		pthread_mutex_lock(&sw->lock);
-		sw->flags = SW_F_IDLE;
+		sw->flags |= SW_F_IDLE;
 		pthread_mutex_unlock(&sw->lock);
 		return 0;
 	}
@@ -37,16 +37,18 @@ int zbd_get_zoned_model(struct thread_data *td, struct fio_file *f,
 		return -EINVAL;
 	}
 
-	/* If regular file, always emulate zones inside the file. */
-	if (f->filetype == FIO_TYPE_FILE) {
+	if (td->io_ops && td->io_ops->get_zoned_model) {
+		ret = td->io_ops->get_zoned_model(td, f, model);
+	} else if (f->filetype == FIO_TYPE_FILE) {
+		/*
+		 * If regular file, emulate zones inside the file unless the
+		 * ioengine knows better.
+		 */
 		*model = ZBD_NONE;
 		return 0;
-	}
-
-	if (td->io_ops && td->io_ops->get_zoned_model)
-		ret = td->io_ops->get_zoned_model(td, f, model);
-	else
+	} else {
 		ret = blkzoned_get_zoned_model(td, f, model);
+	}
 	if (ret < 0) {
 		td_verror(td, errno, "get zoned model failed");
 		log_err("%s: get zoned model failed (%d).\n",
@@ -819,6 +821,24 @@ int zbd_setup_files(struct thread_data *td)
 	if (!zbd_verify_bs())
 		return 1;
 
+	if (td->o.zone_append && td_write(td)) {
+		if (!td_ioengine_flagged(td, FIO_ZONE_APPEND)) {
+			log_err("%s: ioengine %s does not support zone_append\n",
+				td->o.name, td->io_ops->name);
+			return 1;
+		}
+		if (td->o.verify_state_journal) {
+			log_err("%s: zone_append can't be combined with verify_state_journal\n",
+				td->o.name);
+			return 1;
+		}
+		if (td->o.do_verify && td->o.experimental_verify) {
+			log_err("%s: zone_append can't be combined with experimental_verify\n",
+				td->o.name);
+			return 1;
+		}
+	}
+
 	for_each_file(td, f, i) {
 		struct zoned_block_device_info *zbd = f->zbd_info;
 		struct fio_zone_info *z;
@@ -925,11 +945,9 @@ static int zbd_reset_zone(struct thread_data *td, struct fio_file *f,
 		break;
 	}
 
-	pthread_mutex_lock(&f->zbd_info->mutex);
-	f->zbd_info->sectors_with_data -= data_in_zone;
-	f->zbd_info->wp_sectors_with_data -= data_in_zone;
-	pthread_mutex_unlock(&f->zbd_info->mutex);
-	z->wp = z->start;
+	atomic_sub(&f->zbd_info->sectors_with_data, data_in_zone);
+	atomic_sub(&f->zbd_info->wp_sectors_with_data, data_in_zone);
+	atomic_store_release(&z->wp, z->start);
 	z->verify_block = 0;
 
 	td->ts.nr_zone_resets++;
@@ -937,12 +955,26 @@ static int zbd_reset_zone(struct thread_data *td, struct fio_file *f,
 	return ret;
 }
 
+/*
+ * Whether another job has zone @z to itself. Jobs without exclusive_zones
+ * don't write to such a zone either. The caller must hold z->mutex.
+ */
+static bool zbd_zone_owned_by_other(const struct thread_data *td,
+				    struct fio_zone_info *z)
+{
+	uint32_t owner = atomic_load_acquire(&z->owner);
+
+	return owner && owner != td->thread_number;
+}
+
 /* The caller must hold f->zbd_info->mutex */
 static void zbd_close_zone(struct thread_data *td, const struct fio_file *f,
 			   unsigned int zone_idx)
 {
 	uint32_t open_zone_idx = 0;
 
+	atomic_store_release(&get_zone(f, zone_idx)->owner, 0);
+
 	for (; open_zone_idx < f->zbd_info->num_open_zones; open_zone_idx++) {
 		if (f->zbd_info->open_zones[open_zone_idx] == zone_idx)
 			break;
@@ -985,6 +1017,13 @@ static int zbd_reset_zones(struct thread_data *td, struct fio_file *f,
 		if (!z->has_wp)
 			continue;
 		zone_lock(td, f, z);
+		/* the owner moves the write pointer without the zone lock */
+		if (zbd_zone_owned_by_other(td, z)) {
+			dprint(FD_ZBD, "%s: not resetting owned zone %u\n",
+			       f->file_name, nz);
+			zone_unlock(z);
+			continue;
+		}
 		pthread_mutex_lock(&f->zbd_info->mutex);
 		zbd_close_zone(td, f, nz);
 		pthread_mutex_unlock(&f->zbd_info->mutex);
@@ -1049,6 +1088,7 @@ static uint64_t zbd_process_swd(struct thread_data *td,
 	struct fio_zone_info *zb, *ze, *z;
 	uint64_t swd = 0;
 	uint64_t wp_swd = 0;
+	bool owned = false;
 
 	zb = get_zone(f, f->min_zone);
 	ze = get_zone(f, f->max_zone);
@@ -1056,21 +1096,32 @@ static uint64_t zbd_process_swd(struct thread_data *td,
 		if (z->has_wp) {
 			zone_lock(td, f, z);
 			wp_swd += z->wp - z->start;
+			owned |= zbd_zone_owned_by_other(td, z);
 		}
 		swd += z->wp - z->start;
 	}
-	pthread_mutex_lock(&f->zbd_info->mutex);
+
+	/*
+	 * The zone locks don't stop the owner of a zone from writing to it,
+	 * so the sum can be off. The owner keeps the counters up to date,
+	 * leave them alone.
+	 */
+	if (owned)
+		goto out;
+
 	switch (a) {
 	case CHECK_SWD:
-		assert(f->zbd_info->sectors_with_data == swd);
-		assert(f->zbd_info->wp_sectors_with_data == wp_swd);
+		assert(atomic_load_relaxed(&f->zbd_info->sectors_with_data) ==
+		       swd);
+		assert(atomic_load_relaxed(&f->zbd_info->wp_sectors_with_data) ==
+		       wp_swd);
 		break;
 	case SET_SWD:
-		f->zbd_info->sectors_with_data = swd;
-		f->zbd_info->wp_sectors_with_data = wp_swd;
+		atomic_store_release(&f->zbd_info->sectors_with_data, swd);
+		atomic_store_release(&f->zbd_info->wp_sectors_with_data, wp_swd);
 		break;
 	}
-	pthread_mutex_unlock(&f->zbd_info->mutex);
+out:
 	for (z = zb; z < ze; z++)
 		if (z->has_wp)
 			zone_unlock(z);
@@ -1116,6 +1167,46 @@ void zbd_file_reset(struct thread_data *td, struct fio_file *f)
 	zbd_reset_write_cnt(td, f);
 }
 
+/*
+ * Let a job with exclusive_zones have zone @z to itself, until the zone is
+ * closed or the job is done. The caller must hold z->mutex.
+ */
+static void zbd_own_zone(const struct thread_data *td,
+			 const struct fio_file *f, struct fio_zone_info *z)
+{
+	if (!td->o.exclusive_zones || z->owner == td->thread_number)
+		return;
+
+	assert(!z->owner);
+	dprint(FD_ZBD, "%s: job %d owns zone %u\n", f->file_name,
+	       td->thread_number, zbd_zone_nr(f, z));
+	atomic_store_release(&z->owner, td->thread_number);
+}
+
+/*
+ * Give up the zones a job with exclusive_zones still owns, so that other
+ * jobs can write to them. Ownership is taken and given up under the zone
+ * lock, so that a job holding it can rely on zbd_zone_owned_by_other().
+ * The one exception is the owner closing a zone it filled, after which it
+ * doesn't write to it anymore.
+ */
+void zbd_release_zones(const struct thread_data *td, struct fio_file *f)
+{
+	struct fio_zone_info *z, *ze;
+
+	if (!td->o.exclusive_zones || f->max_zone <= f->min_zone)
+		return;
+
+	ze = get_zone(f, f->max_zone);
+	for (z = get_zone(f, f->min_zone); z < ze; z++) {
+		if (atomic_load_acquire(&z->owner) != td->thread_number)
+			continue;
+		pthread_mutex_lock(&z->mutex);
+		atomic_store_release(&z->owner, 0);
+		pthread_mutex_unlock(&z->mutex);
+	}
+}
+
 /* The caller must hold f->zbd_info->mutex. */
 static bool is_zone_open(const struct thread_data *td, const struct fio_file *f,
 			 unsigned int zone_idx)
@@ -1160,6 +1251,9 @@ static bool zbd_open_zone(struct thread_data *td, const struct fio_file *f,
 	if (td->o.verify != VERIFY_NONE && zbd_zone_full(f, z, min_bs))
 		return false;
 
+	if (zbd_zone_owned_by_other(td, z))
+		return false;
+
 	/*
 	 * zbdi->max_open_zones == 0 means that there is no limit on the maximum
 	 * number of open zones. In this case, do no track open zones in
@@ -1238,6 +1332,7 @@ static struct fio_zone_info *zbd_convert_to_open_zone(struct thread_data *td,
 	bool wait_zone_close;
 	bool in_flight;
 	bool should_retry = true;
+	bool owned_by_other;
 
 	assert(is_valid_offset(f, io_u->offset));
 
@@ -1290,6 +1385,7 @@ static struct fio_zone_info *zbd_convert_to_open_zone(struct thread_data *td,
 		assert(!open_zone_idx ||
 		       open_zone_idx < zbdi->num_open_zones);
 		tmp_idx = open_zone_idx;
+		owned_by_other = false;
 		for (i = 0; i < zbdi->num_open_zones; i++) {
 			uint32_t tmpz;
 
@@ -1297,13 +1393,24 @@ static struct fio_zone_info *zbd_convert_to_open_zone(struct thread_data *td,
 				tmp_idx = 0;
 			tmpz = zbdi->open_zones[tmp_idx];
 			if (f->min_zone <= tmpz && tmpz < f->max_zone) {
-				open_zone_idx = tmp_idx;
-				goto found_candidate_zone;
+				if (!zbd_zone_owned_by_other(td,
+							     get_zone(f, tmpz))) {
+					open_zone_idx = tmp_idx;
+					goto found_candidate_zone;
+				}
+				owned_by_other = true;
 			}
 
 			tmp_idx++;
 		}
 
+		/*
+		 * If all open zones are owned by other jobs, open a zone for
+		 * this job.
+		 */
+		if (owned_by_other && z->has_wp)
+			goto open_other_zone;
+
 		dprint(FD_ZBD, "%s(%s): no candidate zone\n",
 			__func__, f->file_name);
 		pthread_mutex_unlock(&zbdi->mutex);
@@ -1324,7 +1431,8 @@ found_candidate_zone:
 	/* Both z->mutex and zbdi->mutex are held. */
 
 examine_zone:
-	if (z->wp + min_bs <= zbd_zone_capacity_end(z)) {
+	if (!zbd_zone_owned_by_other(td, z) &&
+	    z->wp + min_bs <= zbd_zone_capacity_end(z)) {
 		pthread_mutex_unlock(&zbdi->mutex);
 		goto out;
 	}
@@ -1388,7 +1496,8 @@ retry:
 		z = get_zone(f, zone_idx);
 
 		zone_lock(td, f, z);
-		if (z->wp + min_bs <= zbd_zone_capacity_end(z))
+		if (!zbd_zone_owned_by_other(td, z) &&
+		    z->wp + min_bs <= zbd_zone_capacity_end(z))
 			goto out;
 		pthread_mutex_lock(&zbdi->mutex);
 	}
@@ -1433,6 +1542,17 @@ static struct fio_zone_info *zbd_replay_write_order(struct thread_data *td,
 	const struct fio_file *f = io_u->file;
 	const uint32_t min_bs = td->o.min_bs[DDIR_WRITE];
 
+	/*
+	 * Appended data landed in completion order, which is the order the
+	 * writes were logged in, at the offset the engine reported. Don't
+	 * replace that with the issue order.
+	 */
+	if (td->o.zone_append) {
+		assert(io_u->offset >= z->start &&
+		       io_u->offset + io_u->buflen <= zbd_zone_capacity_end(z));
+		return z;
+	}
+
 	if (!zbd_open_zone(td, f, zbd_zone_nr(f, z))) {
 		zone_unlock(z);
 		z = zbd_convert_to_open_zone(td, io_u);
@@ -1511,7 +1631,7 @@ zbd_find_zone(struct thread_data *td, struct io_u *io_u, uint32_t min_bytes,
  *
  * If the write command made the zone full, close it.
  *
- * The caller must hold z->mutex.
+ * The caller must hold z->mutex, or own the zone.
  */
 static void zbd_end_zone_io(struct thread_data *td, const struct io_u *io_u,
 			    struct fio_zone_info *z)
@@ -1526,6 +1646,30 @@ static void zbd_end_zone_io(struct thread_data *td, const struct io_u *io_u,
 	}
 }
 
+/*
+ * Move the write pointer of zone @z past a queued write. The caller must hold
+ * z->mutex, or own the zone.
+ */
+static void zbd_advance_wp(struct io_u *io_u, struct fio_zone_info *z)
+{
+	struct fio_file *f = io_u->file;
+	struct zoned_block_device_info *zbd_info = f->zbd_info;
+	uint64_t zone_end;
+
+	zone_end = min((uint64_t)(io_u->offset + io_u->buflen),
+		       zbd_zone_capacity_end(z));
+	/*
+	 * z->wp > zone_end means that one or more I/O errors
+	 * have occurred.
+	 */
+	if (z->wp <= zone_end) {
+		atomic_add(&zbd_info->sectors_with_data, zone_end - z->wp);
+		atomic_add(&zbd_info->wp_sectors_with_data, zone_end - z->wp);
+	}
+	atomic_store_release(&z->wp, zone_end);
+	f->last_zone = zbd_zone_nr(f, z);
+}
+
 /**
  * zbd_queue_io - update the write pointer of a sequential zone
  * @io_u: I/O unit
@@ -1542,7 +1686,6 @@ static void zbd_queue_io(struct thread_data *td, struct io_u *io_u, int q,
 	struct zoned_block_device_info *zbd_info = f->zbd_info;
 	struct fio_zone_info *z;
 	uint32_t zone_idx;
-	uint64_t zone_end;
 
 	assert(zbd_info);
 
@@ -1561,19 +1704,7 @@ static void zbd_queue_io(struct thread_data *td, struct io_u *io_u, int q,
 
 	switch (io_u->ddir) {
 	case DDIR_WRITE:
-		zone_end = min((uint64_t)(io_u->offset + io_u->buflen),
-			       zbd_zone_capacity_end(z));
-		pthread_mutex_lock(&zbd_info->mutex);
-		/*
-		 * z->wp > zone_end means that one or more I/O errors
-		 * have occurred.
-		 */
-		if (z->wp <= zone_end) {
-			zbd_info->sectors_with_data += zone_end - z->wp;
-			zbd_info->wp_sectors_with_data += zone_end - z->wp;
-		}
-		pthread_mutex_unlock(&zbd_info->mutex);
-		z->wp = zone_end;
+		zbd_advance_wp(io_u, z);
 		break;
 	default:
 		break;
@@ -1619,6 +1750,45 @@ static void zbd_put_io(struct thread_data *td, const struct io_u *io_u)
 	zbd_check_swd(td, f);
 }
 
+/**
+ * zbd_queue_owned_io - update the write pointer of a zone owned by the job
+ * @io_u: I/O unit
+ * @success: Whether or not the I/O unit has been queued successfully
+ * @q: queueing status (busy, completed or queued).
+ *
+ * Like zbd_queue_io(), for writes set up by zbd_adjust_owned_write(). No
+ * zone lock is held for these.
+ */
+static void zbd_queue_owned_io(struct thread_data *td, struct io_u *io_u,
+			       int q, bool success)
+{
+	const struct fio_file *f = io_u->file;
+	struct fio_zone_info *z = get_zone(f, zbd_zone_idx(f, io_u->offset));
+
+	assert(z->owner == td->thread_number);
+
+	if (success) {
+		dprint(FD_ZBD, "%s: queued owned I/O (%lld, %llu) for zone %u\n",
+		       f->file_name, io_u->offset, io_u->buflen,
+		       zbd_zone_nr(f, z));
+
+		zbd_advance_wp(io_u, z);
+		if (q == FIO_Q_COMPLETED && !io_u->error)
+			zbd_end_zone_io(td, io_u, z);
+	}
+
+	if (!success || q != FIO_Q_QUEUED)
+		io_u->zbd_put_io = NULL;
+}
+
+static void zbd_put_owned_io(struct thread_data *td, const struct io_u *io_u)
+{
+	const struct fio_file *f = io_u->file;
+
+	zbd_end_zone_io(td, io_u, get_zone(f, zbd_zone_idx(f, io_u->offset)));
+	zbd_check_swd(td, f);
+}
+
 /*
  * Windows and MacOS do not define this.
  */
@@ -1743,14 +1913,81 @@ enum fio_ddir zbd_adjust_ddir(struct thread_data *td, struct io_u *io_u,
 	return DDIR_WRITE;
 }
 
+/* Whether a job can write to zone @z without taking its lock. */
+static bool zbd_can_write_owned(const struct thread_data *td,
+				const struct fio_file *f,
+				struct fio_zone_info *z, uint32_t min_bs)
+{
+	return z->has_wp && z->cond != ZBD_ZONE_COND_OFFLINE &&
+		atomic_load_acquire(&z->owner) == td->thread_number &&
+		!z->reset_zone && !zbd_zone_full(f, z, min_bs);
+}
+
+/*
+ * Write path for jobs with exclusive_zones. If the write targets a zone
+ * that the job owns, or if the zone of the previous write still has room,
+ * put the write at the write pointer of that zone without taking any lock.
+ * Only the owner moves the write pointer of such a zone and it queues its
+ * writes in order, so there is nobody to serialize against. The write
+ * pointer is advanced by zbd_queue_owned_io(). Returns false if the write
+ * has to go through the locked path, for instance to open another zone.
+ */
+static bool zbd_adjust_owned_write(struct thread_data *td, struct io_u *io_u)
+{
+	const uint32_t min_bs = td->o.min_bs[DDIR_WRITE];
+	const uint32_t orig_len = io_u->buflen;
+	struct fio_file *f = io_u->file;
+	struct fio_zone_info *z;
+	uint64_t new_len;
+
+	/*
+	 * Zone resets triggered by zone_reset_frequency need the zone lock,
+	 * and offloaded writes may be queued by another thread.
+	 */
+	if (td->o.zrf.u.f || td->o.io_submit_mode == IO_MODE_OFFLOAD)
+		return false;
+
+	z = get_zone(f, zbd_zone_idx(f, io_u->offset));
+	if (!zbd_can_write_owned(td, f, z, min_bs)) {
+		if (f->last_zone < f->min_zone || f->last_zone >= f->max_zone)
+			return false;
+		z = get_zone(f, f->last_zone);
+		if (!zbd_can_write_owned(td, f, z, min_bs))
+			return false;
+	}
+
+	io_u->offset = z->wp;
+	new_len = min((unsigned long long)io_u->buflen,
+		      zbd_zone_capacity_end(z) - io_u->offset);
+	new_len = new_len / min_bs * min_bs;
+	if (new_len < min_bs)
+		return false;
+	if (new_len < io_u->buflen) {
+		io_u->buflen = new_len;
+		dprint(FD_IO, "Changed length from %u into %llu\n",
+		       orig_len, io_u->buflen);
+	}
+
+	if (td->o.zone_append)
+		io_u_set(td, io_u, IO_U_F_ZONE_APPEND);
+
+	assert(!io_u->zbd_queue_io);
+	assert(!io_u->zbd_put_io);
+	io_u->zbd_queue_io = zbd_queue_owned_io;
+	io_u->zbd_put_io = zbd_put_owned_io;
+	return true;
+}
+
 /**
  * zbd_adjust_block - adjust the offset and length as necessary for ZBD drives
  * @td: FIO thread data.
  * @io_u: FIO I/O unit.
  *
- * Locking strategy: returns with z->mutex locked if and only if z refers
- * to a sequential zone and if io_u_accept is returned. z is the zone that
- * corresponds to io_u->offset at the end of this function.
+ * Locking strategy: writes placed by zbd_adjust_owned_write() in a zone
+ * owned by the job with exclusive_zones return io_u_accept without holding
+ * any zone lock. Otherwise, returns with z->mutex locked if and only if z
+ * refers to a sequential zone and if io_u_accept is returned. z is the
+ * zone that corresponds to io_u->offset at the end of this function.
  */
 enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u)
 {
@@ -1807,6 +2044,11 @@ enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u)
 
 	zbd_check_swd(td, f);
 
+	if (io_u->ddir == DDIR_WRITE && td->o.exclusive_zones &&
+	    io_u->buflen <= zbdi->zone_size &&
+	    zbd_adjust_owned_write(td, io_u))
+		return io_u_accept;
+
 	zone_lock(td, f, zb);
 
 	switch (io_u->ddir) {
@@ -1925,6 +2167,7 @@ enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u)
 		}
 		/* Make writes occur at the write pointer */
 		assert(!zbd_zone_full(f, zb, min_bs));
+		zbd_own_zone(td, f, zb);
 		io_u->offset = zb->wp;
 		if (!is_valid_offset(f, io_u->offset)) {
 			td_verror(td, EINVAL, "invalid WP value");
@@ -1932,6 +2175,12 @@ enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u)
 			       f->file_name, io_u->offset);
 			goto eof;
 		}
+		/*
+		 * With zone_append, the write is reserved at the write pointer
+		 * but the device picks where it goes in the zone.
+		 */
+		if (td->o.zone_append)
+			io_u_set(td, io_u, IO_U_F_ZONE_APPEND);
 		/*
 		 * Make sure that the buflen is a multiple of the minimal
 		 * block size. Give up if shrinking would make the request too
@@ -2011,6 +2260,18 @@ char *zbd_write_status(const struct thread_stat *ts)
 	return res;
 }
 
+/**
+ * zbd_zone_start - start of the zone that holds @offset
+ * @f: FIO file.
+ * @offset: offset in @f.
+ *
+ * Engines use this to find the zone a zone append is meant for.
+ */
+uint64_t zbd_zone_start(const struct fio_file *f, uint64_t offset)
+{
+	return get_zone(f, zbd_zone_idx(f, offset))->start;
+}
+
 /**
  * zbd_do_io_u_trim - If reset zone is applicable, do reset zone instead of trim
  *
@@ -2039,6 +2300,13 @@ int zbd_do_io_u_trim(const struct thread_data *td, struct io_u *io_u)
 		return -EINVAL;
 	}
 
+	/* The owner writes to it without the zone lock, leave it be */
+	if (zbd_zone_owned_by_other(td, z)) {
+		dprint(FD_ZBD, "%s: not resetting owned zone %u\n",
+		       f->file_name, zone_idx);
+		return io_u_completed;
+	}
+
 	ret = zbd_reset_zone((struct thread_data *)td, f, z);
 	if (ret < 0)
 		return ret;
@@ -26,7 +26,10 @@ enum io_u_action {
  * @wp: zone write pointer location (bytes)
  * @capacity: maximum size usable from the start of a zone (bytes)
  * @verify_block: number of blocks that have been verified for this zone
- * @mutex: protects the modifiable members in this structure
+ * @owner: thread number of the job that has this zone to itself, zero if
+ *		none. See also exclusive_zones.
+ * @mutex: protects the modifiable members in this structure, except for the
+ *		write pointer of a zone that is owned by a job
  * @type: zone type (BLK_ZONE_TYPE_*)
  * @cond: zone state (BLK_ZONE_COND_*)
  * @has_wp: whether or not this zone can have a valid write pointer
@@ -40,6 +43,7 @@ struct fio_zone_info {
 	uint64_t		wp;
 	uint64_t		capacity;
 	uint32_t		verify_block;
+	uint32_t		owner;
 	enum zbd_zone_type	type:2;
 	enum zbd_zone_cond	cond:4;
 	unsigned int		has_wp:1;
@@ -56,9 +60,10 @@ struct fio_zone_info {
  * @mutex: Protects the modifiable members in this structure (refcount and
  *		num_open_zones).
  * @zone_size: size of a single zone in bytes.
- * @sectors_with_data: total size of data in all zones in units of 512 bytes
+ * @sectors_with_data: total size of data in all zones in units of 512 bytes,
+ *			updated atomically
  * @wp_sectors_with_data: total size of data in zones with write pointers in
- *                        units of 512 bytes
+ *                        units of 512 bytes, updated atomically
  * @zone_size_log2: log2 of the zone size in bytes if it is a power of 2 or 0
  *		if the zone size is not a power of 2.
  * @nr_zones: number of zones
@@ -93,6 +98,7 @@ int zbd_init_files(struct thread_data *td);
 void zbd_recalc_options_with_zone_granularity(struct thread_data *td);
 int zbd_setup_files(struct thread_data *td);
 void zbd_free_zone_info(struct fio_file *f);
+void zbd_release_zones(const struct thread_data *td, struct fio_file *f);
 void zbd_file_reset(struct thread_data *td, struct fio_file *f);
 bool zbd_unaligned_write(int error_code);
 void setup_zbd_zone_mode(struct thread_data *td, struct io_u *io_u);
@@ -101,11 +107,14 @@ enum fio_ddir zbd_adjust_ddir(struct thread_data *td, struct io_u *io_u,
 enum io_u_action zbd_adjust_block(struct thread_data *td, struct io_u *io_u);
 char *zbd_write_status(const struct thread_stat *ts);
 int zbd_do_io_u_trim(const struct thread_data *td, struct io_u *io_u);
+uint64_t zbd_zone_start(const struct fio_file *f, uint64_t offset);
 
-static inline void zbd_close_file(struct fio_file *f)
+static inline void zbd_close_file(struct thread_data *td, struct fio_file *f)
 {
-	if (f->zbd_info)
+	if (f->zbd_info) {
+		zbd_release_zones(td, f);
 		zbd_free_zone_info(f);
+	}
 }
 
 static inline void zbd_queue_io_u(struct thread_data *td, struct io_u *io_u,